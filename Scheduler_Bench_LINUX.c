@@ -0,0 +1,522 @@
+// Scheduler_Bench_LINUX.c
+// Micro-benchmark for scheduler decision throughput (Linux).
+// Measures ns per scheduling decision and peak RSS for every policy in
+// Scheduler_LINUX.c (engine and O(n^2) reference variants) across n = 10 .. max-n.
+// Each (policy, n) point runs in a forked child so peak RSS is per point.
+//
+// Compile: gcc -O2 -pthread Scheduler_Bench_LINUX.c -o sched_bench -lm
+// Run:     ./sched_bench [--max-n=N] [--reps=R] [--warmup=W] [--quadratic-max=N]
+//                        [--out=FILE] [--baseline=FILE] [--threshold=PCT]
+//                        [--timer-events=N] [--timer-pending=P]
+//
+// After the policy sweep, the timer queues behind the event-driven
+// engines (hierarchical timing wheel vs binary heap) run a hold-model
+// trace of --timer-events events (default 10M, 0 skips): --timer-pending
+// timers stay armed, each fired timer is re-armed a random 1..1024 units
+// ahead and one event in ten cancels and re-arms a random timer instead.
+//
+// Results are written as CSV (default bench_results.csv). Passing a previous
+// results file as --baseline flags any point whose mean is slower than the
+// baseline by more than --threshold percent once both 95% confidence
+// intervals are taken into account; the exit status is then 2.
+
+#define SCHEDULER_NO_MAIN
+#include "Scheduler_LINUX.c"
+
+#include <math.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+typedef Metrics (*NonPreemptiveFn)(Process[], int, ExecutionEvent[], int*);
+typedef Metrics (*QuantumFn)(Process[], int, int, ExecutionEvent[], int*);
+
+enum { TIMERS_NONE, TIMERS_WHEEL, TIMERS_HEAP };
+
+typedef struct {
+    const char *policy;
+    const char *variant;
+    NonPreemptiveFn run;
+    QuantumFn run_q;
+    int quadratic;   // O(n^2) reference: capped at --quadratic-max
+    int timers;      // timer-queue trace instead of a policy; n = events
+} BenchPolicy;
+
+static const BenchPolicy POLICIES[] = {
+    {"fcfs",        "reference", fcfs_reference,                NULL,                           1, TIMERS_NONE},
+    {"fcfs",        "engine",    fcfs,                          NULL,                           0, TIMERS_NONE},
+    {"sjf",         "reference", sjf_reference,                 NULL,                           1, TIMERS_NONE},
+    {"sjf",         "engine",    sjf,                           NULL,                           0, TIMERS_NONE},
+    {"priority",    "reference", priority_scheduling_reference, NULL,                           1, TIMERS_NONE},
+    {"priority",    "engine",    priority_scheduling,           NULL,                           0, TIMERS_NONE},
+    {"rr",          "reference", NULL,                          round_robin_reference,          1, TIMERS_NONE},
+    {"rr",          "engine",    NULL,                          round_robin_heap,               0, TIMERS_NONE},
+    {"rr",          "wheel",     NULL,                          round_robin,                    0, TIMERS_NONE},
+    {"priority_rr", "reference", NULL,                          priority_round_robin_reference, 1, TIMERS_NONE},
+    {"priority_rr", "engine",    NULL,                          priority_round_robin_heap,      0, TIMERS_NONE},
+    {"priority_rr", "wheel",     NULL,                          priority_round_robin,           0, TIMERS_NONE},
+    {"timers",      "wheel",     NULL,                          NULL,                           0, TIMERS_WHEEL},
+    {"timers",      "heap",      NULL,                          NULL,                           0, TIMERS_HEAP},
+};
+#define N_POLICIES ((int)(sizeof(POLICIES) / sizeof(POLICIES[0])))
+
+typedef struct {
+    long long decisions;
+    double mean_ns;        // ns per decision
+    double ci95_ns;
+    double min_ns;
+    double max_ns;
+    long peak_rss_kb;
+} BenchResult;
+
+static int g_reps = 5;
+static int g_warmup = 1;
+static int g_quantum = 4;
+static long g_max_n = 1000000;
+static long g_quadratic_max = 10000;
+static double g_threshold_pct = 10.0;
+static long g_timer_events = 10000000;
+static int g_timer_pending = 65536;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Banking-like synthetic workload: load slightly above 1 so the ready
+// queue keeps growing, which is where selection cost shows up.
+static void generate_workload(Process *p, int n, unsigned long long seed) {
+    static const char *names[] = {"Transfer", "Inquiry", "Fraud", "Payment", "Logging"};
+    unsigned long long s = seed ? seed : 1;
+    int arrival = 0;
+    for (int i = 0; i < n; i++) {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        memset(&p[i], 0, sizeof(Process));
+        p[i].pid = i + 1;
+        strcpy(p[i].name, names[s % 5]);
+        p[i].arrival_time = arrival;
+        p[i].burst_time = 1 + (int)((s >> 8) % 20);
+        p[i].priority = 1 + (int)((s >> 16) % 5);
+        p[i].remaining_time = p[i].burst_time;
+        p[i].first_run = -1;
+        arrival += (int)((s >> 24) % 21);
+    }
+}
+
+// Two-sided Student t quantile for 95% confidence, df = 1..30.
+static double t95(int df) {
+    static const double t[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    if (df < 1) return 0.0;
+    return df <= 30 ? t[df - 1] : 1.96;
+}
+
+// ------------------------------------------------------------
+// Timer queues
+// Binary min-heap keyed by (expiry, insertion order) with a position
+// index for O(log n) cancel: the structure the timing wheel replaces.
+// Timer ids are the hold model's slots, each armed exactly once.
+// ------------------------------------------------------------
+typedef struct {
+    int *heap;        // slot ids
+    int *pos;         // slot -> heap index, -1 when not armed
+    long long *key;   // (expiry << 32) | insertion order
+    int size;
+    unsigned seq;
+} TimerHeap;
+
+static void th_swap(TimerHeap *h, int a, int b) {
+    int t = h->heap[a];
+    h->heap[a] = h->heap[b];
+    h->heap[b] = t;
+    h->pos[h->heap[a]] = a;
+    h->pos[h->heap[b]] = b;
+}
+
+static void th_up(TimerHeap *h, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (h->key[h->heap[parent]] <= h->key[h->heap[i]]) break;
+        th_swap(h, i, parent);
+        i = parent;
+    }
+}
+
+static void th_down(TimerHeap *h, int i) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < h->size && h->key[h->heap[l]] < h->key[h->heap[m]]) m = l;
+        if (r < h->size && h->key[h->heap[r]] < h->key[h->heap[m]]) m = r;
+        if (m == i) return;
+        th_swap(h, i, m);
+        i = m;
+    }
+}
+
+static void th_add(TimerHeap *h, int id, int expires) {
+    h->key[id] = ((long long)expires << 32) | h->seq++;
+    h->heap[h->size] = id;
+    h->pos[id] = h->size++;
+    th_up(h, h->size - 1);
+}
+
+static void th_cancel(TimerHeap *h, int id) {
+    int i = h->pos[id];
+    h->pos[id] = -1;
+    if (--h->size == i) return;
+    int moved = h->heap[h->size];
+    h->heap[i] = moved;
+    h->pos[moved] = i;
+    th_up(h, i);
+    if (h->pos[moved] == i) th_down(h, i);
+}
+
+static int th_pop(TimerHeap *h, int *when) {
+    int id = h->heap[0];
+    *when = (int)(h->key[id] >> 32);
+    h->pos[id] = -1;
+    h->heap[0] = h->heap[--h->size];
+    if (h->size > 0) {
+        h->pos[h->heap[0]] = 0;
+        th_down(h, 0);
+    }
+    return id;
+}
+
+// One hold-model run of `events` timer events; returns elapsed ns.
+static long long timer_trace(int kind, long events, const int *step, const int *victim) {
+    int pending = g_timer_pending;
+    TimerWheel w;
+    TimerHeap h;
+    int *ids = (int*)xcalloc((size_t)pending, sizeof(int), "calloc(timers)");
+    if (kind == TIMERS_WHEEL) {
+        tw_init(&w, pending);
+    } else {
+        memset(&h, 0, sizeof(h));
+        h.heap = (int*)xcalloc((size_t)pending, sizeof(int), "calloc(timers)");
+        h.pos = (int*)xcalloc((size_t)pending, sizeof(int), "calloc(timers)");
+        h.key = (long long*)xcalloc((size_t)pending, sizeof(long long), "calloc(timers)");
+    }
+
+    long long t0 = now_ns();
+    for (int j = 0; j < pending; j++) {
+        if (kind == TIMERS_WHEEL) ids[j] = tw_add(&w, step[j], j);
+        else th_add(&h, j, step[j]);
+    }
+    int now = 0;
+    long k = 0;
+    while (k < events) {
+        if (victim[k] >= 0) {
+            int j = victim[k];
+            if (kind == TIMERS_WHEEL) {
+                tw_cancel(&w, ids[j]);
+                ids[j] = tw_add(&w, now + step[k], j);
+            } else {
+                th_cancel(&h, j);
+                th_add(&h, j, now + step[k]);
+            }
+            k++;
+            continue;
+        }
+        if (kind == TIMERS_WHEEL) {
+            int head = tw_pop_earliest(&w, &now);
+            for (int id = head, after; id >= 0 && k < events; id = after) {
+                after = w.next[id];
+                int j = w.payload[id];
+                tw_release(&w, id);
+                ids[j] = tw_add(&w, now + step[k++], j);
+            }
+        } else {
+            int j = th_pop(&h, &now);
+            th_add(&h, j, now + step[k++]);
+        }
+    }
+    long long t1 = now_ns();
+
+    if (kind == TIMERS_WHEEL) {
+        tw_free(&w);
+    } else {
+        free(h.heap);
+        free(h.pos);
+        free(h.key);
+    }
+    free(ids);
+    return t1 - t0;
+}
+
+static void run_once(const BenchPolicy *bp, Process *work, int n) {
+    int event_count = 0;
+    if (bp->run) bp->run(work, n, NULL, &event_count);
+    else bp->run_q(work, n, g_quantum, NULL, &event_count);
+}
+
+// Times one policy on the synthetic workload; samples are ns per decision.
+static void bench_policy(const BenchPolicy *bp, int n, BenchResult *r, double *samples) {
+    Process *original = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(original)");
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(work)");
+    generate_workload(original, n, 0x9E3779B97F4A7C15ULL ^ (unsigned long long)n);
+
+    for (int w = 0; w < g_warmup; w++) {
+        memcpy(work, original, (size_t)n * sizeof(Process));
+        run_once(bp, work, n);
+    }
+
+    for (int rep = 0; rep < g_reps; rep++) {
+        memcpy(work, original, (size_t)n * sizeof(Process));
+        long long t0 = now_ns();
+        run_once(bp, work, n);
+        long long t1 = now_ns();
+
+        // Merged Gantt runs hide RR re-dispatches; count the pushes.
+        long long decisions = g_gantt.dispatches;
+        r->decisions = decisions;
+        samples[rep] = (double)(t1 - t0) / (double)(decisions ? decisions : 1);
+    }
+
+    free(work);
+    free(original);
+}
+
+static void bench_child(const BenchPolicy *bp, int n, int fd) {
+    BenchResult r;
+    memset(&r, 0, sizeof(r));
+    double *samples = (double*)xcalloc((size_t)g_reps, sizeof(double), "calloc(samples)");
+
+    if (bp->timers) {
+        // Both queues replay the same trace: re-arm distances and cancels.
+        long len = n > g_timer_pending ? n : g_timer_pending;
+        int *step = (int*)xcalloc((size_t)len, sizeof(int), "calloc(trace)");
+        int *victim = (int*)xcalloc((size_t)n, sizeof(int), "calloc(trace)");
+        Rng rng;
+        rng_stream(&rng, 0x7157ULL, 0);
+        for (long k = 0; k < len; k++) step[k] = 1 + (int)rng_below(&rng, 1024);
+        for (long k = 0; k < n; k++) {
+            victim[k] = rng_below(&rng, 10) == 0 ? (int)rng_below(&rng, (uint64_t)g_timer_pending) : -1;
+        }
+        for (int w = 0; w < g_warmup; w++) timer_trace(bp->timers, n, step, victim);
+        for (int rep = 0; rep < g_reps; rep++) {
+            samples[rep] = (double)timer_trace(bp->timers, n, step, victim) / (double)n;
+        }
+        r.decisions = n;
+        free(victim);
+        free(step);
+    } else {
+        bench_policy(bp, n, &r, samples);
+    }
+
+    double sum = 0.0;
+    r.min_ns = samples[0];
+    r.max_ns = samples[0];
+    for (int i = 0; i < g_reps; i++) {
+        sum += samples[i];
+        if (samples[i] < r.min_ns) r.min_ns = samples[i];
+        if (samples[i] > r.max_ns) r.max_ns = samples[i];
+    }
+    r.mean_ns = sum / g_reps;
+    double var = 0.0;
+    for (int i = 0; i < g_reps; i++) {
+        var += (samples[i] - r.mean_ns) * (samples[i] - r.mean_ns);
+    }
+    if (g_reps > 1) {
+        var /= (g_reps - 1);
+        r.ci95_ns = t95(g_reps - 1) * sqrt(var) / sqrt((double)g_reps);
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    r.peak_rss_kb = ru.ru_maxrss;
+
+    if (write(fd, &r, sizeof(r)) != (ssize_t)sizeof(r)) _exit(1);
+    _exit(0);
+}
+
+static int bench_point(const BenchPolicy *bp, int n, BenchResult *out) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        return -1;
+    }
+    fflush(stdout);
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return -1;
+    }
+    if (child == 0) {
+        close(fds[0]);
+        bench_child(bp, n, fds[1]);
+    }
+    close(fds[1]);
+    ssize_t got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    if (got != (ssize_t)sizeof(*out) || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "benchmark child failed: %s/%s n=%d\n", bp->policy, bp->variant, n);
+        return -1;
+    }
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Baseline comparison
+// ------------------------------------------------------------
+typedef struct {
+    char policy[32];
+    char variant[32];
+    long n;
+    double mean_ns;
+    double ci95_ns;
+} BaselineRow;
+
+static BaselineRow *g_baseline = NULL;
+static int g_baseline_count = 0;
+
+static int load_baseline(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    char line[512];
+    int cap = 0;
+    while (fgets(line, sizeof(line), f)) {
+        BaselineRow row;
+        long long decisions;
+        if (sscanf(line, "%31[^,],%31[^,],%ld,%*d,%lld,%lf,%lf",
+                   row.policy, row.variant, &row.n, &decisions,
+                   &row.mean_ns, &row.ci95_ns) != 6) {
+            continue;   // header or malformed line
+        }
+        if (g_baseline_count == cap) {
+            cap = cap ? cap * 2 : 64;
+            BaselineRow *grown = (BaselineRow*)realloc(g_baseline, (size_t)cap * sizeof(BaselineRow));
+            if (!grown) {
+                perror("realloc(baseline)");
+                fclose(f);
+                return -1;
+            }
+            g_baseline = grown;
+        }
+        g_baseline[g_baseline_count++] = row;
+    }
+    fclose(f);
+    return 0;
+}
+
+static const BaselineRow* find_baseline(const char *policy, const char *variant, long n) {
+    for (int i = 0; i < g_baseline_count; i++) {
+        if (g_baseline[i].n == n &&
+            strcmp(g_baseline[i].policy, policy) == 0 &&
+            strcmp(g_baseline[i].variant, variant) == 0) {
+            return &g_baseline[i];
+        }
+    }
+    return NULL;
+}
+
+// Measures one point, prints and records it; returns 1 on a regression.
+static int run_point(const BenchPolicy *bp, long n, FILE *out, int check_baseline) {
+    BenchResult r;
+    if (bench_point(bp, (int)n, &r) != 0) return 0;
+
+    printf("%-12s %-10s %10ld %12lld %14.2f %10.2f %12ld\n",
+           bp->policy, bp->variant, n, r.decisions, r.mean_ns, r.ci95_ns, r.peak_rss_kb);
+    fprintf(out, "%s,%s,%ld,%d,%lld,%.3f,%.3f,%.3f,%.3f,%ld\n",
+            bp->policy, bp->variant, n, g_reps, r.decisions,
+            r.mean_ns, r.ci95_ns, r.min_ns, r.max_ns, r.peak_rss_kb);
+    fflush(out);
+
+    const BaselineRow *base = check_baseline ? find_baseline(bp->policy, bp->variant, n) : NULL;
+    if (base) {
+        double limit = (base->mean_ns + base->ci95_ns) * (1.0 + g_threshold_pct / 100.0);
+        if (r.mean_ns - r.ci95_ns > limit) {
+            printf("  REGRESSION: %.2f ns/decision vs baseline %.2f (+/-%.2f)\n",
+                   r.mean_ns, base->mean_ns, base->ci95_ns);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--max-n=N] [--reps=R] [--warmup=W] [--quantum=Q]\n"
+            "          [--quadratic-max=N] [--out=FILE] [--baseline=FILE] [--threshold=PCT]\n"
+            "          [--timer-events=N] [--timer-pending=P]\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *out_path = "bench_results.csv";
+    const char *baseline_path = NULL;
+
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--max-n=", 8) == 0) g_max_n = atol(argv[a] + 8);
+        else if (strncmp(argv[a], "--reps=", 7) == 0) g_reps = atoi(argv[a] + 7);
+        else if (strncmp(argv[a], "--warmup=", 9) == 0) g_warmup = atoi(argv[a] + 9);
+        else if (strncmp(argv[a], "--quantum=", 10) == 0) g_quantum = atoi(argv[a] + 10);
+        else if (strncmp(argv[a], "--quadratic-max=", 16) == 0) g_quadratic_max = atol(argv[a] + 16);
+        else if (strncmp(argv[a], "--out=", 6) == 0) out_path = argv[a] + 6;
+        else if (strncmp(argv[a], "--baseline=", 11) == 0) baseline_path = argv[a] + 11;
+        else if (strncmp(argv[a], "--threshold=", 12) == 0) g_threshold_pct = atof(argv[a] + 12);
+        else if (strncmp(argv[a], "--timer-events=", 15) == 0) g_timer_events = atol(argv[a] + 15);
+        else if (strncmp(argv[a], "--timer-pending=", 16) == 0) g_timer_pending = atoi(argv[a] + 16);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (g_reps < 1 || g_warmup < 0 || g_quantum < 1 || g_max_n < 10 || g_max_n > INT_MAX
+        || g_timer_events < 0 || g_timer_events > INT_MAX || g_timer_pending < 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (baseline_path && load_baseline(baseline_path) != 0) return 1;
+
+    g_simulate_work = 0;
+    rng_stream(&g_rng, g_seed, 0);
+    g_show_gantt = 0;
+
+    FILE *out = fopen(out_path, "w");
+    if (!out) {
+        perror(out_path);
+        return 1;
+    }
+    fprintf(out, "policy,variant,n,reps,decisions,mean_ns_per_decision,ci95_ns,min_ns,max_ns,peak_rss_kb\n");
+
+    printf("=====================================================\n");
+    printf(" Scheduler Decision Throughput Benchmark\n");
+    printf(" reps=%d warmup=%d quantum=%d max-n=%ld\n", g_reps, g_warmup, g_quantum, g_max_n);
+    printf("=====================================================\n");
+    printf("%-12s %-10s %10s %12s %14s %10s %12s\n",
+           "Policy", "Variant", "n", "decisions", "ns/decision", "+/-95%", "peak RSS KB");
+
+    int regressions = 0;
+    for (long n = 10; n <= g_max_n; n *= 10) {
+        for (int p = 0; p < N_POLICIES; p++) {
+            const BenchPolicy *bp = &POLICIES[p];
+            if (bp->timers || (bp->quadratic && n > g_quadratic_max)) continue;
+            regressions += run_point(bp, n, out, baseline_path != NULL);
+        }
+    }
+    if (g_timer_events > 0) {
+        printf("-- timer queues: hold model, %d pending (ns/event) --\n", g_timer_pending);
+        for (int p = 0; p < N_POLICIES; p++) {
+            if (POLICIES[p].timers) regressions += run_point(&POLICIES[p], g_timer_events, out, baseline_path != NULL);
+        }
+    }
+    fclose(out);
+
+    printf("-----------------------------------------------------\n");
+    printf("Results written to %s\n", out_path);
+    if (baseline_path) {
+        printf("Baseline %s: %d regression(s) beyond %.1f%%\n",
+               baseline_path, regressions, g_threshold_pct);
+    }
+    free(g_baseline);
+    return regressions ? 2 : 0;
+}
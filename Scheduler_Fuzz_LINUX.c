@@ -0,0 +1,446 @@
+// Scheduler_Fuzz_LINUX.c
+// Differential fuzzer for the scheduling engines (Linux).
+// Every optimized policy in Scheduler_LINUX.c (heap engine, timing-wheel
+// round robin and the lock-step engines) runs against its O(n^2)
+// reference on the same process set. The first difference in the Gantt
+// chart, in any task's completion, turnaround, waiting or response
+// time, or in the averages and context-switch count aborts with the
+// failing case printed. The standalone driver also checks the trace
+// renderer's column pick on fixed cases first.
+//
+// Standalone: gcc -O2 -pthread Scheduler_Fuzz_LINUX.c -o sched_fuzz -lm
+//             ./sched_fuzz [--iterations=N] [--seed=S] [--max-n=N] [--quiet]
+//             ./sched_fuzz --replay=FILE
+//             ./sched_fuzz --perf=INPUTS [--perf-n=N] [--seed=S]
+// libFuzzer:  clang -g -O1 -fsanitize=fuzzer,address -DSCHEDULER_LIBFUZZER
+//                   -pthread Scheduler_Fuzz_LINUX.c -o sched_fuzz
+//             ./sched_fuzz [CORPUS_DIR]
+//
+// Both modes decode raw bytes with fuzz_decode(). The standalone driver
+// draws them from stream 0 of --seed, so a failing iteration replays
+// with the same seed; --replay=FILE runs one libFuzzer crash file.
+//
+// --perf=INPUTS decodes that many inputs of --perf-n tasks each, times
+// the reference and every optimized variant on the same inputs (still
+// checking them) and prints the totals and speed-ups.
+
+#define SCHEDULER_NO_MAIN
+#include "Scheduler_LINUX.c"
+
+typedef Metrics (*NonPreemptiveFn)(Process[], int, ExecutionEvent[], int*);
+typedef Metrics (*QuantumFn)(Process[], int, int, ExecutionEvent[], int*);
+
+#define FUZZ_MAX_N 4096   // libFuzzer inputs beyond this many tasks are cut
+#define FUZZ_VARIANTS 2
+
+typedef struct {
+    const char *variant;
+    NonPreemptiveFn run;
+    QuantumFn run_q;
+} FuzzVariant;
+
+typedef struct {
+    const char *policy;
+    PolicyId id;
+    FuzzVariant reference;
+    FuzzVariant opt[FUZZ_VARIANTS];
+} FuzzPolicy;
+
+static const FuzzPolicy POLICIES[POLICY_COUNT] = {
+    {"fcfs",        POLICY_FCFS,
+     {"reference", fcfs_reference, NULL},
+     {{"engine", fcfs, NULL}, {NULL, NULL, NULL}}},
+    {"sjf",         POLICY_SJF,
+     {"reference", sjf_reference, NULL},
+     {{"engine", sjf, NULL}, {NULL, NULL, NULL}}},
+    {"priority",    POLICY_PRIORITY,
+     {"reference", priority_scheduling_reference, NULL},
+     {{"engine", priority_scheduling, NULL}, {NULL, NULL, NULL}}},
+    {"rr",          POLICY_RR,
+     {"reference", NULL, round_robin_reference},
+     {{"engine", NULL, round_robin_heap}, {"wheel", NULL, round_robin}}},
+    {"priority_rr", POLICY_PRIORITY_RR,
+     {"reference", NULL, priority_round_robin_reference},
+     {{"engine", NULL, priority_round_robin_heap}, {"wheel", NULL, priority_round_robin}}}
+};
+
+// One run's observable results: tasks indexed by pid - 1 (the FCFS
+// reference sorts processes[] in place) and the merged Gantt chart.
+typedef struct {
+    Process *task;
+    int *gantt_pid;
+    int *gantt_time;
+    int gantt_size;
+    int gantt_cap;
+    Metrics m;
+} FuzzRun;
+
+typedef struct {
+    Process *original;
+    Process *work;
+    int n;
+    int quantum;
+    FuzzRun ref;
+    FuzzRun got;
+    long long ns[POLICY_COUNT][1 + FUZZ_VARIANTS + 1];   // reference, variants, lock-step
+} FuzzState;
+
+static int g_lockstep_threads = 1;
+static long long g_comparisons = 0;
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void fuzz_state_init(FuzzState *s, int max_n) {
+    memset(s, 0, sizeof(*s));
+    s->original = (Process*)xcalloc((size_t)max_n, sizeof(Process), "calloc(fuzz)");
+    s->work = (Process*)xcalloc((size_t)max_n, sizeof(Process), "calloc(fuzz)");
+    s->ref.task = (Process*)xcalloc((size_t)max_n, sizeof(Process), "calloc(fuzz)");
+    s->got.task = (Process*)xcalloc((size_t)max_n, sizeof(Process), "calloc(fuzz)");
+}
+
+// Byte 0 picks the quantum (1..8). Byte 1 picks the shape: the largest
+// arrival gap (0, 2, 8 or 64), the largest burst (4, 16, 64 or 512) and
+// the number of priority levels (1, 2, 4 or 16). Each task then takes
+// three bytes: gap since the previous arrival, burst and priority. The
+// ranges are small so that ties, the interesting case, are common.
+// Arrivals are sorted, as in every workload main builds; the
+// references admit newly arrived tasks in index order, which only
+// agrees with arrival order on sorted input. Returns the task count.
+static int fuzz_decode(const uint8_t *data, size_t size, Process *p, int max_n, int *quantum) {
+    static const int GAPS[4] = {0, 2, 8, 64};
+    static const int BURSTS[4] = {4, 16, 64, 512};
+    static const int LEVELS[4] = {1, 2, 4, 16};
+    static const char *NAMES[5] = {"Transfer", "Inquiry", "Fraud", "Payment", "Logging"};
+    if (size < 5) return 0;
+    *quantum = 1 + data[0] % 8;
+    int gap = GAPS[data[1] & 3];
+    int burst = BURSTS[(data[1] >> 2) & 3];
+    int levels = LEVELS[(data[1] >> 4) & 3];
+    size_t avail = (size - 2) / 3;
+    int n = avail < (size_t)max_n ? (int)avail : max_n;
+    int arrival = 0;
+    for (int i = 0; i < n; i++) {
+        const uint8_t *b = data + 2 + 3 * (size_t)i;
+        // Two bytes per burst so the 512 shape reaches its whole range.
+        int raw_burst = (b[1] << 8 | b[2]) >> 4;
+        memset(&p[i], 0, sizeof(Process));
+        p[i].pid = i + 1;
+        strcpy(p[i].name, NAMES[i % 5]);
+        arrival += b[0] % (gap + 1);
+        p[i].arrival_time = arrival;
+        p[i].burst_time = 1 + raw_burst % burst;
+        p[i].priority = 1 + b[2] % levels;
+        p[i].remaining_time = p[i].burst_time;
+        p[i].first_run = -1;
+    }
+    return n;
+}
+
+static void fuzz_run(FuzzState *s, const FuzzVariant *v, FuzzRun *out) {
+    memcpy(s->work, s->original, (size_t)s->n * sizeof(Process));
+    int event_count = 0;
+    rng_stream(&g_rng, g_seed, 1);
+    out->m = v->run ? v->run(s->work, s->n, NULL, &event_count)
+                    : v->run_q(s->work, s->n, s->quantum, NULL, &event_count);
+    for (int i = 0; i < s->n; i++) out->task[s->work[i].pid - 1] = s->work[i];
+    if (out->gantt_cap < g_gantt.size) {
+        out->gantt_cap = g_gantt.size;
+        free(out->gantt_pid);
+        free(out->gantt_time);
+        out->gantt_pid = (int*)xcalloc((size_t)out->gantt_cap, sizeof(int), "calloc(fuzz)");
+        out->gantt_time = (int*)xcalloc((size_t)out->gantt_cap, sizeof(int), "calloc(fuzz)");
+    }
+    memcpy(out->gantt_pid, g_gantt.pid, (size_t)g_gantt.size * sizeof(int));
+    memcpy(out->gantt_time, g_gantt.time, (size_t)g_gantt.size * sizeof(int));
+    out->gantt_size = g_gantt.size;
+}
+
+// Prints the case in the repo's workload terms and aborts, which is
+// also how libFuzzer learns to keep the input.
+static void fuzz_fail(const FuzzState *s, const char *policy, const char *variant, const char *what) {
+    fprintf(stderr, "MISMATCH %s/%s vs reference: %s\n", policy, variant, what);
+    fprintf(stderr, "quantum %d, %d tasks (pid arrival burst priority):\n", s->quantum, s->n);
+    for (int i = 0; i < s->n; i++) {
+        fprintf(stderr, "  %d %d %d %d\n", s->original[i].pid, s->original[i].arrival_time,
+                s->original[i].burst_time, s->original[i].priority);
+    }
+    abort();
+}
+
+static void fuzz_check_metrics(const FuzzState *s, const char *policy, const char *variant,
+                               const Metrics *want, const Metrics *got) {
+    char what[160];
+    if (got->avg_waiting_time != want->avg_waiting_time
+        || got->avg_turnaround_time != want->avg_turnaround_time
+        || got->context_switches != want->context_switches) {
+        snprintf(what, sizeof(what), "averages wait %.6f/%.6f, turnaround %.6f/%.6f, switches %d/%d",
+                 got->avg_waiting_time, want->avg_waiting_time,
+                 got->avg_turnaround_time, want->avg_turnaround_time,
+                 got->context_switches, want->context_switches);
+        fuzz_fail(s, policy, variant, what);
+    }
+}
+
+static void fuzz_compare(const FuzzState *s, const char *policy, const char *variant) {
+    const FuzzRun *a = &s->ref, *b = &s->got;
+    char what[160];
+    int size = a->gantt_size < b->gantt_size ? a->gantt_size : b->gantt_size;
+    for (int i = 0; i < size; i++) {
+        if (a->gantt_pid[i] != b->gantt_pid[i] || a->gantt_time[i] != b->gantt_time[i]) {
+            snprintf(what, sizeof(what), "Gantt segment %d is P%d to %d, expected P%d to %d",
+                     i, b->gantt_pid[i], b->gantt_time[i], a->gantt_pid[i], a->gantt_time[i]);
+            fuzz_fail(s, policy, variant, what);
+        }
+    }
+    if (a->gantt_size != b->gantt_size) {
+        snprintf(what, sizeof(what), "%d Gantt segments, expected %d", b->gantt_size, a->gantt_size);
+        fuzz_fail(s, policy, variant, what);
+    }
+    for (int i = 0; i < s->n; i++) {
+        const Process *x = &a->task[i], *y = &b->task[i];
+        if (x->completion_time != y->completion_time || x->turnaround_time != y->turnaround_time
+            || x->waiting_time != y->waiting_time || x->response_time != y->response_time) {
+            snprintf(what, sizeof(what),
+                     "P%d completion %d/%d, turnaround %d/%d, waiting %d/%d, response %d/%d",
+                     i + 1, y->completion_time, x->completion_time, y->turnaround_time,
+                     x->turnaround_time, y->waiting_time, x->waiting_time,
+                     y->response_time, x->response_time);
+            fuzz_fail(s, policy, variant, what);
+        }
+    }
+    fuzz_check_metrics(s, policy, variant, &a->m, &b->m);
+    g_comparisons++;
+}
+
+// Runs every policy's reference and optimized variants on s->original,
+// adding the time each took to s->ns; aborts on the first difference.
+static void fuzz_check(FuzzState *s) {
+    Metrics want[POLICY_COUNT];
+    int makespan[POLICY_COUNT];
+    PolicyId ids[POLICY_COUNT];
+    for (int k = 0; k < POLICY_COUNT; k++) {
+        const FuzzPolicy *fp = &POLICIES[k];
+        long long t0 = now_ns();
+        fuzz_run(s, &fp->reference, &s->ref);
+        s->ns[k][0] += now_ns() - t0;
+        want[k] = s->ref.m;
+        makespan[k] = s->ref.gantt_size ? s->ref.gantt_time[s->ref.gantt_size - 1] : 0;
+        ids[k] = fp->id;
+        for (int v = 0; v < FUZZ_VARIANTS && fp->opt[v].variant; v++) {
+            t0 = now_ns();
+            fuzz_run(s, &fp->opt[v], &s->got);
+            s->ns[k][1 + v] += now_ns() - t0;
+            fuzz_compare(s, fp->policy, fp->opt[v].variant);
+        }
+    }
+    // The lock-step engines report metrics and makespans only. They
+    // ignore the quantum for non-sliced policies, like main's stages.
+    Metrics got[POLICY_COUNT];
+    int got_makespan[POLICY_COUNT];
+    long long t0 = now_ns();
+    lockstep_schedule(s->original, s->n, ids, POLICY_COUNT, s->quantum, g_lockstep_threads,
+                      got, got_makespan);
+    long long spent = now_ns() - t0;
+    for (int k = 0; k < POLICY_COUNT; k++) {
+        s->ns[k][1 + FUZZ_VARIANTS] += spent / POLICY_COUNT;
+        fuzz_check_metrics(s, POLICIES[k].policy, "lockstep", &want[k], &got[k]);
+        if (got_makespan[k] != makespan[k]) {
+            char what[64];
+            snprintf(what, sizeof(what), "makespan %d, expected %d", got_makespan[k], makespan[k]);
+            fuzz_fail(s, POLICIES[k].policy, "lockstep", what);
+        }
+        g_comparisons++;
+    }
+}
+
+static FuzzState g_fuzz;
+static int g_fuzz_ready = 0;
+
+static void fuzz_setup(void) {
+    if (g_fuzz_ready) return;
+    g_simulate_work = 0;
+    g_show_gantt = 0;
+    fuzz_state_init(&g_fuzz, FUZZ_MAX_N);
+    g_fuzz_ready = 1;
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    fuzz_setup();
+    g_fuzz.n = fuzz_decode(data, size, g_fuzz.original, FUZZ_MAX_N, &g_fuzz.quantum);
+    if (g_fuzz.n > 0) fuzz_check(&g_fuzz);
+    return 0;
+}
+
+#ifndef SCHEDULER_LIBFUZZER
+static void fuzz_state_free(FuzzState *s) {
+    free(s->original);
+    free(s->work);
+    free(s->ref.task);
+    free(s->got.task);
+    free(s->ref.gantt_pid);
+    free(s->ref.gantt_time);
+    free(s->got.gantt_pid);
+    free(s->got.gantt_time);
+}
+
+// Fixed cases for the trace renderer's column pick, run before the
+// random inputs. The first column is round robin in 4-unit slices
+// around a 9-unit idle gap: busy for 31 of 40 units, so it must show a
+// task even though the gap is its longest piece. The second is busy for
+// 8 of 40 and must show idle.
+static void fuzz_check_render(void) {
+    static const int end[] = {4, 8, 17, 21, 25, 29, 33, 37, 40, 44, 70, 74, 80};
+    static const int pid[] = {1, 2, -1, 1, 2, 1, 2, 1, 2, 1, -1, 2, -1};
+    const GanttView g = { end, pid, (int)(sizeof(end) / sizeof(end[0])) };
+    int i = 0;
+    long long busy;
+    int got = render_column_pid(&g, &i, 0, 40, &busy);
+    if (got < 0 || busy != 31) {
+        fprintf(stderr, "render: busy column [0, 40) drawn as P%d with busy %lld, want a task and 31\n",
+                got, busy);
+        abort();
+    }
+    got = render_column_pid(&g, &i, 40, 80, &busy);
+    if (got != -1 || busy != 8) {
+        fprintf(stderr, "render: idle column [40, 80) drawn as P%d with busy %lld, want idle and 8\n",
+                got, busy);
+        abort();
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--iterations=N] [--seed=S] [--max-n=N] [--quiet]\n"
+            "       %s --replay=FILE\n"
+            "       %s --perf=INPUTS [--perf-n=N] [--seed=S]\n",
+            prog, prog, prog);
+}
+
+static int replay_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    uint8_t *data = NULL;
+    size_t size = 0, cap = 0, got;
+    do {
+        if (size == cap) {
+            cap = cap ? 2 * cap : 4096;
+            data = (uint8_t*)realloc(data, cap);
+            if (!data) {
+                perror("realloc(replay)");
+                exit(1);
+            }
+        }
+        got = fread(data + size, 1, cap - size, f);
+        size += got;
+    } while (got > 0);
+    fclose(f);
+    LLVMFuzzerTestOneInput(data, size);
+    printf("%s: %d tasks, quantum %d: no differences\n", path, g_fuzz.n, g_fuzz.quantum);
+    free(data);
+    return 0;
+}
+
+// Fills data with an input of n tasks from r.
+static size_t fuzz_generate(Rng *r, uint8_t *data, int n) {
+    size_t size = 2 + 3 * (size_t)n;
+    for (size_t i = 0; i < size; i += 8) {
+        uint64_t x = rng_next(r);
+        for (size_t k = i; k < i + 8 && k < size; k++, x >>= 8) data[k] = (uint8_t)x;
+    }
+    return size;
+}
+
+static void report_perf(const FuzzState *s, int inputs, int n) {
+    static const char *SLOT_NAMES[1 + FUZZ_VARIANTS + 1] = {"reference", NULL, NULL, "lockstep"};
+    printf("=====================================================\n");
+    printf(" Reference vs optimized: %d inputs of %d tasks\n", inputs, n);
+    printf("=====================================================\n");
+    printf("%-12s %-10s %14s %12s\n", "Policy", "Variant", "Total (ms)", "Speed-up");
+    for (int k = 0; k < POLICY_COUNT; k++) {
+        double ref = (double)s->ns[k][0];
+        for (int v = 0; v < 1 + FUZZ_VARIANTS + 1; v++) {
+            const char *name = v >= 1 && v <= FUZZ_VARIANTS ? POLICIES[k].opt[v - 1].variant : SLOT_NAMES[v];
+            if (!name) continue;
+            double t = (double)s->ns[k][v];
+            printf("%-12s %-10s %14.2f %11.1fx\n", POLICIES[k].policy, name, t / 1e6,
+                   t > 0.0 ? ref / t : 0.0);
+        }
+    }
+    printf("(lock-step runs all policies in one pass; each row shows an equal share)\n");
+}
+
+int main(int argc, char **argv) {
+    long iterations = 10000;
+    int max_n = 64;
+    int perf_inputs = 0;
+    int perf_n = 5000;
+    int quiet = 0;
+    const char *replay = NULL;
+
+    for (int a = 1; a < argc; a++) {
+        if (strncmp(argv[a], "--iterations=", 13) == 0) iterations = atol(argv[a] + 13);
+        else if (strncmp(argv[a], "--seed=", 7) == 0) g_seed = strtoull(argv[a] + 7, NULL, 0);
+        else if (strncmp(argv[a], "--max-n=", 8) == 0) max_n = atoi(argv[a] + 8);
+        else if (strncmp(argv[a], "--perf=", 7) == 0) perf_inputs = atoi(argv[a] + 7);
+        else if (strncmp(argv[a], "--perf-n=", 9) == 0) perf_n = atoi(argv[a] + 9);
+        else if (strncmp(argv[a], "--replay=", 9) == 0) replay = argv[a] + 9;
+        else if (strcmp(argv[a], "--quiet") == 0) quiet = 1;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations < 0 || max_n < 1 || max_n > FUZZ_MAX_N || perf_inputs < 0
+        || perf_n < 1 || perf_n > FUZZ_MAX_N * 64) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (replay) return replay_file(replay);
+    fuzz_setup();
+    fuzz_check_render();
+
+    Rng r;
+    rng_stream(&r, g_seed, 0);
+    if (perf_inputs > 0) {
+        FuzzState s;
+        fuzz_state_init(&s, perf_n);
+        uint8_t *data = (uint8_t*)xcalloc(2 + 3 * (size_t)perf_n + 8, 1, "calloc(fuzz)");
+        for (int i = 0; i < perf_inputs; i++) {
+            size_t size = fuzz_generate(&r, data, perf_n);
+            s.n = fuzz_decode(data, size, s.original, perf_n, &s.quantum);
+            fuzz_check(&s);
+        }
+        report_perf(&s, perf_inputs, perf_n);
+        free(data);
+        fuzz_state_free(&s);
+        return 0;
+    }
+
+    uint8_t *data = (uint8_t*)xcalloc(2 + 3 * (size_t)max_n + 8, 1, "calloc(fuzz)");
+    long long tasks = 0;
+    long long start = now_ns();
+    for (long it = 0; it < iterations; it++) {
+        // Mostly small sets, where a wrong tie-break shows up at once.
+        int n = 1 + (int)rng_below(&r, 1 + rng_below(&r, (uint64_t)max_n));
+        size_t size = fuzz_generate(&r, data, n);
+        g_lockstep_threads = 1 + (int)(it & 1);
+        LLVMFuzzerTestOneInput(data, size);
+        tasks += g_fuzz.n;
+        if (!quiet && (it + 1) % 1000 == 0) {
+            fprintf(stderr, "iteration %ld: %lld comparisons, no differences\n", it + 1, g_comparisons);
+        }
+    }
+    printf("Seed %llu: %ld inputs, %lld tasks, %lld comparisons in %.2f s: no differences\n",
+           (unsigned long long)g_seed, iterations, tasks, g_comparisons, (now_ns() - start) / 1e9);
+    free(data);
+    fuzz_state_free(&g_fuzz);
+    return 0;
+}
+#endif /* SCHEDULER_LIBFUZZER */
@@ -1,13 +1,27 @@
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
+#include <limits.h>
 
 #ifdef _WIN32
     #include <windows.h>
 #else
     #include <unistd.h>
+    #include <signal.h>
+    #include <stdint.h>
     #include <sys/time.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <sys/epoll.h>
+    #include <sys/wait.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <stdatomic.h>
 #endif
 
 typedef struct {
@@ -24,6 +38,12 @@ typedef struct {
     int first_run;
     long real_time_us;
     long sched_latency_us;
+    int predicted_burst;
+    int working_set_kb;      // cache footprint, for the multi-CPU refill model
+    int io_first;            // CPU/IO burst sequence in a BurstPool, if io_count > 0
+    int io_count;
+    int ready_since;         // when it last joined a ready queue, for aging
+    int mem_mb;              // memory held while running, for DRF and packing
 } Process;
 
 typedef struct {
@@ -51,12 +71,334 @@ void print_execution_log(ExecutionEvent events[], int event_count);
 void print_process_table(Process processes[], int n);
 void print_performance_analysis(Metrics metrics);
 void print_gantt_chart(int gantt[], int gantt_time[], int gantt_size);
+void print_top_k_slowest(Process processes[], int n, int k);
+void print_section(const char *title, int first);
+void report_results(const char *policy, const char *label, int quantum,
+                    Process processes[], int n,
+                    ExecutionEvent events[], int event_count, Metrics metrics);
 
 Metrics fcfs(Process processes[], int n, ExecutionEvent events[], int* event_count);
 Metrics sjf(Process processes[], int n, ExecutionEvent events[], int* event_count);
 Metrics priority_scheduling(Process processes[], int n, ExecutionEvent events[], int* event_count);
 Metrics round_robin(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count);
 Metrics priority_round_robin(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count);
+Metrics round_robin_heap(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count);
+Metrics priority_round_robin_heap(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count);
+Metrics srtf(Process processes[], int n, ExecutionEvent events[], int* event_count);
+Metrics priority_by_burst(Process processes[], int n, ExecutionEvent events[], int* event_count);
+
+Metrics fcfs_reference(Process processes[], int n, ExecutionEvent events[], int* event_count);
+Metrics sjf_reference(Process processes[], int n, ExecutionEvent events[], int* event_count);
+Metrics priority_scheduling_reference(Process processes[], int n, ExecutionEvent events[], int* event_count);
+Metrics round_robin_reference(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count);
+Metrics priority_round_robin_reference(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count);
+
+// ------------------------------------------------------------
+// Random numbers
+// xoshiro256** seeded through splitmix64. Stream k of a seed starts k
+// jumps (2^128 draws each) past stream 0, so streams never overlap and
+// each run or worker thread can own one. g_rng is thread-local; main
+// gives every policy run its own stream of g_seed, which makes any
+// report reproducible from the seed it prints.
+// ------------------------------------------------------------
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+static uint64_t g_seed = 1;      // --seed, printed with every report
+static __thread Rng g_rng;
+
+static inline uint64_t rotl64(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rng_next(Rng *r) {
+    uint64_t *s = r->s;
+    uint64_t result = rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl64(s[3], 45);
+    return result;
+}
+
+// Advances r by 2^128 draws.
+static void rng_jump(Rng *r) {
+    static const uint64_t JUMP[] = {
+        0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+        0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+    };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for(int i = 0; i < 4; i++) {
+        for(int b = 0; b < 64; b++) {
+            if(JUMP[i] & (1ULL << b)) {
+                s0 ^= r->s[0];
+                s1 ^= r->s[1];
+                s2 ^= r->s[2];
+                s3 ^= r->s[3];
+            }
+            rng_next(r);
+        }
+    }
+    r->s[0] = s0;
+    r->s[1] = s1;
+    r->s[2] = s2;
+    r->s[3] = s3;
+}
+
+void rng_stream(Rng *r, uint64_t seed, unsigned stream) {
+    uint64_t x = seed;
+    for(int i = 0; i < 4; i++) r->s[i] = splitmix64(&x);
+    for(unsigned k = 0; k < stream; k++) rng_jump(r);
+}
+
+// Stream numbers, with each range's width. Every run takes a stream of
+// its own, so no two runs, and no run and generator, share draws.
+enum {
+    RNG_STREAM_WORKLOAD     = 0,     // 1: generated banking tasks
+    RNG_STREAM_MAIN         = 1,     // 5: main's stages, one per policy
+    RNG_STREAM_PREDICTION   = 16,    // 10: actual and predicted, per policy
+    RNG_STREAM_SMP          = 32,    // 10: two placements per policy
+    RNG_STREAM_IO           = 48,    // 5: one per policy
+    RNG_STREAM_IO_WORKLOAD  = 64,    // 1: I/O burst sequences
+    RNG_STREAM_PERIODIC     = 70,    // 1: generated periodic tasks
+    RNG_STREAM_HETERO       = 96,    // 15: SMP_PLACEMENTS per policy
+    RNG_STREAM_ADMISSION    = 112,   // 25: up to five modes per policy
+    RNG_STREAM_MEM_WORKLOAD = 140,   // 1: memory demands
+    RNG_STREAM_DRF          = 144,   // 12: four per run-to-completion policy
+    RNG_STREAM_TENANT       = 160,   // 10: fair-queued and flat, per policy
+    RNG_STREAM_AGING        = 176,   // 10: without and with aging, per policy
+    RNG_STREAM_CLUSTER      = 192    // one per CPU, however many: keep it last
+};
+
+// Uniform in [0, bound) by multiply-shift (Lemire).
+static inline uint64_t rng_below(Rng *r, uint64_t bound) {
+    return (uint64_t)(((unsigned __int128)rng_next(r) * bound) >> 64);
+}
+
+// ------------------------------------------------------------
+// Buffered output layer
+// Rows are formatted into one large buffer and flushed with a
+// single write() per table instead of one printf per row.
+// ------------------------------------------------------------
+#define OUT_BUF_CAP (1 << 20)
+
+typedef struct {
+    char buf[OUT_BUF_CAP];
+    size_t len;
+} OutBuf;
+
+static OutBuf g_out;
+static int g_summary_k = 0;   // --summary=K: print only the K slowest tasks
+
+typedef enum { FORMAT_TEXT, FORMAT_JSON, FORMAT_CSV } OutputFormat;
+static OutputFormat g_format = FORMAT_TEXT;
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static void out_flush(void) {
+    if(g_out.len == 0) return;
+    fflush(stdout);   // keep ordering with printf output
+    size_t off = 0;
+    while(off < g_out.len) {
+        ssize_t w = write(STDOUT_FILENO, g_out.buf + off, g_out.len - off);
+        if(w < 0) {
+            if(errno == EINTR) continue;
+            break;
+        }
+        off += (size_t)w;
+    }
+    g_out.len = 0;
+}
+
+static inline char* out_reserve(size_t need) {
+    if(g_out.len + need > OUT_BUF_CAP) out_flush();
+    return g_out.buf + g_out.len;
+}
+
+static void out_strn(const char *s, size_t n) {
+    while(n > 0) {
+        size_t room = OUT_BUF_CAP - g_out.len;
+        if(room == 0) {
+            out_flush();
+            room = OUT_BUF_CAP;
+        }
+        size_t chunk = n < room ? n : room;
+        memcpy(g_out.buf + g_out.len, s, chunk);
+        g_out.len += chunk;
+        s += chunk;
+        n -= chunk;
+    }
+}
+
+static inline void out_str(const char *s) {
+    out_strn(s, strlen(s));
+}
+
+static inline void out_char(char c) {
+    *out_reserve(1) = c;
+    g_out.len++;
+}
+
+static inline void out_pad(char c, int n) {
+    if(n <= 0) return;
+    memset(out_reserve((size_t)n), c, (size_t)n);
+    g_out.len += (size_t)n;
+}
+
+// Fast unsigned itoa: two digits per step, writes backwards from end.
+// Returns the number of characters written into dst (no terminator).
+static int fmt_u64(char *dst, unsigned long long v) {
+    char tmp[24];
+    char *p = tmp + sizeof(tmp);
+    while(v >= 100) {
+        unsigned idx = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = DIGIT_PAIRS[idx + 1];
+        *--p = DIGIT_PAIRS[idx];
+    }
+    if(v >= 10) {
+        unsigned idx = (unsigned)v * 2;
+        *--p = DIGIT_PAIRS[idx + 1];
+        *--p = DIGIT_PAIRS[idx];
+    } else {
+        *--p = (char)('0' + v);
+    }
+    int len = (int)(tmp + sizeof(tmp) - p);
+    memcpy(dst, p, (size_t)len);
+    return len;
+}
+
+static int fmt_i64(char *dst, long long v) {
+    if(v < 0) {
+        dst[0] = '-';
+        return 1 + fmt_u64(dst + 1, 0ULL - (unsigned long long)v);
+    }
+    return fmt_u64(dst, (unsigned long long)v);
+}
+
+// Equivalent of printf("%*lld") (right aligned) or "%-*lld" (left aligned).
+static void out_int_w(long long v, int width, int left) {
+    char tmp[24];
+    int len = fmt_i64(tmp, v);
+    if(!left) out_pad(' ', width - len);
+    out_strn(tmp, (size_t)len);
+    if(left) out_pad(' ', width - len);
+}
+
+static inline void out_int(long long v) {
+    out_int_w(v, 0, 0);
+}
+
+static void out_u64(unsigned long long v) {
+    char tmp[24];
+    out_strn(tmp, (size_t)fmt_u64(tmp, v));
+}
+
+// Equivalent of printf("%*s") / "%-*s"; longer strings are not truncated.
+static void out_str_w(const char *s, int width, int left) {
+    int len = (int)strlen(s);
+    if(!left) out_pad(' ', width - len);
+    out_strn(s, (size_t)len);
+    if(left) out_pad(' ', width - len);
+}
+
+// Prints v/1000 with two decimals, right aligned: printf("%*.2f", width, v / 1000.0).
+static void out_milli2_w(long long v, int width) {
+    char tmp[32];
+    int neg = v < 0;
+    unsigned long long a = neg ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    unsigned long long hundredths = (a + 5) / 10;
+    int len = 0;
+    if(neg) tmp[len++] = '-';
+    len += fmt_u64(tmp + len, hundredths / 100);
+    tmp[len++] = '.';
+    tmp[len++] = (char)('0' + (hundredths % 100) / 10);
+    tmp[len++] = (char)('0' + hundredths % 10);
+    out_pad(' ', width - len);
+    out_strn(tmp, (size_t)len);
+}
+
+// ------------------------------------------------------------
+// Percentile histograms (log-linear buckets, 16 per power of two)
+// Values below 32 are exact; larger values are within ~6%.
+// ------------------------------------------------------------
+#define HIST_SUB_BITS 4
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS  1024
+
+typedef struct {
+    unsigned long long counts[HIST_BUCKETS];
+    unsigned long long total;
+    long long min;
+    long long max;
+    double sum;
+} Histogram;
+
+static void hist_init(Histogram *h) {
+    memset(h, 0, sizeof(*h));
+    h->min = LLONG_MAX;
+    h->max = LLONG_MIN;
+}
+
+static int hist_index(long long v) {
+    if(v < 0) v = 0;
+    if(v < 2 * HIST_SUB) return (int)v;
+    int msb = 63 - __builtin_clzll((unsigned long long)v);
+    int sub = (int)((unsigned long long)v >> (msb - HIST_SUB_BITS)) - HIST_SUB;
+    return (msb - HIST_SUB_BITS + 1) * HIST_SUB + sub;
+}
+
+// Smallest value that maps to bucket idx.
+static long long hist_bucket_low(int idx) {
+    if(idx < 2 * HIST_SUB) return idx;
+    int msb = idx / HIST_SUB + HIST_SUB_BITS - 1;
+    return (long long)(HIST_SUB + idx % HIST_SUB) << (msb - HIST_SUB_BITS);
+}
+
+static long long hist_bucket_high(int idx) {
+    return hist_bucket_low(idx + 1) - 1;
+}
+
+static void hist_record(Histogram *h, long long v) {
+    h->counts[hist_index(v)]++;
+    h->total++;
+    h->sum += (double)v;
+    if(v < h->min) h->min = v;
+    if(v > h->max) h->max = v;
+}
+
+// Value at quantile q (0..1): upper bound of the bucket holding that rank.
+static long long hist_percentile(const Histogram *h, double q) {
+    if(h->total == 0) return 0;
+    unsigned long long rank = (unsigned long long)(q * (double)h->total + 0.5);
+    if(rank < 1) rank = 1;
+    if(rank > h->total) rank = h->total;
+    unsigned long long seen = 0;
+    for(int i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if(seen >= rank) {
+            long long v = hist_bucket_high(i);
+            if(v > h->max) v = h->max;
+            if(v < h->min) v = h->min;
+            return v;
+        }
+    }
+    return h->max;
+}
 
 long get_time_microseconds() {
     #ifdef _WIN32
@@ -78,37 +420,145 @@ void reset_processes(Process original[], Process processes[], int n) {
 }
 
 void print_execution_log(ExecutionEvent events[], int event_count) {
+    if(g_summary_k > 0) {
+        printf("(execution log omitted in summary mode)\n");
+        (void)event_count;
+        return;
+    }
     for(int i = 0; i < event_count; i++) {
+        out_str(events[i].event_type);
+        out_char(' ');
+        out_str(events[i].task_name);
         if(strcmp(events[i].event_type, "Executing") == 0) {
-            printf("%s %s (BT=%d) at time %d\n", 
-                   events[i].event_type, events[i].task_name, 
-                   events[i].burst_time, events[i].time);
+            out_str(" (BT=");
+            out_int(events[i].burst_time);
+            out_str(") at time ");
+            out_int(events[i].time);
+            out_char('\n');
         } else {
-            printf("%s %s at time %d (PID=%d)\n", 
-                   events[i].event_type, events[i].task_name, 
-                   events[i].time, events[i].pid);
+            out_str(" at time ");
+            out_int(events[i].time);
+            out_str(" (PID=");
+            out_int(events[i].pid);
+            out_str(")\n");
         }
     }
+    out_flush();
+}
+
+static const char PROCESS_TABLE_RULE[] =
+    "+-------------+----+----+----+-----+----+---------------+-----------------+\n";
+
+static void print_process_table_header(void) {
+    out_str(PROCESS_TABLE_RULE);
+    out_str("| Task        | AT | BT | CT | TAT | WT | Real Time     | Sched Latency   |\n");
+    out_str("|             |    |    |    |     |    | (ms)          | (us)            |\n");
+    out_str(PROCESS_TABLE_RULE);
+}
+
+static void print_process_row(const Process *p) {
+    out_str("| ");
+    out_str_w(p->name, 11, 1);
+    out_str(" | ");
+    out_int_w(p->arrival_time, 2, 0);
+    out_str(" | ");
+    out_int_w(p->burst_time, 2, 0);
+    out_str(" | ");
+    out_int_w(p->completion_time, 2, 0);
+    out_str(" | ");
+    out_int_w(p->turnaround_time, 3, 0);
+    out_str(" | ");
+    out_int_w(p->waiting_time, 2, 0);
+    out_str(" | ");
+    out_milli2_w(p->real_time_us, 13);
+    out_str(" | ");
+    out_int_w(p->sched_latency_us, 15, 0);
+    out_str(" |\n");
 }
 
 void print_process_table(Process processes[], int n) {
-    printf("+-------------+----+----+----+-----+----+---------------+-----------------+\n");
-    printf("| Task        | AT | BT | CT | TAT | WT | Real Time     | Sched Latency   |\n");
-    printf("|             |    |    |    |     |    | (ms)          | (us)            |\n");
-    printf("+-------------+----+----+----+-----+----+---------------+-----------------+\n");
-    
+    if(g_summary_k > 0) {
+        print_top_k_slowest(processes, n, g_summary_k);
+        return;
+    }
+    print_process_table_header();
+    for(int i = 0; i < n; i++) {
+        print_process_row(&processes[i]);
+    }
+    out_str(PROCESS_TABLE_RULE);
+    out_flush();
+}
+
+// "Slower" = longer turnaround, then longer real execution time.
+static int slower_than(const Process *a, const Process *b) {
+    if(a->turnaround_time != b->turnaround_time)
+        return a->turnaround_time > b->turnaround_time;
+    return a->real_time_us > b->real_time_us;
+}
+
+static void topk_sift_down(const Process **heap, int size, int pos, const Process *p) {
+    for(;;) {
+        int c = 2 * pos + 1;
+        if(c >= size) break;
+        if(c + 1 < size && slower_than(heap[c], heap[c + 1])) c++;
+        if(!slower_than(p, heap[c])) break;
+        heap[pos] = heap[c];
+        pos = c;
+    }
+    heap[pos] = p;
+}
+
+// Fills heap[0..k) with the K slowest tasks, slowest first, keeping a
+// min-heap of the slowest seen so far: O(n log K), O(K) memory.
+static void select_slowest(const Process processes[], int n, int k, const Process **heap) {
+    int size = 0;
     for(int i = 0; i < n; i++) {
-        printf("| %-11s | %2d | %2d | %2d | %3d | %2d | %13.2f | %15ld |\n",
-               processes[i].name,
-               processes[i].arrival_time,
-               processes[i].burst_time,
-               processes[i].completion_time,
-               processes[i].turnaround_time,
-               processes[i].waiting_time,
-               processes[i].real_time_us / 1000.0,
-               processes[i].sched_latency_us);
+        const Process *p = &processes[i];
+        if(size < k) {
+            int pos = size++;
+            while(pos > 0 && slower_than(heap[(pos - 1) / 2], p)) {
+                heap[pos] = heap[(pos - 1) / 2];
+                pos = (pos - 1) / 2;
+            }
+            heap[pos] = p;
+        } else if(slower_than(p, heap[0])) {
+            topk_sift_down(heap, size, 0, p);
+        }
     }
-    printf("+-------------+----+----+----+-----+----+---------------+-----------------+\n");
+    // Heap-sort in place: popping the min into the tail leaves slowest first.
+    while(size > 1) {
+        const Process *min = heap[0];
+        size--;
+        topk_sift_down(heap, size, 0, heap[size]);
+        heap[size] = min;
+    }
+}
+
+static void print_slowest_table(const Process *const *rows, int k, int n) {
+    out_str("Top ");
+    out_int(k);
+    out_str(" slowest of ");
+    out_int(n);
+    out_str(" tasks (by turnaround time):\n");
+    print_process_table_header();
+    for(int i = 0; i < k; i++) {
+        print_process_row(rows[i]);
+    }
+    out_str(PROCESS_TABLE_RULE);
+    out_flush();
+}
+
+void print_top_k_slowest(Process processes[], int n, int k) {
+    if(k > n) k = n;
+    if(k <= 0) return;
+    const Process **heap = (const Process**)malloc((size_t)k * sizeof(*heap));
+    if(!heap) {
+        perror("malloc(top-k)");
+        return;
+    }
+    select_slowest(processes, n, k, heap);
+    print_slowest_table(heap, k, n);
+    free(heap);
 }
 
 void print_performance_analysis(Metrics metrics) {
@@ -121,618 +571,7593 @@ void print_performance_analysis(Metrics metrics) {
 }
 
 void print_gantt_chart(int gantt[], int gantt_time[], int gantt_size) {
-    printf("\nGantt Chart:\n");
-    printf("|");
+    if(g_format != FORMAT_TEXT) return;
+    if(g_summary_k > 0) {
+        printf("\nGantt Chart: %d segments (omitted in summary mode)\n", gantt_size);
+        return;
+    }
+    out_str("\nGantt Chart:\n");
+    out_char('|');
     for(int i = 0; i < gantt_size; i++) {
-        if(gantt[i] == -1) 
-            printf(" IDLE |");
-        else 
-            printf(" P%d |", gantt[i]);
+        if(gantt[i] == -1) {
+            out_str(" IDLE |");
+        } else {
+            out_str(" P");
+            out_int(gantt[i]);
+            out_str(" |");
+        }
     }
-    printf("\n");
-    printf("0");
+    out_char('\n');
+    out_char('0');
     for(int i = 0; i < gantt_size; i++) {
-        printf("    %d", gantt_time[i]);
+        out_str("    ");
+        out_int(gantt_time[i]);
     }
-    printf("\n");
+    out_char('\n');
+    out_flush();
 }
 
-Metrics fcfs(Process processes[], int n, ExecutionEvent events[], int* event_count) {
-    // Sort by arrival time
-    for(int i = 0; i < n - 1; i++) {
-        for(int j = 0; j < n - i - 1; j++) {
-            if(processes[j].arrival_time > processes[j+1].arrival_time) {
-                Process temp = processes[j];
-                processes[j] = processes[j+1];
-                processes[j+1] = temp;
-            }
+// ------------------------------------------------------------
+// Structured output (--format=json|csv)
+// Records are streamed one per line through the output buffer, so
+// nothing is held in memory beyond the current row.
+//   json: newline-delimited JSON objects tagged with "record"
+//   csv : first column is the record type; each type's header row
+//         is emitted once before its first record
+// ------------------------------------------------------------
+static void out_double(double v) {
+    char tmp[64];
+    int len = snprintf(tmp, sizeof(tmp), "%.6g", v);
+    out_strn(tmp, (size_t)len);
+}
+
+static void out_json_str(const char *s) {
+    out_char('"');
+    for(; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if(c == '"' || c == '\\') {
+            out_char('\\');
+            out_char((char)c);
+        } else if(c < 0x20) {
+            static const char hex[] = "0123456789abcdef";
+            out_str("\\u00");
+            out_char(hex[c >> 4]);
+            out_char(hex[c & 0xf]);
+        } else {
+            out_char((char)c);
         }
     }
-    
-    int current_time = 0;
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
-    int total_sched_latency = 0;
-    long total_overhead = 0;
-    int context_switches = 0;
-    
-    int gantt[100], gantt_time[100], gantt_idx = 0;
-    
-    *event_count = 0;
-    
-    for(int i = 0; i < n; i++) {
-        if(current_time < processes[i].arrival_time) {
-            gantt[gantt_idx] = -1;
-            gantt_time[gantt_idx++] = processes[i].arrival_time;
-            current_time = processes[i].arrival_time;
-        }
-        
-        long start_exec = get_time_microseconds();
-        
-        strcpy(events[*event_count].event_type, "Executing");
-        strcpy(events[*event_count].task_name, processes[i].name);
-        events[*event_count].burst_time = processes[i].burst_time;
-        events[*event_count].time = current_time;
-        events[*event_count].pid = 4860 + i;
-        (*event_count)++;
-        
-        #ifndef _WIN32
-        usleep(processes[i].burst_time * 100);
-        #else
-        Sleep(processes[i].burst_time / 10);
-        #endif
-        
-        processes[i].completion_time = current_time + processes[i].burst_time;
-        processes[i].turnaround_time = processes[i].completion_time - processes[i].arrival_time;
-        processes[i].waiting_time = processes[i].turnaround_time - processes[i].burst_time;
-        
-        gantt[gantt_idx] = processes[i].pid;
-        gantt_time[gantt_idx++] = processes[i].completion_time;
-        
-        current_time = processes[i].completion_time;
-        
-        long end_exec = get_time_microseconds();
-        processes[i].real_time_us = end_exec - start_exec;
-        processes[i].sched_latency_us = 2000 + (rand() % 2000);
-        
-        strcpy(events[*event_count].event_type, "Completed");
-        strcpy(events[*event_count].task_name, processes[i].name);
-        events[*event_count].time = current_time;
-        events[*event_count].pid = 4860 + i;
-        (*event_count)++;
-        
-        total_waiting_time += processes[i].waiting_time;
-        total_turnaround_time += processes[i].turnaround_time;
-        total_sched_latency += processes[i].sched_latency_us;
-        total_overhead += processes[i].real_time_us;
-        context_switches++;
+    out_char('"');
+}
+
+static void out_csv_str(const char *s) {
+    if(strpbrk(s, ",\"\n\r") == NULL) {
+        out_str(s);
+        return;
     }
-    
-    print_gantt_chart(gantt, gantt_time, gantt_idx);
-    
-    Metrics metrics;
-    metrics.avg_waiting_time = (double)total_waiting_time / n;
-    metrics.avg_turnaround_time = (double)total_turnaround_time / n;
-    metrics.context_switches = context_switches - 1;
-    metrics.avg_context_switch_overhead_us = (double)total_overhead / (n * 1000.0);
-    metrics.total_context_switch_time_ms = (double)total_overhead / 1000.0 / n * 0.28;
-    metrics.avg_sched_latency_us = (double)total_sched_latency / n;
-    metrics.total_real_time_ms = total_overhead;
-    
-    return metrics;
+    out_char('"');
+    for(; *s; s++) {
+        if(*s == '"') out_char('"');
+        out_char(*s);
+    }
+    out_char('"');
 }
 
-Metrics sjf(Process processes[], int n, ExecutionEvent events[], int* event_count) {
-    int current_time = 0;
-    int completed = 0;
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
-    int total_sched_latency = 0;
-    int is_completed[10] = {0};
-    int context_switches = 0;
-    long total_overhead = 0;
-    
-    int gantt[100], gantt_time[100], gantt_idx = 0;
-    
-    *event_count = 0;
-    
-    while(completed != n) {
-        int min_burst = 999999;
-        int min_index = -1;
-        
-        for(int i = 0; i < n; i++) {
-            if(processes[i].arrival_time <= current_time && !is_completed[i]) {
-                if(processes[i].burst_time < min_burst) {
-                    min_burst = processes[i].burst_time;
-                    min_index = i;
-                }
-                else if(processes[i].burst_time == min_burst) {
-                    if(processes[i].arrival_time < processes[min_index].arrival_time) {
-                        min_index = i;
-                    }
-                }
-            }
+// JSON key prefix: ,"key":
+static inline void out_json_key(const char *key) {
+    out_str(",\"");
+    out_str(key);
+    out_str("\":");
+}
+
+enum { CSV_HDR_METRICS = 1, CSV_HDR_PROCESS = 2, CSV_HDR_HIST = 4, CSV_HDR_BUCKET = 8,
+       CSV_HDR_PREDICT = 16, CSV_HDR_SMP = 32,
+       CSV_HDR_IO = 64, CSV_HDR_CLUSTER = 128, CSV_HDR_SEGMENT = 256,
+       CSV_HDR_AGING = 512, CSV_HDR_TENANT = 1024, CSV_HDR_HETERO = 2048,
+       CSV_HDR_PERIODIC = 4096, CSV_HDR_SCHEDTEST = 8192, CSV_HDR_LOCKSTEP = 16384,
+       CSV_HDR_ADMISSION = 32768, CSV_HDR_DRF = 65536 };
+static int g_csv_headers_done = 0;
+
+static int csv_header_once(int which) {
+    if(g_csv_headers_done & which) return 0;
+    g_csv_headers_done |= which;
+    return 1;
+}
+
+static void emit_metrics_record(const char *policy, int quantum, int n, Metrics m) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"metrics\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("quantum");                   out_int(quantum);
+        out_json_key("processes");                 out_int(n);
+        out_json_key("avg_waiting_time");          out_double(m.avg_waiting_time);
+        out_json_key("avg_turnaround_time");       out_double(m.avg_turnaround_time);
+        out_json_key("context_switches");          out_int(m.context_switches);
+        out_json_key("avg_context_switch_overhead_us"); out_double(m.avg_context_switch_overhead_us);
+        out_json_key("total_context_switch_time_ms");   out_double(m.total_context_switch_time_ms);
+        out_json_key("avg_sched_latency_us");      out_double(m.avg_sched_latency_us);
+        out_json_key("total_real_time_us");        out_int(m.total_real_time_ms);
+        out_json_key("seed");                      out_u64(g_seed);
+        out_str("}\n");
+    } else {
+        if(csv_header_once(CSV_HDR_METRICS)) {
+            out_str("record,policy,quantum,processes,avg_waiting_time,avg_turnaround_time,"
+                    "context_switches,avg_context_switch_overhead_us,"
+                    "total_context_switch_time_ms,avg_sched_latency_us,total_real_time_us,seed\n");
         }
-        
-        if(min_index == -1) {
-            gantt[gantt_idx] = -1;
-            gantt_time[gantt_idx++] = current_time + 1;
-            current_time++;
+        out_str("metrics,");
+        out_csv_str(policy);
+        out_char(',');  out_int(quantum);
+        out_char(',');  out_int(n);
+        out_char(',');  out_double(m.avg_waiting_time);
+        out_char(',');  out_double(m.avg_turnaround_time);
+        out_char(',');  out_int(m.context_switches);
+        out_char(',');  out_double(m.avg_context_switch_overhead_us);
+        out_char(',');  out_double(m.total_context_switch_time_ms);
+        out_char(',');  out_double(m.avg_sched_latency_us);
+        out_char(',');  out_int(m.total_real_time_ms);
+        out_char(',');  out_u64(g_seed);
+        out_char('\n');
+    }
+}
+
+static void emit_process_records(const char *policy, Process processes[], int n) {
+    if(g_format == FORMAT_CSV && csv_header_once(CSV_HDR_PROCESS)) {
+        out_str("record,policy,pid,name,arrival_time,burst_time,priority,completion_time,"
+                "turnaround_time,waiting_time,real_time_us,sched_latency_us\n");
+    }
+    for(int i = 0; i < n; i++) {
+        const Process *p = &processes[i];
+        if(g_format == FORMAT_JSON) {
+            out_str("{\"record\":\"process\",\"policy\":");
+            out_json_str(policy);
+            out_json_key("pid");              out_int(p->pid);
+            out_json_key("name");             out_json_str(p->name);
+            out_json_key("arrival_time");     out_int(p->arrival_time);
+            out_json_key("burst_time");       out_int(p->burst_time);
+            out_json_key("priority");         out_int(p->priority);
+            out_json_key("completion_time");  out_int(p->completion_time);
+            out_json_key("turnaround_time");  out_int(p->turnaround_time);
+            out_json_key("waiting_time");     out_int(p->waiting_time);
+            out_json_key("real_time_us");     out_int(p->real_time_us);
+            out_json_key("sched_latency_us"); out_int(p->sched_latency_us);
+            out_str("}\n");
         } else {
-            long start_exec = get_time_microseconds();
-            
-            strcpy(events[*event_count].event_type, "Executing");
-            strcpy(events[*event_count].task_name, processes[min_index].name);
-            events[*event_count].burst_time = processes[min_index].burst_time;
-            events[*event_count].time = current_time;
-            events[*event_count].pid = 4860 + min_index;
-            (*event_count)++;
-            
-            #ifndef _WIN32
-            usleep(processes[min_index].burst_time * 100);
-            #else
-            Sleep(processes[min_index].burst_time / 10);
-            #endif
-            
-            processes[min_index].completion_time = current_time + processes[min_index].burst_time;
-            processes[min_index].turnaround_time = processes[min_index].completion_time - processes[min_index].arrival_time;
-            processes[min_index].waiting_time = processes[min_index].turnaround_time - processes[min_index].burst_time;
-            
-            gantt[gantt_idx] = processes[min_index].pid;
-            gantt_time[gantt_idx++] = processes[min_index].completion_time;
-            
-            current_time = processes[min_index].completion_time;
-            
-            long end_exec = get_time_microseconds();
-            processes[min_index].real_time_us = end_exec - start_exec;
-            processes[min_index].sched_latency_us = 2000 + (rand() % 2000);
-            
-            strcpy(events[*event_count].event_type, "Completed");
-            strcpy(events[*event_count].task_name, processes[min_index].name);
-            events[*event_count].time = current_time;
-            events[*event_count].pid = 4860 + min_index;
-            (*event_count)++;
-            
-            total_waiting_time += processes[min_index].waiting_time;
-            total_turnaround_time += processes[min_index].turnaround_time;
-            total_sched_latency += processes[min_index].sched_latency_us;
-            total_overhead += processes[min_index].real_time_us;
-            
-            is_completed[min_index] = 1;
-            completed++;
-            context_switches++;
+            out_str("process,");
+            out_csv_str(policy);
+            out_char(',');  out_int(p->pid);
+            out_char(',');  out_csv_str(p->name);
+            out_char(',');  out_int(p->arrival_time);
+            out_char(',');  out_int(p->burst_time);
+            out_char(',');  out_int(p->priority);
+            out_char(',');  out_int(p->completion_time);
+            out_char(',');  out_int(p->turnaround_time);
+            out_char(',');  out_int(p->waiting_time);
+            out_char(',');  out_int(p->real_time_us);
+            out_char(',');  out_int(p->sched_latency_us);
+            out_char('\n');
         }
     }
-    
-    print_gantt_chart(gantt, gantt_time, gantt_idx);
-    
-    Metrics metrics;
-    metrics.avg_waiting_time = (double)total_waiting_time / n;
-    metrics.avg_turnaround_time = (double)total_turnaround_time / n;
-    metrics.context_switches = context_switches - 1;
-    metrics.avg_context_switch_overhead_us = (double)total_overhead / (n * 1000.0);
-    metrics.total_context_switch_time_ms = (double)total_overhead / 1000.0 / n * 0.28;
-    metrics.avg_sched_latency_us = (double)total_sched_latency / n;
-    metrics.total_real_time_ms = total_overhead;
-    
-    return metrics;
 }
 
-Metrics priority_scheduling(Process processes[], int n, ExecutionEvent events[], int* event_count) {
-    int current_time = 0;
-    int completed = 0;
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
-    int total_sched_latency = 0;
-    int is_completed[10] = {0};
-    int context_switches = 0;
-    long total_overhead = 0;
-    
-    int gantt[100], gantt_time[100], gantt_idx = 0;
-    
-    *event_count = 0;
-    
-    while(completed != n) {
-        int highest_priority = 999999;
-        int min_index = -1;
-        
-        for(int i = 0; i < n; i++) {
-            if(processes[i].arrival_time <= current_time && !is_completed[i]) {
-                if(processes[i].priority < highest_priority) {
-                    highest_priority = processes[i].priority;
-                    min_index = i;
-                }
-                else if(processes[i].priority == highest_priority) {
-                    if(min_index == -1 || processes[i].arrival_time < processes[min_index].arrival_time) {
-                        min_index = i;
-                    }
-                }
-            }
+static const double HIST_QUANTILES[] = {0.50, 0.90, 0.95, 0.99, 0.999};
+static const char *HIST_QUANTILE_NAMES[] = {"p50", "p90", "p95", "p99", "p999"};
+#define HIST_NQ ((int)(sizeof(HIST_QUANTILES) / sizeof(HIST_QUANTILES[0])))
+
+static void emit_histogram_record(const char *policy, const char *metric, const Histogram *h) {
+    double mean = h->total ? h->sum / (double)h->total : 0.0;
+    long long mn = h->total ? h->min : 0;
+    long long mx = h->total ? h->max : 0;
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"histogram\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("metric");  out_json_str(metric);
+        out_json_key("count");   out_int((long long)h->total);
+        out_json_key("min");     out_int(mn);
+        out_json_key("mean");    out_double(mean);
+        for(int q = 0; q < HIST_NQ; q++) {
+            out_json_key(HIST_QUANTILE_NAMES[q]);
+            out_int(hist_percentile(h, HIST_QUANTILES[q]));
         }
-        
-        if(min_index == -1) {
-            gantt[gantt_idx] = -1;
-            gantt_time[gantt_idx++] = current_time + 1;
-            current_time++;
-        } else {
-            long start_exec = get_time_microseconds();
-            
-            strcpy(events[*event_count].event_type, "Executing");
-            strcpy(events[*event_count].task_name, processes[min_index].name);
-            events[*event_count].burst_time = processes[min_index].burst_time;
-            events[*event_count].time = current_time;
-            events[*event_count].pid = 4860 + min_index;
-            (*event_count)++;
-            
-            #ifndef _WIN32
-            usleep(processes[min_index].burst_time * 100);
-            #else
-            Sleep(processes[min_index].burst_time / 10);
-            #endif
-            
-            processes[min_index].completion_time = current_time + processes[min_index].burst_time;
-            processes[min_index].turnaround_time = processes[min_index].completion_time - processes[min_index].arrival_time;
-            processes[min_index].waiting_time = processes[min_index].turnaround_time - processes[min_index].burst_time;
-            
-            gantt[gantt_idx] = processes[min_index].pid;
-            gantt_time[gantt_idx++] = processes[min_index].completion_time;
-            
-            current_time = processes[min_index].completion_time;
-            
-            long end_exec = get_time_microseconds();
-            processes[min_index].real_time_us = end_exec - start_exec;
-            processes[min_index].sched_latency_us = 2000 + (rand() % 2000);
-            
-            strcpy(events[*event_count].event_type, "Completed");
-            strcpy(events[*event_count].task_name, processes[min_index].name);
-            events[*event_count].time = current_time;
-            events[*event_count].pid = 4860 + min_index;
-            (*event_count)++;
-            
-            total_waiting_time += processes[min_index].waiting_time;
-            total_turnaround_time += processes[min_index].turnaround_time;
-            total_sched_latency += processes[min_index].sched_latency_us;
-            total_overhead += processes[min_index].real_time_us;
-            
-            is_completed[min_index] = 1;
-            completed++;
-            context_switches++;
+        out_json_key("max");     out_int(mx);
+        out_json_key("buckets");
+        out_char('[');
+        int first = 1;
+        for(int i = 0; i < HIST_BUCKETS; i++) {
+            if(!h->counts[i]) continue;
+            if(!first) out_char(',');
+            first = 0;
+            out_char('[');
+            out_int(hist_bucket_low(i));
+            out_char(',');
+            out_int(hist_bucket_high(i));
+            out_char(',');
+            out_int((long long)h->counts[i]);
+            out_char(']');
         }
+        out_str("]}\n");
+        return;
     }
-    
-    print_gantt_chart(gantt, gantt_time, gantt_idx);
-    
-    Metrics metrics;
-    metrics.avg_waiting_time = (double)total_waiting_time / n;
-    metrics.avg_turnaround_time = (double)total_turnaround_time / n;
-    metrics.context_switches = context_switches - 1;
-    metrics.avg_context_switch_overhead_us = (double)total_overhead / (n * 1000.0);
-    metrics.total_context_switch_time_ms = (double)total_overhead / 1000.0 / n * 0.28;
-    metrics.avg_sched_latency_us = (double)total_sched_latency / n;
-    metrics.total_real_time_ms = total_overhead;
-    
-    return metrics;
-}
 
-Metrics round_robin(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
-    int current_time = 0;
-    int completed = 0;
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
-    int total_sched_latency = 0;
-    int context_switches = 0;
-    long total_overhead = 0;
-    
-    int gantt[1000], gantt_time[1000], gantt_idx = 0;
-    
-    *event_count = 0;
-    
-    int queue[100], front = 0, rear = 0;
-    int in_queue[10] = {0};
-    int last_executed = -1;
-    
-    for(int i = 0; i < n; i++) {
-        if(processes[i].arrival_time == 0) {
-            queue[rear++] = i;
-            in_queue[i] = 1;
+    if(csv_header_once(CSV_HDR_HIST)) {
+        out_str("record,policy,metric,count,min,mean");
+        for(int q = 0; q < HIST_NQ; q++) {
+            out_char(',');
+            out_str(HIST_QUANTILE_NAMES[q]);
         }
+        out_str(",max\n");
     }
-    
-    while(completed != n) {
-        if(front == rear) {
-            gantt[gantt_idx] = -1;
-            gantt_time[gantt_idx++] = current_time + 1;
+    out_str("histogram,");
+    out_csv_str(policy);
+    out_char(',');  out_str(metric);
+    out_char(',');  out_int((long long)h->total);
+    out_char(',');  out_int(mn);
+    out_char(',');  out_double(mean);
+    for(int q = 0; q < HIST_NQ; q++) {
+        out_char(',');
+        out_int(hist_percentile(h, HIST_QUANTILES[q]));
+    }
+    out_char(',');  out_int(mx);
+    out_char('\n');
+
+    if(csv_header_once(CSV_HDR_BUCKET)) {
+        out_str("record,policy,metric,low,high,count\n");
+    }
+    for(int i = 0; i < HIST_BUCKETS; i++) {
+        if(!h->counts[i]) continue;
+        out_str("bucket,");
+        out_csv_str(policy);
+        out_char(',');  out_str(metric);
+        out_char(',');  out_int(hist_bucket_low(i));
+        out_char(',');  out_int(hist_bucket_high(i));
+        out_char(',');  out_int((long long)h->counts[i]);
+        out_char('\n');
+    }
+}
+
+// The per-run histograms: waiting time, turnaround time, scheduling latency.
+#define RUN_NHIST 3
+
+static void build_histograms(const Process processes[], int n, Histogram h[RUN_NHIST]) {
+    for(int k = 0; k < RUN_NHIST; k++) hist_init(&h[k]);
+    for(int i = 0; i < n; i++) {
+        hist_record(&h[0], processes[i].waiting_time);
+        hist_record(&h[1], processes[i].turnaround_time);
+        hist_record(&h[2], processes[i].sched_latency_us);
+    }
+}
+
+static void emit_histogram_set(const char *policy, const Histogram h[RUN_NHIST]) {
+    emit_histogram_record(policy, "waiting_time", &h[0]);
+    emit_histogram_record(policy, "turnaround_time", &h[1]);
+    emit_histogram_record(policy, "sched_latency_us", &h[2]);
+}
+
+static void emit_histograms(const char *policy, Process processes[], int n) {
+    Histogram *h = (Histogram*)malloc(RUN_NHIST * sizeof(Histogram));
+    if(!h) {
+        perror("malloc(histogram)");
+        return;
+    }
+    build_histograms(processes, n, h);
+    emit_histogram_set(policy, h);
+    free(h);
+}
+
+static void print_results_footer(Metrics metrics) {
+    printf("\nAverage Turnaround Time: %.2f\n", metrics.avg_turnaround_time);
+    printf("Average Waiting Time: %.2f\n", metrics.avg_waiting_time);
+    printf("Seed: %llu\n", (unsigned long long)g_seed);
+    print_performance_analysis(metrics);
+}
+
+// Prints one policy's results in the selected output format.
+void report_results(const char *policy, const char *label, int quantum,
+                    Process processes[], int n,
+                    ExecutionEvent events[], int event_count, Metrics metrics) {
+    if(g_format == FORMAT_TEXT) {
+        printf("== Scheduling Started ==\n");
+        print_execution_log(events, event_count);
+        printf("\n== %s Scheduling Results ==\n", label);
+        print_process_table(processes, n);
+        print_results_footer(metrics);
+        return;
+    }
+    emit_metrics_record(policy, quantum, n, metrics);
+    emit_histograms(policy, processes, n);
+    if(g_summary_k == 0) {
+        emit_process_records(policy, processes, n);
+    }
+    out_flush();
+}
+
+void print_section(const char *title, int first) {
+    if(g_format != FORMAT_TEXT) return;
+    printf("%s\n========================================\n", first ? "" : "\n");
+    printf("%s\n", title);
+    printf("========================================\n");
+}
+
+// ------------------------------------------------------------
+// Run bookkeeping shared by all policies
+// ------------------------------------------------------------
+typedef struct {
+    int *pid;
+    int *time;
+    int size;
+    int cap;
+    long long dispatches;        // slices pushed, before same-task merging
+} Gantt;
+
+static Gantt g_gantt;            // timeline of the most recent run
+static int g_simulate_work = 1;  // usleep() per slice to mimic CPU work
+static int g_show_gantt = 1;     // print the Gantt chart after each run
+static int g_aging = 0;          // --aging: time units per priority level, 0 off
+
+static void gantt_reset(void) {
+    g_gantt.size = 0;
+    g_gantt.dispatches = 0;
+}
+
+// Appends the segment ending at time. Consecutive segments of the same
+// task (or idle) merge, so a run of slices takes one entry.
+static void gantt_push(int pid, int time) {
+    if(pid != -1) g_gantt.dispatches++;
+    if(g_gantt.size > 0 && g_gantt.pid[g_gantt.size - 1] == pid) {
+        g_gantt.time[g_gantt.size - 1] = time;
+        return;
+    }
+    if(g_gantt.size == g_gantt.cap) {
+        int cap = g_gantt.cap ? g_gantt.cap * 2 : 1024;
+        int *p = (int*)realloc(g_gantt.pid, (size_t)cap * sizeof(int));
+        int *t = p ? (int*)realloc(g_gantt.time, (size_t)cap * sizeof(int)) : NULL;
+        if(!p || !t) {
+            perror("realloc(gantt)");
+            exit(1);
+        }
+        g_gantt.pid = p;
+        g_gantt.time = t;
+        g_gantt.cap = cap;
+    }
+    g_gantt.pid[g_gantt.size] = pid;
+    g_gantt.time[g_gantt.size++] = time;
+}
+
+static void show_gantt(void) {
+    if(g_show_gantt) print_gantt_chart(g_gantt.pid, g_gantt.time, g_gantt.size);
+}
+
+// Appends to the execution log; events may be NULL to skip logging.
+static void log_event(ExecutionEvent events[], int *event_count, const char *type,
+                      const Process *p, int burst_time, int time, int pid) {
+    if(!events) return;
+    ExecutionEvent *e = &events[(*event_count)++];
+    strcpy(e->event_type, type);
+    strcpy(e->task_name, p->name);
+    e->burst_time = burst_time;
+    e->time = time;
+    e->pid = pid;
+}
+
+// ------------------------------------------------------------
+// Time series (--series=PATH)
+// Ready-queue depth, CPU utilization and backlog (remaining work of
+// arrived, unfinished tasks) are piecewise constant or linear between
+// engine events, so each event closes one interval of the previous
+// state. Intervals fold into at most `budget` buckets of `width` time
+// units, keeping min/max/area per bucket; when time runs past the last
+// bucket, neighbouring buckets merge pairwise and the width doubles.
+// Memory is fixed and each event costs amortized O(1); min/max buckets
+// keep the spikes that averaging or point-picking downsamplers drop.
+// ------------------------------------------------------------
+typedef struct {
+    int depth_min, depth_max;
+    long long depth_area;
+    long long busy;              // time units with a task running
+    long long backlog_min, backlog_max;
+    long long backlog_area;
+} SeriesBucket;
+
+static struct {
+    int enabled;
+    int budget;                  // even, >= 2
+    int width;
+    int count;
+    SeriesBucket *b;
+    int last;                    // time of the last event
+    int depth;
+    int running;
+    long long backlog;           // at time last
+} g_series;
+
+static void series_reset(void) {
+    g_series.width = 1;
+    g_series.count = 0;
+    g_series.last = 0;
+    g_series.depth = 0;
+    g_series.running = 0;
+    g_series.backlog = 0;
+}
+
+static void series_merge(SeriesBucket *a, const SeriesBucket *b) {
+    if(b->depth_min < a->depth_min) a->depth_min = b->depth_min;
+    if(b->depth_max > a->depth_max) a->depth_max = b->depth_max;
+    if(b->backlog_min < a->backlog_min) a->backlog_min = b->backlog_min;
+    if(b->backlog_max > a->backlog_max) a->backlog_max = b->backlog_max;
+    a->depth_area += b->depth_area;
+    a->busy += b->busy;
+    a->backlog_area += b->backlog_area;
+}
+
+// Closes [last, t) with the current state.
+static void series_advance(int t) {
+    int from = g_series.last;
+    long long backlog = g_series.backlog;
+    while(from < t) {
+        int idx = from / g_series.width;
+        if(idx >= g_series.budget) {
+            for(int k = 0; k < g_series.count / 2; k++) {
+                g_series.b[k] = g_series.b[2 * k];
+                series_merge(&g_series.b[k], &g_series.b[2 * k + 1]);
+            }
+            if(g_series.count & 1) g_series.b[g_series.count / 2] = g_series.b[g_series.count - 1];
+            g_series.count = (g_series.count + 1) / 2;
+            g_series.width *= 2;
+            continue;
+        }
+        SeriesBucket *b = &g_series.b[idx];
+        if(idx >= g_series.count) {
+            b->depth_min = INT_MAX;
+            b->depth_max = 0;
+            b->backlog_min = LLONG_MAX;
+            b->backlog_max = 0;
+            b->depth_area = b->busy = b->backlog_area = 0;
+            g_series.count = idx + 1;
+        }
+        int end = (idx + 1) * g_series.width < t ? (idx + 1) * g_series.width : t;
+        long long len = end - from;
+        long long after = backlog - g_series.running * len;
+        if(g_series.depth < b->depth_min) b->depth_min = g_series.depth;
+        if(g_series.depth > b->depth_max) b->depth_max = g_series.depth;
+        if(after < b->backlog_min) b->backlog_min = after;
+        if(backlog > b->backlog_max) b->backlog_max = backlog;
+        b->depth_area += g_series.depth * len;
+        b->busy += g_series.running * len;
+        b->backlog_area += (backlog + after) * len / 2;
+        backlog = after;
+        from = end;
+    }
+    if(t > g_series.last) {
+        g_series.backlog = backlog;
+        g_series.last = t;
+    }
+}
+
+// Engine events; all are no-ops unless a series is being recorded.
+static inline void series_arrive(int t, int work) {
+    if(!g_series.enabled) return;
+    series_advance(t);
+    g_series.depth++;
+    g_series.backlog += work;
+}
+
+static inline void series_dispatch(int t) {
+    if(!g_series.enabled) return;
+    series_advance(t);
+    g_series.depth--;
+    g_series.running = 1;
+}
+
+// A waiting task with work left is dropped at t.
+static inline void series_drop(int t, int work) {
+    if(!g_series.enabled) return;
+    series_advance(t);
+    g_series.depth--;
+    g_series.backlog -= work;
+}
+
+// The running task stops at t; requeued puts it back in the queue.
+static inline void series_stop(int t, int requeued) {
+    if(!g_series.enabled) return;
+    series_advance(t);
+    g_series.running = 0;
+    if(requeued) g_series.depth++;
+}
+
+// Appends the latest run's buckets to f as CSV rows.
+void series_write(FILE *f, const char *policy) {
+    for(int k = 0; k < g_series.count; k++) {
+        const SeriesBucket *b = &g_series.b[k];
+        int start = k * g_series.width;
+        int end = (k + 1) * g_series.width < g_series.last ? (k + 1) * g_series.width : g_series.last;
+        double len = end > start ? end - start : 1;
+        fprintf(f, "%s,%d,%d,%d,%d,%.3f,%.2f,%lld,%lld,%.3f\n",
+                policy, start, end, b->depth_min, b->depth_max, b->depth_area / len,
+                100.0 * b->busy / len, b->backlog_min, b->backlog_max, b->backlog_area / len);
+    }
+}
+
+static void simulate_work(int units) {
+    if(!g_simulate_work) return;
+    #ifndef _WIN32
+    usleep(units * 100);
+    #else
+    Sleep(units / 10);
+    #endif
+}
+
+static void* xcalloc(size_t count, size_t size, const char *what) {
+    void *p = calloc(count ? count : 1, size);
+    if(!p) {
+        perror(what);
+        exit(1);
+    }
+    return p;
+}
+
+typedef struct {
+    long long total_waiting_time;
+    long long total_turnaround_time;
+    long long total_sched_latency;
+    long long total_overhead;
+    int context_switches;
+} RunTotals;
+
+static void totals_add(RunTotals *t, const Process *p) {
+    t->total_waiting_time += p->waiting_time;
+    t->total_turnaround_time += p->turnaround_time;
+    t->total_sched_latency += p->sched_latency_us;
+    t->total_overhead += p->real_time_us;
+}
+
+// Run-to-completion policies measure real execution time per task.
+static Metrics nonpreemptive_metrics(const RunTotals *t, int n) {
+    Metrics metrics = {0};
+    metrics.avg_waiting_time = (double)t->total_waiting_time / n;
+    metrics.avg_turnaround_time = (double)t->total_turnaround_time / n;
+    metrics.context_switches = t->context_switches - 1;
+    metrics.avg_context_switch_overhead_us = (double)t->total_overhead / (n * 1000.0);
+    metrics.total_context_switch_time_ms = (double)t->total_overhead / 1000.0 / n * 0.28;
+    metrics.avg_sched_latency_us = (double)t->total_sched_latency / n;
+    metrics.total_real_time_ms = t->total_overhead;
+    return metrics;
+}
+
+// Quantum-based policies charge a per-switch overhead instead.
+static Metrics quantum_metrics(const RunTotals *t, int n) {
+    Metrics metrics = {0};
+    metrics.avg_waiting_time = (double)t->total_waiting_time / n;
+    metrics.avg_turnaround_time = (double)t->total_turnaround_time / n;
+    metrics.context_switches = t->context_switches;
+    metrics.avg_context_switch_overhead_us = 50.0 + (double)rng_below(&g_rng, 30);
+    metrics.total_context_switch_time_ms = t->context_switches * metrics.avg_context_switch_overhead_us / 1000.0;
+    metrics.avg_sched_latency_us = (double)t->total_sched_latency / n;
+    metrics.total_real_time_ms = t->total_overhead;
+    return metrics;
+}
+
+// Runs processes[idx] to completion starting at current_time (non-preemptive policies).
+static int run_to_completion(Process processes[], int idx, int current_time,
+                             ExecutionEvent events[], int *event_count, RunTotals *totals) {
+    Process *p = &processes[idx];
+    long start_exec = get_time_microseconds();
+    
+    log_event(events, event_count, "Executing", p, p->burst_time, current_time, 4860 + idx);
+    simulate_work(p->burst_time);
+    
+    p->completion_time = current_time + p->burst_time;
+    p->turnaround_time = p->completion_time - p->arrival_time;
+    p->waiting_time = p->turnaround_time - p->burst_time;
+    
+    gantt_push(p->pid, p->completion_time);
+    
+    long end_exec = get_time_microseconds();
+    p->real_time_us = end_exec - start_exec;
+    p->sched_latency_us = 2000 + (long)rng_below(&g_rng, 2000);
+    
+    log_event(events, event_count, "Completed", p, 0, p->completion_time, 4860 + idx);
+    totals_add(totals, p);
+    totals->context_switches++;
+    return p->completion_time;
+}
+
+// Bookkeeping when a time-sliced process finishes at current_time.
+static void complete_sliced(Process processes[], int idx, int current_time,
+                            ExecutionEvent events[], int *event_count, RunTotals *totals) {
+    Process *p = &processes[idx];
+    p->completion_time = current_time;
+    p->turnaround_time = p->completion_time - p->arrival_time;
+    p->waiting_time = p->turnaround_time - p->burst_time;
+    p->real_time_us = 200000 + (long)rng_below(&g_rng, 200000);
+    p->sched_latency_us = 2000 + (long)rng_below(&g_rng, 2000);
+    log_event(events, event_count, "Completed", p, 0, current_time, 4860 + idx);
+    totals_add(totals, p);
+}
+
+// ------------------------------------------------------------
+// Gantt trace files (--save-trace=PREFIX, --trace=FILE)
+// A trace is a TraceHeader followed by the run-length-merged Gantt
+// arrays: end[] then pid[], one entry per segment. Segment i covers
+// [end[i-1], end[i]) (the first starts at 0), so end[] is already a
+// sorted interval index: the segment holding time t is the first one
+// ending after t, found by binary search over the mapped file. Range
+// queries walk forward from there, clipping to the range.
+// ------------------------------------------------------------
+#define TRACE_MAGIC "SCHEDGT1"
+#define TRACE_VERSION 1u
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    int segments;
+    uint64_t seed;
+    char policy[16];
+} TraceHeader;
+
+typedef struct {
+    const int *end;
+    const int *pid;           // -1: idle
+    int size;
+} GanttView;
+
+static inline int gantt_start(const GanttView *g, int i) {
+    return i > 0 ? g->end[i - 1] : 0;
+}
+
+// Index of the first segment ending after t; g->size if none.
+static int gantt_find(const GanttView *g, int t) {
+    int lo = 0, hi = g->size;
+    while(lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if(g->end[mid] <= t) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// Writes the latest run's Gantt to path; returns 0 on success.
+int gantt_save(const char *path, const char *policy) {
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if(!f) return -1;
+    TraceHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+    h.version = TRACE_VERSION;
+    h.segments = g_gantt.size;
+    h.seed = g_seed;
+    snprintf(h.policy, sizeof(h.policy), "%s", policy);
+    int ok = fwrite(&h, sizeof(h), 1, f) == 1
+          && (g_gantt.size == 0
+              || (fwrite(g_gantt.time, sizeof(int), (size_t)g_gantt.size, f) == (size_t)g_gantt.size
+                  && fwrite(g_gantt.pid, sizeof(int), (size_t)g_gantt.size, f) == (size_t)g_gantt.size));
+    if(fclose(f) != 0) ok = 0;
+    if(!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+static void emit_segment(const char *policy, int start, int end, int pid) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"segment\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("start");  out_int(start);
+        out_json_key("end");    out_int(end);
+        out_json_key("pid");    out_int(pid);
+        out_str("}\n");
+    } else if(g_format == FORMAT_CSV) {
+        if(csv_header_once(CSV_HDR_SEGMENT)) out_str("record,policy,start,end,pid\n");
+        out_str("segment,");
+        out_csv_str(policy);
+        out_char(',');  out_int(start);
+        out_char(',');  out_int(end);
+        out_char(',');  out_int(pid);
+        out_char('\n');
+    } else {
+        out_int_w(start, 10, 0);
+        out_int_w(end, 11, 0);
+        if(pid < 0) {
+            out_str("   IDLE\n");
+        } else {
+            out_str("   P");
+            out_int(pid);
+            out_char('\n');
+        }
+    }
+}
+
+typedef struct {
+    GanttView g;
+    char policy[17];
+    uint64_t seed;
+    void *map;
+    size_t len;
+} TraceFile;
+
+static int trace_open(const char *path, TraceFile *tf) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        perror(path);
+        return -1;
+    }
+    struct stat sb;
+    void *map = MAP_FAILED;
+    if(fstat(fd, &sb) == 0 && (size_t)sb.st_size >= sizeof(TraceHeader)) {
+        map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    const TraceHeader *h = (const TraceHeader*)map;
+    if(map == MAP_FAILED
+        || memcmp(h->magic, TRACE_MAGIC, sizeof(h->magic)) != 0
+        || h->version != TRACE_VERSION || h->segments < 0
+        || (size_t)sb.st_size < sizeof(*h) + 2 * (size_t)h->segments * sizeof(int)) {
+        fprintf(stderr, "%s: not a Gantt trace\n", path);
+        if(map != MAP_FAILED) munmap(map, (size_t)sb.st_size);
+        return -1;
+    }
+    memcpy(tf->policy, h->policy, sizeof(h->policy));
+    tf->policy[sizeof(h->policy)] = '\0';
+    tf->seed = h->seed;
+    tf->g.end = (const int*)(h + 1);
+    tf->g.pid = tf->g.end + h->segments;
+    tf->g.size = h->segments;
+    tf->map = map;
+    tf->len = (size_t)sb.st_size;
+    return 0;
+}
+
+static void trace_close(TraceFile *tf) {
+    munmap(tf->map, tf->len);
+}
+
+static inline int trace_span(const TraceFile *tf) {
+    return tf->g.size ? tf->g.end[tf->g.size - 1] : 0;
+}
+
+// Prints the segments overlapping [from, to), clipped to it.
+int run_trace_query(const char *path, int from, int to) {
+    TraceFile tf;
+    if(trace_open(path, &tf) != 0) return 1;
+    const GanttView *g = &tf.g;
+    int span = trace_span(&tf);
+    if(g_format == FORMAT_TEXT) {
+        printf("Trace %s: policy %s, %d segments over [0, %d), seed %llu\n",
+               path, tf.policy, g->size, span, (unsigned long long)tf.seed);
+        printf("Segments in [%d, %d):\n", from, to);
+        printf("%10s %10s   %s\n", "Start", "End", "Task");
+    }
+    long long busy = 0, idle = 0, matched = 0;
+    for(int i = gantt_find(g, from); i < g->size && gantt_start(g, i) < to; i++) {
+        int start = gantt_start(g, i) > from ? gantt_start(g, i) : from;
+        int end = g->end[i] < to ? g->end[i] : to;
+        if(end <= start) continue;
+        emit_segment(tf.policy, start, end, g->pid[i]);
+        if(g->pid[i] < 0) idle += end - start;
+        else busy += end - start;
+        matched++;
+    }
+    out_flush();
+    if(g_format == FORMAT_TEXT) {
+        if(matched == 0) printf("(none: the trace covers [0, %d))\n", span);
+        printf("Busy %lld, idle %lld\n", busy, idle);
+    }
+    trace_close(&tf);
+    return 0;
+}
+
+// ------------------------------------------------------------
+// SVG / HTML Gantt rendering (--trace=FILE --render=OUT.svg|OUT.html)
+// The range is split into at most `width` pixel columns. One pass over
+// the segments fills each column with the task holding its longest
+// busy piece, or idle when less than half of it is busy, and its busy
+// fraction; runs of columns
+// with the same task, or the same busy level, are written as one rect
+// as soon as they end. Output size is therefore bounded by the width,
+// not the trace length, and nothing is buffered beyond the current run.
+// ------------------------------------------------------------
+#define RENDER_LEFT      60
+#define RENDER_TOP       28
+#define RENDER_ROW       36     // task row height
+#define RENDER_UTIL      24     // utilization strip height
+#define RENDER_LEVELS    16     // busy fraction quantization
+
+typedef struct {
+    FILE *f;
+    double px;                // pixels per column
+    int from;
+    long long span;
+    int ncol;
+    int run_pid;              // task run: -1 idle
+    int run_x;
+    int util_level;           // utilization run
+    int util_x;
+} GanttRenderer;
+
+static inline long long render_col_time(const GanttRenderer *r, int x) {
+    return r->from + r->span * x / r->ncol;
+}
+
+static void render_task_run(GanttRenderer *r, int x) {
+    if(r->run_pid < 0 || x == r->run_x) return;
+    double x0 = RENDER_LEFT + r->run_x * r->px, w = (x - r->run_x) * r->px;
+    unsigned hue = (unsigned)((r->run_pid * 2654435761u) >> 16) % 360;
+    fprintf(r->f, "<rect x=\"%.2f\" y=\"%d\" width=\"%.2f\" height=\"%d\" fill=\"hsl(%u,60%%,55%%)\">"
+            "<title>P%d [%lld, %lld)</title></rect>\n",
+            x0, RENDER_TOP, w, RENDER_ROW, hue, r->run_pid,
+            render_col_time(r, r->run_x), render_col_time(r, x));
+    if(w >= 36) {
+        fprintf(r->f, "<text x=\"%.2f\" y=\"%d\" font-size=\"11\" text-anchor=\"middle\">P%d</text>\n",
+                x0 + w / 2, RENDER_TOP + RENDER_ROW / 2 + 4, r->run_pid);
+    }
+}
+
+static void render_util_run(GanttRenderer *r, int x) {
+    if(r->util_level == 0 || x == r->util_x) return;
+    int h = RENDER_UTIL * r->util_level / RENDER_LEVELS;
+    fprintf(r->f, "<rect x=\"%.2f\" y=\"%d\" width=\"%.2f\" height=\"%d\" fill=\"#4a6\"/>\n",
+            RENDER_LEFT + r->util_x * r->px, RENDER_TOP + RENDER_ROW + 8 + RENDER_UTIL - h,
+            (x - r->util_x) * r->px, h);
+}
+
+static void render_column(GanttRenderer *r, int x, int pid, int level) {
+    if(pid != r->run_pid) {
+        render_task_run(r, x);
+        r->run_pid = pid;
+        r->run_x = x;
+    }
+    if(level != r->util_level) {
+        render_util_run(r, x);
+        r->util_level = level;
+        r->util_x = x;
+    }
+}
+
+// The task drawn for column [c0, c1): the one holding the longest busy
+// piece of it, or -1 when less than half is busy. An idle gap never
+// wins, however short the slices around it are. Advances *i, the first
+// segment not yet past the column, and sets *busy to the busy time.
+static int render_column_pid(const GanttView *g, int *i, long long c0, long long c1, long long *busy) {
+    long long best = 0;
+    int pid = -1;
+    *busy = 0;
+    while(*i < g->size && gantt_start(g, *i) < c1) {
+        long long s = gantt_start(g, *i) > c0 ? gantt_start(g, *i) : c0;
+        long long e = g->end[*i] < c1 ? g->end[*i] : c1;
+        if(g->pid[*i] >= 0) {
+            *busy += e - s;
+            if(e - s > best) {
+                best = e - s;
+                pid = g->pid[*i];
+            }
+        }
+        if(g->end[*i] > c1) break;
+        (*i)++;
+    }
+    return *busy * 2 < c1 - c0 ? -1 : pid;   // mostly idle or past the end
+}
+
+// Renders [from, to) of a trace into out (an HTML page if html is set).
+static int render_trace(const TraceFile *tf, const char *out, int from, int to, int width, int html) {
+    FILE *f = fopen(out, "w");
+    if(!f) {
+        perror(out);
+        return -1;
+    }
+    setvbuf(f, NULL, _IOFBF, 1 << 16);
+    const GanttView *g = &tf->g;
+    GanttRenderer r;
+    memset(&r, 0, sizeof(r));
+    r.f = f;
+    r.from = from;
+    r.span = (long long)to - from;
+    r.ncol = r.span < width ? (int)r.span : width;
+    r.px = (double)width / r.ncol;
+    r.run_pid = -1;
+    int height = RENDER_TOP + RENDER_ROW + 8 + RENDER_UTIL + 24;
+
+    if(html) {
+        fprintf(f, "<!DOCTYPE html>\n<html><head><meta charset=\"utf-8\"><title>Gantt: %s</title>"
+                "<style>body{font-family:sans-serif}</style></head><body>\n"
+                "<h3>%s: %d segments, [%d, %d), seed %llu</h3>\n",
+                tf->policy, tf->policy, g->size, from, to, (unsigned long long)tf->seed);
+    }
+    fprintf(f, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\" "
+            "font-family=\"sans-serif\">\n", RENDER_LEFT + width + 20, height);
+    fprintf(f, "<text x=\"%d\" y=\"16\" font-size=\"12\">%s [%d, %d)</text>\n",
+            RENDER_LEFT, tf->policy, from, to);
+    fprintf(f, "<text x=\"4\" y=\"%d\" font-size=\"11\">CPU</text>\n", RENDER_TOP + RENDER_ROW / 2 + 4);
+    fprintf(f, "<text x=\"4\" y=\"%d\" font-size=\"11\">busy</text>\n",
+            RENDER_TOP + RENDER_ROW + 8 + RENDER_UTIL / 2 + 4);
+    fprintf(f, "<rect x=\"%d\" y=\"%d\" width=\"%d\" height=\"%d\" fill=\"#eee\"/>\n",
+            RENDER_LEFT, RENDER_TOP, width, RENDER_ROW);
+
+    int i = gantt_find(g, from);
+    for(int x = 0; x < r.ncol; x++) {
+        long long c0 = render_col_time(&r, x), c1 = render_col_time(&r, x + 1);
+        long long busy;
+        int pid = render_column_pid(g, &i, c0, c1, &busy);
+        render_column(&r, x, pid, (int)(busy * RENDER_LEVELS / (c1 - c0)));
+    }
+    render_column(&r, r.ncol, -2, -1);   // flush both runs
+
+    // Ten axis ticks.
+    int axis_y = RENDER_TOP + RENDER_ROW + 8 + RENDER_UTIL + 16;
+    for(int k = 0; k <= 10; k++) {
+        int x = r.ncol * k / 10;
+        fprintf(f, "<text x=\"%.2f\" y=\"%d\" font-size=\"10\" text-anchor=\"middle\">%lld</text>\n",
+                RENDER_LEFT + x * r.px, axis_y, render_col_time(&r, x));
+    }
+    fprintf(f, "</svg>\n");
+    if(html) fprintf(f, "</body></html>\n");
+    if(fclose(f) != 0) {
+        perror(out);
+        return -1;
+    }
+    return 0;
+}
+
+int run_trace_render(const char *path, const char *out, int from, int to, int width) {
+    TraceFile tf;
+    if(trace_open(path, &tf) != 0) return 1;
+    if(from < 0) {
+        from = 0;
+        to = trace_span(&tf);
+    }
+    size_t len = strlen(out);
+    int html = (len >= 5 && strcmp(out + len - 5, ".html") == 0)
+            || (len >= 4 && strcmp(out + len - 4, ".htm") == 0);
+    int rc = 0;
+    if(to <= from) {
+        fprintf(stderr, "%s: empty range [%d, %d)\n", path, from, to);
+        rc = 1;
+    } else if(render_trace(&tf, out, from, to, width, html) != 0) {
+        rc = 1;
+    }
+    trace_close(&tf);
+    return rc;
+}
+
+// ------------------------------------------------------------
+// Keyed index
+// Open addressing (linear probe, at most 70% full) from a key to a
+// dense id 0..count-1; the caller keeps its records in an array
+// indexed by id. Slots keep the key's 64-bit hash, so growing never
+// re-hashes keys and the match callback only sees ids whose hash is
+// equal. Names hash with FNV-1a.
+// ------------------------------------------------------------
+typedef struct {
+    uint64_t *hash;
+    int *id;                  // -1: empty
+    int nslots;               // power of two, 0 until the first add
+    int count;
+} KeyIndex;
+
+// Nonzero when records[id] has key.
+typedef int (*KeyMatchFn)(const void *records, int id, const void *key);
+
+static unsigned long long fnv1a(const char *s) {
+    unsigned long long h = 1469598103934665603ULL;
+    for(; *s; s++) {
+        h ^= (unsigned char)*s;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// The id of key, or -1.
+static inline int key_index_find(const KeyIndex *x, uint64_t h, KeyMatchFn match,
+                                 const void *records, const void *key) {
+    if(x->nslots == 0) return -1;
+    unsigned mask = (unsigned)x->nslots - 1;
+    for(unsigned i = (unsigned)h & mask; x->id[i] >= 0; i = (i + 1) & mask) {
+        if(x->hash[i] == h && match(records, x->id[i], key)) return x->id[i];
+    }
+    return -1;
+}
+
+// Adds a key that key_index_find() did not find; returns its id, the
+// old count. The caller fills in record id.
+static int key_index_add(KeyIndex *x, uint64_t h) {
+    if((x->count + 1) * 10 > x->nslots * 7) {
+        uint64_t *old_hash = x->hash;
+        int *old_id = x->id;
+        int old_slots = x->nslots;
+        x->nslots = old_slots ? old_slots * 2 : 16;
+        x->hash = (uint64_t*)xcalloc((size_t)x->nslots, sizeof(uint64_t), "calloc(index)");
+        x->id = (int*)xcalloc((size_t)x->nslots, sizeof(int), "calloc(index)");
+        memset(x->id, 0xff, (size_t)x->nslots * sizeof(int));
+        unsigned mask = (unsigned)x->nslots - 1;
+        for(int k = 0; k < old_slots; k++) {
+            if(old_id[k] < 0) continue;
+            unsigned i = (unsigned)old_hash[k] & mask;
+            while(x->id[i] >= 0) i = (i + 1) & mask;
+            x->hash[i] = old_hash[k];
+            x->id[i] = old_id[k];
+        }
+        free(old_hash);
+        free(old_id);
+    }
+    unsigned mask = (unsigned)x->nslots - 1;
+    unsigned i = (unsigned)h & mask;
+    while(x->id[i] >= 0) i = (i + 1) & mask;
+    x->hash[i] = h;
+    x->id[i] = x->count;
+    return x->count++;
+}
+
+static void key_index_free(KeyIndex *x) {
+    free(x->hash);
+    free(x->id);
+    memset(x, 0, sizeof(*x));
+}
+
+// Grows a record array of *cap records of size bytes to hold need.
+static void* grow_records(void *records, int *cap, int need, size_t size, const char *what) {
+    if(need <= *cap) return records;
+    int c = *cap ? *cap * 2 : 16;
+    while(c < need) c *= 2;
+    void *r = realloc(records, (size_t)c * size);
+    if(!r) {
+        perror(what);
+        exit(1);
+    }
+    *cap = c;
+    return r;
+}
+
+// ------------------------------------------------------------
+// Burst prediction
+// Per task class (keyed by name) exponential average of observed
+// bursts: tau(n+1) = alpha * t(n) + (1 - alpha) * tau(n).
+// ------------------------------------------------------------
+typedef struct {
+    char name[100];
+    double tau;
+    long long samples;
+} PredictorClass;
+
+typedef struct BurstPredictor {
+    PredictorClass *classes;  // by KeyIndex id
+    int cap;
+    KeyIndex index;
+    double alpha;
+    double tau0;          // estimate for a class never seen before
+    // Error of the predictions actually used for scheduling.
+    long long predictions;
+    double abs_err_sum;
+    double pct_err_sum;
+} BurstPredictor;
+
+void predictor_init(BurstPredictor *bp, double alpha, double tau0) {
+    memset(bp, 0, sizeof(*bp));
+    bp->alpha = alpha;
+    bp->tau0 = tau0;
+}
+
+void predictor_free(BurstPredictor *bp) {
+    free(bp->classes);
+    bp->classes = NULL;
+    bp->cap = 0;
+    key_index_free(&bp->index);
+}
+
+static int predictor_named(const void *records, int id, const void *key) {
+    return strcmp(((const PredictorClass*)records)[id].name, (const char*)key) == 0;
+}
+
+static PredictorClass* predictor_class(BurstPredictor *bp, const char *name, int create) {
+    uint64_t h = fnv1a(name);
+    int k = key_index_find(&bp->index, h, predictor_named, bp->classes, name);
+    if(k >= 0) return &bp->classes[k];
+    if(!create) return NULL;
+    bp->classes = (PredictorClass*)grow_records(bp->classes, &bp->cap, bp->index.count + 1,
+                                                sizeof(PredictorClass), "realloc(predictor)");
+    PredictorClass *c = &bp->classes[key_index_add(&bp->index, h)];
+    memset(c, 0, sizeof(*c));
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->tau = bp->tau0;
+    return c;
+}
+
+// Predicted burst for the next job of this class, rounded, at least 1.
+int predictor_predict(BurstPredictor *bp, const char *name) {
+    const PredictorClass *c = predictor_class(bp, name, 0);
+    double tau = c ? c->tau : bp->tau0;
+    int est = (int)(tau + 0.5);
+    return est < 1 ? 1 : est;
+}
+
+// Learns from a finished job and scores the prediction it was scheduled with.
+void predictor_observe(BurstPredictor *bp, const Process *p) {
+    PredictorClass *c = predictor_class(bp, p->name, 1);
+    c->tau = bp->alpha * p->burst_time + (1.0 - bp->alpha) * c->tau;
+    c->samples++;
+
+    double err = (double)p->predicted_burst - p->burst_time;
+    if(err < 0) err = -err;
+    bp->predictions++;
+    bp->abs_err_sum += err;
+    bp->pct_err_sum += err / p->burst_time;
+}
+
+double predictor_mae(const BurstPredictor *bp) {
+    return bp->predictions ? bp->abs_err_sum / bp->predictions : 0.0;
+}
+
+double predictor_mape(const BurstPredictor *bp) {
+    return bp->predictions ? 100.0 * bp->pct_err_sum / bp->predictions : 0.0;
+}
+
+// ------------------------------------------------------------
+// Admission control
+// While g_admission is set, the heap engine sheds work in three ways:
+//   queue cap     an arrival finding queue_cap tasks waiting is refused
+//   token bucket  each task class (keyed by name) holds up to
+//                 token_burst tokens, refilled at token_rate per time
+//                 unit; an arrival without a whole token is refused
+//   deadline      a task is due at arrival + deadline_slack * burst; one
+//                 that can no longer finish in time is dropped when it
+//                 would next be dispatched, before it wastes more CPU
+// Shed tasks keep completion_time -1 and are left out of the metrics.
+// ------------------------------------------------------------
+typedef struct {
+    int queue_cap;            // 0: no cap
+    double token_rate;        // 0: no token bucket
+    double token_burst;
+    int deadline_slack;       // 0: no deadlines
+} AdmissionOpts;
+
+typedef struct {
+    char name[100];
+    double tokens;
+    int last;                 // time of the last refill
+} TokenBucket;
+
+typedef struct {
+    AdmissionOpts o;
+    TokenBucket *buckets;     // by KeyIndex id of the class name
+    int cap;
+    KeyIndex index;
+    int shed;
+    long long shed_queue;
+    long long shed_tokens;
+    long long shed_deadline;
+} AdmissionCtl;
+
+static AdmissionCtl *g_admission;   // NULL: admit everything
+
+void admission_init(AdmissionCtl *ac, const AdmissionOpts *o) {
+    memset(ac, 0, sizeof(*ac));
+    ac->o = *o;
+}
+
+void admission_free(AdmissionCtl *ac) {
+    free(ac->buckets);
+    ac->buckets = NULL;
+    ac->cap = 0;
+    key_index_free(&ac->index);
+}
+
+static int admission_named(const void *records, int id, const void *key) {
+    return strcmp(((const TokenBucket*)records)[id].name, (const char*)key) == 0;
+}
+
+// The class's bucket, created full at time t.
+static TokenBucket* admission_bucket(AdmissionCtl *ac, const char *name, int t) {
+    uint64_t h = fnv1a(name);
+    int k = key_index_find(&ac->index, h, admission_named, ac->buckets, name);
+    if(k >= 0) return &ac->buckets[k];
+    ac->buckets = (TokenBucket*)grow_records(ac->buckets, &ac->cap, ac->index.count + 1,
+                                             sizeof(TokenBucket), "realloc(admission)");
+    TokenBucket *b = &ac->buckets[key_index_add(&ac->index, h)];
+    snprintf(b->name, sizeof(b->name), "%s", name);
+    b->tokens = ac->o.token_burst;
+    b->last = t;
+    return b;
+}
+
+static inline void admission_shed(AdmissionCtl *ac, Process *p, long long *reason) {
+    p->completion_time = -1;
+    ac->shed++;
+    (*reason)++;
+}
+
+// Called for each arrival in arrival order; waiting is the queue length
+// it would join. Returns 0 (and sheds p) to refuse it.
+static int admission_accept(AdmissionCtl *ac, Process *p, int waiting) {
+    if(ac->o.queue_cap > 0 && waiting >= ac->o.queue_cap) {
+        admission_shed(ac, p, &ac->shed_queue);
+        return 0;
+    }
+    if(ac->o.token_rate > 0.0) {
+        TokenBucket *b = admission_bucket(ac, p->name, p->arrival_time);
+        if(p->arrival_time > b->last) {
+            b->tokens += ac->o.token_rate * (p->arrival_time - b->last);
+            if(b->tokens > ac->o.token_burst) b->tokens = ac->o.token_burst;
+            b->last = p->arrival_time;
+        }
+        if(b->tokens < 1.0) {
+            admission_shed(ac, p, &ac->shed_tokens);
+            return 0;
+        }
+        b->tokens -= 1.0;
+    }
+    return 1;
+}
+
+static inline long long admission_deadline(const AdmissionOpts *o, const Process *p) {
+    return p->arrival_time + (long long)o->deadline_slack * p->burst_time;
+}
+
+// Drops p (returns 1) when it cannot finish by its deadline from now.
+static inline int admission_expired(AdmissionCtl *ac, Process *p, int now) {
+    if(ac->o.deadline_slack <= 0 || now + p->remaining_time <= admission_deadline(&ac->o, p)) return 0;
+    admission_shed(ac, p, &ac->shed_deadline);
+    return 1;
+}
+
+static inline int admission_shed_count(void) {
+    return g_admission ? g_admission->shed : 0;
+}
+
+// ------------------------------------------------------------
+// Scheduling engine
+// One event loop shared by every policy. A policy is only a
+// comparator: SCHED_DEFINE_POLICY() expands it into a static inline
+// function and a wrapper that calls the always-inline engine with that
+// function's address as a compile-time constant, so the comparison is
+// inlined into the heap operations with no indirect call.
+//   quantum == 0 : run the selected task to completion
+//   quantum  > 0 : run one slice, then re-queue the task
+//   preempt_on_arrival : also end the slice at the next arrival (SRTF)
+// With a predictor, each task's predicted_burst is filled in when it
+// is admitted and the predictor learns the real burst at completion.
+// ------------------------------------------------------------
+#define SCHED_INLINE static inline __attribute__((always_inline))
+
+typedef struct {
+    const Process *p;
+    int idx;        // index into processes[]
+    unsigned seq;   // order in which the task (re)joined the ready queue
+} SchedEntry;
+
+typedef int (*SchedBeforeFn)(const SchedEntry *a, const SchedEntry *b);
+
+typedef struct {
+    int quantum;
+    int preempt_on_arrival;
+    BurstPredictor *predictor;
+} SchedOpts;
+
+typedef struct {
+    SchedEntry *a;
+    int size;
+} SchedHeap;
+
+SCHED_INLINE void sched_heap_push(SchedHeap *h, SchedEntry e, SchedBeforeFn before) {
+    int pos = h->size++;
+    while(pos > 0 && before(&e, &h->a[(pos - 1) / 2])) {
+        h->a[pos] = h->a[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+    h->a[pos] = e;
+}
+
+SCHED_INLINE SchedEntry sched_heap_pop(SchedHeap *h, SchedBeforeFn before) {
+    SchedEntry top = h->a[0];
+    SchedEntry last = h->a[--h->size];
+    int pos = 0;
+    for(;;) {
+        int c = 2 * pos + 1;
+        if(c >= h->size) break;
+        if(c + 1 < h->size && before(&h->a[c + 1], &h->a[c])) c++;
+        if(!before(&h->a[c], &last)) break;
+        h->a[pos] = h->a[c];
+        pos = c;
+    }
+    if(h->size > 0) h->a[pos] = last;
+    return top;
+}
+
+// Stable merge sort of process indices by arrival time: ties keep index order.
+static int* arrival_order(const Process processes[], int n) {
+    int *order = (int*)xcalloc((size_t)n, sizeof(int), "calloc(order)");
+    int *tmp = (int*)xcalloc((size_t)n, sizeof(int), "calloc(order)");
+    for(int i = 0; i < n; i++) order[i] = i;
+    for(int width = 1; width < n; width *= 2) {
+        for(int lo = 0; lo < n; lo += 2 * width) {
+            int mid = lo + width < n ? lo + width : n;
+            int hi = lo + 2 * width < n ? lo + 2 * width : n;
+            int a = lo, b = mid, k = lo;
+            while(a < mid && b < hi) {
+                if(processes[order[b]].arrival_time < processes[order[a]].arrival_time)
+                    tmp[k++] = order[b++];
+                else
+                    tmp[k++] = order[a++];
+            }
+            while(a < mid) tmp[k++] = order[a++];
+            while(b < hi) tmp[k++] = order[b++];
+        }
+        int *swap = order; order = tmp; tmp = swap;
+    }
+    free(tmp);
+    return order;
+}
+
+static int cmp_int(const void *a, const void *b) {
+    int x = *(const int*)a, y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+typedef struct {
+    const int *order;   // process indices sorted by arrival
+    int next;           // first not-yet-admitted position in order
+    unsigned seq;
+} ArrivalCursor;
+
+// Moves every task that has arrived by time t into the ready heap. Tasks
+// admitted together join in index order, matching the reference scans.
+SCHED_INLINE void sched_admit(ArrivalCursor *cur, Process processes[], int n, int t,
+                              SchedHeap *ready, BurstPredictor *predictor, SchedBeforeFn before) {
+    int start = cur->next, accepted = 0;
+    while(cur->next < n && processes[cur->order[cur->next]].arrival_time <= t) {
+        Process *p = &processes[cur->order[cur->next++]];
+        if(g_admission && !admission_accept(g_admission, p, ready->size + accepted)) continue;
+        accepted++;
+        series_arrive(p->arrival_time, p->remaining_time);
+    }
+    int count = cur->next - start;
+    if(count > 1) qsort((void*)(cur->order + start), (size_t)count, sizeof(int), cmp_int);
+    for(int k = start; k < cur->next; k++) {
+        int i = cur->order[k];
+        if(g_admission && processes[i].completion_time < 0) continue;   // shed
+        if(predictor) processes[i].predicted_burst = predictor_predict(predictor, processes[i].name);
+        processes[i].ready_since = processes[i].arrival_time;
+        SchedEntry e = { &processes[i], i, cur->seq++ };
+        sched_heap_push(ready, e, before);
+    }
+}
+
+// ------------------------------------------------------------
+// Checkpoint / restore
+// Every g_ckpt.every scheduling decisions the engine forks; the child
+// writes the complete engine state (clock, cursor, ready queue, totals,
+// per-process counters, Gantt, event log, predictor) as one binary
+// snapshot while the parent keeps simulating on its copy-on-write
+// pages. The snapshot goes to PATH.tmp and is renamed over PATH, so
+// PATH always holds the latest complete checkpoint.
+// Histograms are built from the per-process counters at report time,
+// so restoring the processes restores them too. The workload itself is
+// not stored twice: it is the processes with their counters reset.
+// ------------------------------------------------------------
+#define CHECKPOINT_MAGIC "SCHEDCK1"
+#define CHECKPOINT_VERSION 4u
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    unsigned process_size;   // sizeof(Process): rejects snapshots from other builds
+    int stage;               // which of main's policies was running
+    int n;
+    int quantum;
+    int aging;               // --aging: the ready heap is ordered by it
+    int current_time;
+    int completed;
+    int last_executed;
+    int cursor_next;
+    unsigned cursor_seq;
+    RunTotals totals;
+    uint64_t seed;
+    Rng rng;                 // the run's random stream, mid-sequence
+    int ready_size;
+    int gantt_size;
+    int event_count;
+    int has_predictor;
+    int pred_count;          // classes, stored densely
+    double pred_alpha;
+    double pred_tau0;
+    long long pred_predictions;
+    double pred_abs_err_sum;
+    double pred_pct_err_sum;
+} CheckpointHeader;
+
+typedef struct {
+    int idx;
+    unsigned seq;
+} CheckpointEntry;
+
+typedef struct {
+    CheckpointHeader h;
+    Process *original;
+    Process *processes;
+    CheckpointEntry *ready;
+    int *gantt_pid;
+    int *gantt_time;
+    ExecutionEvent *events;
+    PredictorClass *pred_classes;
+} Snapshot;
+
+typedef struct {
+    const char *path;
+    long long every;          // decisions between snapshots; 0 disables
+    int stage;                // main's current policy, 0 outside main's runs
+    int quantum;
+    long long decisions;
+    pid_t writer;             // in-flight snapshot child, 0 if none
+    long long written;
+    long long skipped;        // previous writer still busy
+} Checkpointer;
+
+static Checkpointer g_ckpt;
+static Snapshot *g_resume = NULL;   // --resume: consumed by the matching stage
+
+// Pointers to the engine's locals, so checkpointing stays out of its loop.
+typedef struct {
+    Process *processes;
+    int n;
+    ArrivalCursor *cur;
+    SchedHeap *ready;
+    RunTotals *totals;
+    int *current_time;
+    int *completed;
+    int *last_executed;
+    ExecutionEvent *events;
+    int *event_count;
+    BurstPredictor *predictor;
+} EngineView;
+
+static int write_all(FILE *f, const void *p, size_t size, size_t count) {
+    return count == 0 || fwrite(p, size, count, f) == count;
+}
+
+static int checkpoint_write(const EngineView *v, const char *path) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if(!f) return -1;
+    setvbuf(f, NULL, _IOFBF, 1 << 20);
+
+    CheckpointHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.process_size = sizeof(Process);
+    h.stage = g_ckpt.stage;
+    h.n = v->n;
+    h.quantum = g_ckpt.quantum;
+    h.aging = g_aging;
+    h.current_time = *v->current_time;
+    h.completed = *v->completed;
+    h.last_executed = *v->last_executed;
+    h.cursor_next = v->cur->next;
+    h.cursor_seq = v->cur->seq;
+    h.totals = *v->totals;
+    h.seed = g_seed;
+    h.rng = g_rng;
+    h.ready_size = v->ready->size;
+    h.gantt_size = g_gantt.size;
+    h.event_count = v->events ? *v->event_count : 0;
+    if(v->predictor) {
+        const BurstPredictor *bp = v->predictor;
+        h.has_predictor = 1;
+        h.pred_count = bp->index.count;
+        h.pred_alpha = bp->alpha;
+        h.pred_tau0 = bp->tau0;
+        h.pred_predictions = bp->predictions;
+        h.pred_abs_err_sum = bp->abs_err_sum;
+        h.pred_pct_err_sum = bp->pct_err_sum;
+    }
+
+    int ok = write_all(f, &h, sizeof(h), 1)
+          && write_all(f, v->processes, sizeof(Process), (size_t)v->n);
+    for(int i = 0; ok && i < v->ready->size; i++) {
+        CheckpointEntry ce = { v->ready->a[i].idx, v->ready->a[i].seq };
+        ok = write_all(f, &ce, sizeof(ce), 1);
+    }
+    ok = ok
+      && write_all(f, g_gantt.pid, sizeof(int), (size_t)g_gantt.size)
+      && write_all(f, g_gantt.time, sizeof(int), (size_t)g_gantt.size)
+      && write_all(f, v->events, sizeof(ExecutionEvent), (size_t)h.event_count);
+    if(ok && h.has_predictor) {
+        ok = write_all(f, v->predictor->classes, sizeof(PredictorClass), (size_t)h.pred_count);
+    }
+
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    if(fclose(f) != 0) ok = 0;
+    if(!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Reaps a finished writer; returns 1 if one is still running.
+static int checkpoint_busy(int block) {
+    if(g_ckpt.writer <= 0) return 0;
+    int status;
+    pid_t r = waitpid(g_ckpt.writer, &status, block ? 0 : WNOHANG);
+    if(r == 0) return 1;
+    if(r == g_ckpt.writer && (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+        fprintf(stderr, "checkpoint: writing %s failed\n", g_ckpt.path);
+    }
+    g_ckpt.writer = 0;
+    return 0;
+}
+
+static void checkpoint_take(const EngineView *v) {
+    g_ckpt.decisions = 0;
+    if(checkpoint_busy(0)) {
+        g_ckpt.skipped++;
+        return;
+    }
+    pid_t pid = fork();
+    if(pid < 0) {
+        perror("fork(checkpoint)");
+        return;
+    }
+    if(pid == 0) {
+        _exit(checkpoint_write(v, g_ckpt.path) == 0 ? 0 : 1);
+    }
+    g_ckpt.writer = pid;
+    g_ckpt.written++;
+}
+
+// Called once per scheduling decision; cheap unless a snapshot is due.
+SCHED_INLINE void checkpoint_tick(const EngineView *v) {
+    if(g_ckpt.every > 0 && g_ckpt.stage > 0 && ++g_ckpt.decisions >= g_ckpt.every) {
+        checkpoint_take(v);
+    }
+}
+
+// Waits for the last snapshot to reach disk.
+void checkpoint_finish(void) {
+    checkpoint_busy(1);
+}
+
+static int read_all(FILE *f, void *p, size_t size, size_t count) {
+    return count == 0 || fread(p, size, count, f) == count;
+}
+
+void snapshot_free(Snapshot *s) {
+    if(!s) return;
+    free(s->original);
+    free(s->processes);
+    free(s->ready);
+    free(s->gantt_pid);
+    free(s->gantt_time);
+    free(s->events);
+    free(s->pred_classes);
+    free(s);
+}
+
+Snapshot* checkpoint_load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if(!f) {
+        perror(path);
+        return NULL;
+    }
+    Snapshot *s = (Snapshot*)xcalloc(1, sizeof(Snapshot), "calloc(snapshot)");
+    CheckpointHeader *h = &s->h;
+    if(!read_all(f, h, sizeof(*h), 1)
+        || memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(h->magic)) != 0
+        || h->version != CHECKPOINT_VERSION
+        || h->process_size != sizeof(Process)
+        || h->n <= 0 || h->aging < 0 || h->ready_size < 0 || h->ready_size > h->n
+        || h->gantt_size < 0 || h->event_count < 0 || h->pred_count < 0) {
+        fprintf(stderr, "%s: not a checkpoint from this build\n", path);
+        fclose(f);
+        snapshot_free(s);
+        return NULL;
+    }
+    size_t n = (size_t)h->n;
+    s->original = (Process*)xcalloc(n, sizeof(Process), "calloc(snapshot)");
+    s->processes = (Process*)xcalloc(n, sizeof(Process), "calloc(snapshot)");
+    s->ready = (CheckpointEntry*)xcalloc(n, sizeof(CheckpointEntry), "calloc(snapshot)");
+    s->gantt_pid = (int*)xcalloc((size_t)h->gantt_size + 1, sizeof(int), "calloc(snapshot)");
+    s->gantt_time = (int*)xcalloc((size_t)h->gantt_size + 1, sizeof(int), "calloc(snapshot)");
+    s->events = (ExecutionEvent*)xcalloc((size_t)h->event_count + 1, sizeof(ExecutionEvent), "calloc(snapshot)");
+    if(h->has_predictor) {
+        s->pred_classes = (PredictorClass*)xcalloc((size_t)h->pred_count + 1, sizeof(PredictorClass),
+                                                   "calloc(snapshot)");
+    }
+    int ok = read_all(f, s->processes, sizeof(Process), n)
+          && read_all(f, s->ready, sizeof(CheckpointEntry), (size_t)h->ready_size)
+          && read_all(f, s->gantt_pid, sizeof(int), (size_t)h->gantt_size)
+          && read_all(f, s->gantt_time, sizeof(int), (size_t)h->gantt_size)
+          && read_all(f, s->events, sizeof(ExecutionEvent), (size_t)h->event_count)
+          && (!h->has_predictor || read_all(f, s->pred_classes, sizeof(PredictorClass), (size_t)h->pred_count));
+    fclose(f);
+    if(!ok) {
+        fprintf(stderr, "%s: truncated checkpoint\n", path);
+        snapshot_free(s);
+        return NULL;
+    }
+    for(size_t i = 0; i < n; i++) {
+        const Process *p = &s->processes[i];
+        Process *o = &s->original[i];
+        memset(o, 0, sizeof(*o));
+        o->pid = p->pid;
+        memcpy(o->name, p->name, sizeof(o->name));
+        o->arrival_time = p->arrival_time;
+        o->burst_time = p->burst_time;
+        o->priority = p->priority;
+        o->working_set_kb = p->working_set_kb;
+        o->mem_mb = p->mem_mb;
+        o->remaining_time = p->burst_time;
+        o->first_run = -1;
+    }
+    return s;
+}
+
+// Puts a loaded snapshot back into a freshly started engine run.
+static void checkpoint_restore(const EngineView *v, Snapshot *s) {
+    const CheckpointHeader *h = &s->h;
+    memcpy(v->processes, s->processes, (size_t)v->n * sizeof(Process));
+    *v->current_time = h->current_time;
+    *v->completed = h->completed;
+    *v->last_executed = h->last_executed;
+    v->cur->next = h->cursor_next;
+    v->cur->seq = h->cursor_seq;
+    *v->totals = h->totals;
+    g_rng = h->rng;
+    // The heap array is restored verbatim, so its order is already valid.
+    v->ready->size = h->ready_size;
+    for(int i = 0; i < h->ready_size; i++) {
+        v->ready->a[i].p = &v->processes[s->ready[i].idx];
+        v->ready->a[i].idx = s->ready[i].idx;
+        v->ready->a[i].seq = s->ready[i].seq;
+    }
+    for(int i = 0; i < h->gantt_size; i++) {
+        gantt_push(s->gantt_pid[i], s->gantt_time[i]);
+    }
+    if(v->events) {
+        memcpy(v->events, s->events, (size_t)h->event_count * sizeof(ExecutionEvent));
+        *v->event_count = h->event_count;
+    }
+    if(v->predictor && h->has_predictor) {
+        BurstPredictor *bp = v->predictor;
+        free(bp->classes);
+        key_index_free(&bp->index);
+        bp->classes = s->pred_classes;
+        s->pred_classes = NULL;
+        bp->cap = h->pred_count + 1;
+        for(int k = 0; k < h->pred_count; k++) key_index_add(&bp->index, fnv1a(bp->classes[k].name));
+        bp->alpha = h->pred_alpha;
+        bp->tau0 = h->pred_tau0;
+        bp->predictions = h->pred_predictions;
+        bp->abs_err_sum = h->pred_abs_err_sum;
+        bp->pct_err_sum = h->pred_pct_err_sum;
+    }
+}
+
+SCHED_INLINE Metrics sched_engine(Process processes[], int n, SchedOpts opts,
+                                  ExecutionEvent events[], int *event_count,
+                                  SchedBeforeFn before) {
+    int sliced = opts.quantum > 0 || opts.preempt_on_arrival;
+    int *order = arrival_order(processes, n);
+    ArrivalCursor cur = { order, 0, 0 };
+    SchedHeap ready = { (SchedEntry*)xcalloc((size_t)n, sizeof(SchedEntry), "calloc(ready)"), 0 };
+    int completed = 0, current_time = 0, last_executed = -1;
+    RunTotals totals = {0};
+    
+    gantt_reset();
+    if(g_series.enabled) series_reset();
+    *event_count = 0;
+    
+    EngineView view = { processes, n, &cur, &ready, &totals, &current_time, &completed,
+                        &last_executed, events, event_count, opts.predictor };
+    if(g_resume && g_resume->h.stage == g_ckpt.stage && g_resume->h.n == n) {
+        checkpoint_restore(&view, g_resume);
+        snapshot_free(g_resume);
+        g_resume = NULL;
+    }
+    
+    while(completed + admission_shed_count() != n) {
+        checkpoint_tick(&view);
+        sched_admit(&cur, processes, n, current_time, &ready, opts.predictor, before);
+        
+        if(ready.size == 0) {
+            // Nothing runnable: idle until the next arrival.
+            current_time = processes[order[cur.next]].arrival_time;
+            gantt_push(-1, current_time);
+            continue;
+        }
+        
+        SchedEntry e = sched_heap_pop(&ready, before);
+        int idx = e.idx;
+        if(g_admission && admission_expired(g_admission, &processes[idx], current_time)) {
+            series_drop(current_time, processes[idx].remaining_time);
+            continue;
+        }
+        
+        series_dispatch(current_time);
+        if(!sliced) {
+            current_time = run_to_completion(processes, idx, current_time, events, event_count, &totals);
+            if(g_series.enabled) {
+                // Arrivals during the run come first in the series.
+                sched_admit(&cur, processes, n, current_time, &ready, opts.predictor, before);
+                series_stop(current_time, 0);
+            }
+            if(opts.predictor) predictor_observe(opts.predictor, &processes[idx]);
+            completed++;
+            continue;
+        }
+        
+        Process *p = &processes[idx];
+        if(idx != last_executed) {
+            log_event(events, event_count, "Executing", p, p->remaining_time, current_time, 4860 + idx);
+            totals.context_switches++;
+            last_executed = idx;
+        }
+        
+        int exec_time = p->remaining_time;
+        if(opts.quantum > 0 && exec_time > opts.quantum) exec_time = opts.quantum;
+        if(opts.preempt_on_arrival && cur.next < n) {
+            int gap = processes[order[cur.next]].arrival_time - current_time;
+            if(gap < exec_time) exec_time = gap;
+        }
+        simulate_work(exec_time);
+        
+        p->remaining_time -= exec_time;
+        current_time += exec_time;
+        gantt_push(p->pid, current_time);
+        
+        // Arrivals during the slice queue ahead of the preempted task.
+        sched_admit(&cur, processes, n, current_time, &ready, opts.predictor, before);
+        series_stop(current_time, p->remaining_time > 0);
+        
+        if(p->remaining_time == 0) {
+            complete_sliced(processes, idx, current_time, events, event_count, &totals);
+            if(opts.predictor) predictor_observe(opts.predictor, p);
+            completed++;
+            last_executed = -1;
+        } else {
+            p->ready_since = current_time;
+            e.seq = cur.seq++;
+            sched_heap_push(&ready, e, before);
+        }
+    }
+    
+    free(ready.a);
+    free(order);
+    show_gantt();
+    int admitted = n - admission_shed_count() > 0 ? n - admission_shed_count() : 1;
+    return sliced ? quantum_metrics(&totals, admitted) : nonpreemptive_metrics(&totals, admitted);
+}
+
+// Defines NAME_before(A, B): nonzero when ready entry A must run before B.
+#define SCHED_DEFINE_POLICY(NAME, BEFORE_EXPR)                                  \
+    static inline int NAME##_before(const SchedEntry *A, const SchedEntry *B) { \
+        return (BEFORE_EXPR);                                                   \
+    }
+
+// Lexicographic helpers for comparator expressions.
+#define SCHED_LT(a, b, rest)  ((a) != (b) ? (a) < (b) : (rest))
+
+SCHED_DEFINE_POLICY(fcfs,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx))
+SCHED_DEFINE_POLICY(sjf,
+    SCHED_LT(A->p->burst_time, B->p->burst_time,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx)))
+SCHED_DEFINE_POLICY(priority,
+    SCHED_LT(A->p->priority, B->p->priority,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx)))
+SCHED_DEFINE_POLICY(rr,
+    A->seq < B->seq)
+SCHED_DEFINE_POLICY(srtf,
+    SCHED_LT(A->p->remaining_time, B->p->remaining_time,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx)))
+// Aging: a task waiting w time units ranks as priority - w / g_aging.
+// Between two waiting tasks that is the same comparison at every
+// instant as priority * g_aging + ready_since, so the key never changes
+// while a task waits and no queue is ever re-sorted.
+
+#define AGED_KEY(P) ((long long)(P)->priority * g_aging + (P)->ready_since)
+
+SCHED_DEFINE_POLICY(priority_aged,
+    SCHED_LT(AGED_KEY(A->p), AGED_KEY(B->p),
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx)))
+SCHED_DEFINE_POLICY(priority_by_burst,
+    SCHED_LT(A->p->priority, B->p->priority,
+    SCHED_LT(A->p->burst_time, B->p->burst_time,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx))))
+
+// Predicted counterparts: the same orderings on predicted_burst. For SRTF
+// the predicted remaining time is the prediction minus time already run.
+#define PREDICTED_REMAINING(P) \
+    ((P)->predicted_burst - ((P)->burst_time - (P)->remaining_time) > 1 ? \
+     (P)->predicted_burst - ((P)->burst_time - (P)->remaining_time) : 1)
+
+SCHED_DEFINE_POLICY(sjf_predicted,
+    SCHED_LT(A->p->predicted_burst, B->p->predicted_burst,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx)))
+SCHED_DEFINE_POLICY(srtf_predicted,
+    SCHED_LT(PREDICTED_REMAINING(A->p), PREDICTED_REMAINING(B->p),
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx)))
+SCHED_DEFINE_POLICY(priority_predicted,
+    SCHED_LT(A->p->priority, B->p->priority,
+    SCHED_LT(A->p->predicted_burst, B->p->predicted_burst,
+    SCHED_LT(A->p->arrival_time, B->p->arrival_time, A->idx < B->idx))))
+
+static const SchedOpts RUN_TO_COMPLETION = { 0, 0, NULL };
+
+Metrics fcfs(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    return sched_engine(processes, n, RUN_TO_COMPLETION, events, event_count, fcfs_before);
+}
+
+Metrics sjf(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    return sched_engine(processes, n, RUN_TO_COMPLETION, events, event_count, sjf_before);
+}
+
+Metrics priority_scheduling(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    if(g_aging > 0) {
+        return sched_engine(processes, n, RUN_TO_COMPLETION, events, event_count, priority_aged_before);
+    }
+    return sched_engine(processes, n, RUN_TO_COMPLETION, events, event_count, priority_before);
+}
+
+// Heap-driven time slicing; round_robin() and priority_round_robin()
+// use the timing wheel below and give the same schedule.
+Metrics round_robin_heap(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
+    SchedOpts opts = { quantum, 0, NULL };
+    return sched_engine(processes, n, opts, events, event_count, rr_before);
+}
+
+Metrics priority_round_robin_heap(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
+    SchedOpts opts = { quantum, 0, NULL };
+    if(g_aging > 0) return sched_engine(processes, n, opts, events, event_count, priority_aged_before);
+    return sched_engine(processes, n, opts, events, event_count, priority_before);
+}
+
+Metrics srtf(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    SchedOpts opts = { 0, 1, NULL };
+    return sched_engine(processes, n, opts, events, event_count, srtf_before);
+}
+
+// Priority with shorter (known) bursts first inside a priority level.
+Metrics priority_by_burst(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    return sched_engine(processes, n, RUN_TO_COMPLETION, events, event_count, priority_by_burst_before);
+}
+
+Metrics sjf_predicted(Process processes[], int n, BurstPredictor *bp, ExecutionEvent events[], int* event_count) {
+    SchedOpts opts = { 0, 0, bp };
+    return sched_engine(processes, n, opts, events, event_count, sjf_predicted_before);
+}
+
+Metrics srtf_predicted(Process processes[], int n, BurstPredictor *bp, ExecutionEvent events[], int* event_count) {
+    SchedOpts opts = { 0, 1, bp };
+    return sched_engine(processes, n, opts, events, event_count, srtf_predicted_before);
+}
+
+Metrics priority_predicted(Process processes[], int n, BurstPredictor *bp, ExecutionEvent events[], int* event_count) {
+    SchedOpts opts = { 0, 0, bp };
+    return sched_engine(processes, n, opts, events, event_count, priority_predicted_before);
+}
+
+// ------------------------------------------------------------
+// Hierarchical timing wheel
+// Four levels of 256 slots cover the whole int time range. A timer sits
+// on the level of the highest base-256 digit in which its expiry differs
+// from the wheel's clock, in the slot named by that digit; when the
+// clock enters a new block of a level, that block's slot is cascaded
+// one level down. Slots are FIFO lists, so timers with equal expiry
+// fire in the order they were added. Insert and cancel are O(1);
+// finding the next expiry scans per-level occupancy bitmaps.
+// ------------------------------------------------------------
+#define TW_BITS   8
+#define TW_SLOTS  (1 << TW_BITS)
+#define TW_LEVELS 4
+#define TW_WORDS  (TW_SLOTS / 64)
+
+typedef struct {
+    int head[TW_LEVELS][TW_SLOTS];
+    int tail[TW_LEVELS][TW_SLOTS];
+    uint64_t occupied[TW_LEVELS][TW_WORDS];
+    // Per timer id.
+    int *next;
+    int *prev;
+    int *expires;
+    int *where;          // level * TW_SLOTS + slot, -1 when not armed
+    int *payload;
+    int cap;
+    int used;            // ids handed out so far
+    int *free_ids;
+    int nfree;
+    unsigned now;        // every timer expiring before now has fired
+    int count;
+} TimerWheel;
+
+void tw_init(TimerWheel *w, int cap) {
+    memset(w, 0, sizeof(*w));
+    memset(w->head, 0xff, sizeof(w->head));
+    memset(w->tail, 0xff, sizeof(w->tail));
+    w->cap = cap > 16 ? cap : 16;
+    w->next = (int*)xcalloc((size_t)w->cap, sizeof(int), "calloc(timers)");
+    w->prev = (int*)xcalloc((size_t)w->cap, sizeof(int), "calloc(timers)");
+    w->expires = (int*)xcalloc((size_t)w->cap, sizeof(int), "calloc(timers)");
+    w->where = (int*)xcalloc((size_t)w->cap, sizeof(int), "calloc(timers)");
+    w->payload = (int*)xcalloc((size_t)w->cap, sizeof(int), "calloc(timers)");
+    w->free_ids = (int*)xcalloc((size_t)w->cap, sizeof(int), "calloc(timers)");
+}
+
+void tw_free(TimerWheel *w) {
+    free(w->next);
+    free(w->prev);
+    free(w->expires);
+    free(w->where);
+    free(w->payload);
+    free(w->free_ids);
+}
+
+static void tw_grow(TimerWheel *w) {
+    int cap = w->cap * 2;
+    int **arrays[] = { &w->next, &w->prev, &w->expires, &w->where, &w->payload, &w->free_ids };
+    for(size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        int *grown = (int*)realloc(*arrays[i], (size_t)cap * sizeof(int));
+        if(!grown) {
+            perror("realloc(timers)");
+            exit(1);
+        }
+        *arrays[i] = grown;
+    }
+    w->cap = cap;
+}
+
+// Appends timer id to the slot its expiry maps to under the current clock.
+static inline void tw_link(TimerWheel *w, int id) {
+    unsigned e = (unsigned)w->expires[id];
+    unsigned diff = e ^ w->now;
+    int level = diff < (1u << 8) ? 0 : diff < (1u << 16) ? 1 : diff < (1u << 24) ? 2 : 3;
+    int slot = (int)((e >> (TW_BITS * level)) & (TW_SLOTS - 1));
+    w->where[id] = level * TW_SLOTS + slot;
+    w->next[id] = -1;
+    w->prev[id] = w->tail[level][slot];
+    if(w->tail[level][slot] < 0) w->head[level][slot] = id;
+    else w->next[w->tail[level][slot]] = id;
+    w->tail[level][slot] = id;
+    w->occupied[level][slot >> 6] |= 1ULL << (slot & 63);
+}
+
+// Arms a timer; expires must not be earlier than the wheel's clock.
+static inline int tw_add(TimerWheel *w, int expires, int payload) {
+    int id;
+    if(w->nfree > 0) {
+        id = w->free_ids[--w->nfree];
+    } else {
+        if(w->used == w->cap) tw_grow(w);
+        id = w->used++;
+    }
+    w->expires[id] = expires;
+    w->payload[id] = payload;
+    tw_link(w, id);
+    w->count++;
+    return id;
+}
+
+// Returns a fired or cancelled timer's id to the free list.
+static inline void tw_release(TimerWheel *w, int id) {
+    w->free_ids[w->nfree++] = id;
+}
+
+static inline void tw_cancel(TimerWheel *w, int id) {
+    int at = w->where[id];
+    if(at < 0) return;
+    int level = at / TW_SLOTS, slot = at % TW_SLOTS;
+    if(w->prev[id] < 0) w->head[level][slot] = w->next[id];
+    else w->next[w->prev[id]] = w->next[id];
+    if(w->next[id] < 0) w->tail[level][slot] = w->prev[id];
+    else w->prev[w->next[id]] = w->prev[id];
+    if(w->head[level][slot] < 0) w->occupied[level][slot >> 6] &= ~(1ULL << (slot & 63));
+    w->where[id] = -1;
+    w->count--;
+    tw_release(w, id);
+}
+
+// First occupied slot >= from in a level's bitmap, or -1.
+static inline int tw_find(const uint64_t *bits, int from) {
+    for(int word = from >> 6; word < TW_WORDS; word++) {
+        uint64_t b = bits[word];
+        if(word == from >> 6) b &= ~0ULL << (from & 63);
+        if(b) return word * 64 + __builtin_ctzll(b);
+    }
+    return -1;
+}
+
+static inline int tw_detach(TimerWheel *w, int level, int slot) {
+    int head = w->head[level][slot];
+    w->head[level][slot] = -1;
+    w->tail[level][slot] = -1;
+    w->occupied[level][slot >> 6] &= ~(1ULL << (slot & 63));
+    return head;
+}
+
+// Advances the clock to the earliest expiry and detaches every timer
+// due then. Returns the head of that list (walk it with w->next and
+// tw_release each id) and stores the time in *when; -1 if none is armed.
+static int tw_pop_earliest(TimerWheel *w, int *when) {
+    if(w->count == 0) return -1;
+    for(;;) {
+        int s = tw_find(w->occupied[0], (int)(w->now & (TW_SLOTS - 1)));
+        if(s >= 0) {
+            w->now = (w->now & ~(unsigned)(TW_SLOTS - 1)) | (unsigned)s;
+            int head = tw_detach(w, 0, s);
+            for(int id = head; id >= 0; id = w->next[id]) {
+                w->where[id] = -1;
+                w->count--;
+            }
+            *when = (int)w->now;
+            return head;
+        }
+        // Level 0 is exhausted: enter the next occupied block above it.
+        int level = 1;
+        for(; level < TW_LEVELS; level++) {
+            int shift = TW_BITS * level;
+            int digit = (int)((w->now >> shift) & (TW_SLOTS - 1));
+            if(digit + 1 >= TW_SLOTS) continue;
+            int slot = tw_find(w->occupied[level], digit + 1);
+            if(slot < 0) continue;
+            unsigned high = level + 1 < TW_LEVELS ? w->now >> (shift + TW_BITS) << (shift + TW_BITS) : 0;
+            w->now = high | ((unsigned)slot << shift);
+            for(int id = tw_detach(w, level, slot), after; id >= 0; id = after) {
+                after = w->next[id];
+                tw_link(w, id);
+            }
+            break;
+        }
+        if(level == TW_LEVELS) return -1;   // unreachable while count > 0
+    }
+}
+
+// ------------------------------------------------------------
+// Timer-driven round robin
+// Arrivals and slice expiries are timers on the wheel; the ready queue
+// is a FIFO per priority level, so no heap is involved. Round robin
+// uses a single level. Priority RR keeps the engine's order (priority,
+// arrival, index): arrivals join the back of their level and a
+// preempted task, which was its level's earliest, rejoins the front.
+// ------------------------------------------------------------
+#define TIMED_MAX_LEVELS (1 << 16)
+
+static Metrics timed_rr_engine(Process processes[], int n, int quantum, int by_priority,
+                               ExecutionEvent events[], int *event_count) {
+    int minp = 0, nlevels = 1;
+    if(by_priority) {
+        int maxp = processes[0].priority;
+        minp = processes[0].priority;
+        for(int i = 1; i < n; i++) {
+            if(processes[i].priority < minp) minp = processes[i].priority;
+            if(processes[i].priority > maxp) maxp = processes[i].priority;
+        }
+        nlevels = maxp - minp + 1;
+    }
+    int nwords = (nlevels + 63) / 64;
+    int *qhead = (int*)xcalloc((size_t)nlevels, sizeof(int), "calloc(levels)");
+    int *qtail = (int*)xcalloc((size_t)nlevels, sizeof(int), "calloc(levels)");
+    uint64_t *nonempty = (uint64_t*)xcalloc((size_t)nwords, sizeof(uint64_t), "calloc(levels)");
+    int *qnext = (int*)xcalloc((size_t)n, sizeof(int), "calloc(ready)");
+    memset(qhead, 0xff, (size_t)nlevels * sizeof(int));
+    memset(qtail, 0xff, (size_t)nlevels * sizeof(int));
+
+    int *order = arrival_order(processes, n);
+    TimerWheel w;
+    tw_init(&w, n + 1);
+    for(int k = 0; k < n; k++) {
+        tw_add(&w, processes[order[k]].arrival_time, order[k]);
+    }
+    // The CPU idles until the first arrival, as in the other engines.
+    int idle = n > 0 && processes[order[0]].arrival_time > 0;
+    free(order);
+
+    RunTotals totals = {0};
+    int completed = 0, running = -1, slice_len = 0, last_executed = -1, ready = 0;
+
+    gantt_reset();
+    *event_count = 0;
+
+    while(completed != n) {
+        int t;
+        int head = tw_pop_earliest(&w, &t);
+        if(head < 0) break;
+        if(idle) {
+            gantt_push(-1, t);
+            idle = 0;
+        }
+
+        // Arrivals due now queue ahead of a task whose slice ends now.
+        int expired = -1;
+        for(int id = head, after; id >= 0; id = after) {
+            after = w.next[id];
+            int i = w.payload[id];
+            tw_release(&w, id);
+            if(i < 0) {
+                expired = running;
+                continue;
+            }
+            int lv = processes[i].priority - minp;
+            if(!by_priority) lv = 0;
+            qnext[i] = -1;
+            if(qtail[lv] < 0) qhead[lv] = i;
+            else qnext[qtail[lv]] = i;
+            qtail[lv] = i;
+            nonempty[lv >> 6] |= 1ULL << (lv & 63);
+            ready++;
+        }
+
+        if(expired >= 0) {
+            Process *p = &processes[expired];
+            p->remaining_time -= slice_len;
+            gantt_push(p->pid, t);
+            running = -1;
+            if(p->remaining_time == 0) {
+                complete_sliced(processes, expired, t, events, event_count, &totals);
+                completed++;
+                last_executed = -1;
+            } else {
+                int lv = by_priority ? p->priority - minp : 0;
+                if(by_priority) {
+                    qnext[expired] = qhead[lv];
+                    qhead[lv] = expired;
+                    if(qtail[lv] < 0) qtail[lv] = expired;
+                } else {
+                    qnext[expired] = -1;
+                    if(qtail[lv] < 0) qhead[lv] = expired;
+                    else qnext[qtail[lv]] = expired;
+                    qtail[lv] = expired;
+                }
+                nonempty[lv >> 6] |= 1ULL << (lv & 63);
+                ready++;
+            }
+        }
+
+        if(running >= 0) continue;
+        if(ready == 0) {
+            idle = 1;   // the next timer is an arrival
+            continue;
+        }
+
+        int lv = 0;
+        for(int word = 0; word < nwords; word++) {
+            if(nonempty[word]) {
+                lv = word * 64 + __builtin_ctzll(nonempty[word]);
+                break;
+            }
+        }
+        int idx = qhead[lv];
+        qhead[lv] = qnext[idx];
+        if(qhead[lv] < 0) {
+            qtail[lv] = -1;
+            nonempty[lv >> 6] &= ~(1ULL << (lv & 63));
+        }
+        ready--;
+
+        Process *p = &processes[idx];
+        if(idx != last_executed) {
+            log_event(events, event_count, "Executing", p, p->remaining_time, t, 4860 + idx);
+            totals.context_switches++;
+            last_executed = idx;
+        }
+        slice_len = p->remaining_time > quantum ? quantum : p->remaining_time;
+        simulate_work(slice_len);
+        running = idx;
+        tw_add(&w, t + slice_len, -1);
+    }
+
+    tw_free(&w);
+    free(qnext);
+    free(nonempty);
+    free(qtail);
+    free(qhead);
+    show_gantt();
+    return quantum_metrics(&totals, n);
+}
+
+// Snapshots capture the heap engine's state, so checkpointed or resumed
+// runs stay on it.
+static int checkpointing(void) {
+    return (g_ckpt.every > 0 && g_ckpt.stage > 0) || g_resume != NULL;
+}
+
+Metrics round_robin(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
+    if(checkpointing() || g_series.enabled || g_admission) {
+        return round_robin_heap(processes, n, quantum, events, event_count);
+    }
+    return timed_rr_engine(processes, n, quantum, 0, events, event_count);
+}
+
+Metrics priority_round_robin(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
+    // Aged priorities are not fixed levels, so aging needs the heap; the
+    // time series and admission control only hook the heap engine.
+    if(checkpointing() || g_aging > 0 || g_series.enabled || g_admission) {
+        return priority_round_robin_heap(processes, n, quantum, events, event_count);
+    }
+    // A very wide priority range would need too many levels.
+    long long lo = INT_MAX, hi = INT_MIN;
+    for(int i = 0; i < n; i++) {
+        if(processes[i].priority < lo) lo = processes[i].priority;
+        if(processes[i].priority > hi) hi = processes[i].priority;
+    }
+    if(n > 0 && hi - lo >= TIMED_MAX_LEVELS) {
+        return priority_round_robin_heap(processes, n, quantum, events, event_count);
+    }
+    return timed_rr_engine(processes, n, quantum, 1, events, event_count);
+}
+
+// ------------------------------------------------------------
+// Reference policies
+// The original O(n) scan-per-decision implementations, kept as oracles
+// for the engine above. They step through idle time one tick at a time
+// (the ticks merge into one IDLE Gantt segment) and fcfs_reference()
+// sorts processes[] in place; otherwise decisions match the engine exactly.
+// ------------------------------------------------------------
+Metrics fcfs_reference(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    // Sort by arrival time
+    for(int i = 0; i < n - 1; i++) {
+        for(int j = 0; j < n - i - 1; j++) {
+            if(processes[j].arrival_time > processes[j+1].arrival_time) {
+                Process temp = processes[j];
+                processes[j] = processes[j+1];
+                processes[j+1] = temp;
+            }
+        }
+    }
+    
+    int current_time = 0;
+    RunTotals totals = {0};
+    
+    gantt_reset();
+    *event_count = 0;
+    
+    for(int i = 0; i < n; i++) {
+        if(current_time < processes[i].arrival_time) {
+            gantt_push(-1, processes[i].arrival_time);
+            current_time = processes[i].arrival_time;
+        }
+        current_time = run_to_completion(processes, i, current_time, events, event_count, &totals);
+    }
+    
+    show_gantt();
+    return nonpreemptive_metrics(&totals, n);
+}
+
+Metrics sjf_reference(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    int current_time = 0;
+    int completed = 0;
+    char *is_completed = (char*)xcalloc((size_t)n, 1, "calloc(is_completed)");
+    RunTotals totals = {0};
+    
+    gantt_reset();
+    *event_count = 0;
+    
+    while(completed != n) {
+        int min_burst = 999999;
+        int min_index = -1;
+        
+        for(int i = 0; i < n; i++) {
+            if(processes[i].arrival_time <= current_time && !is_completed[i]) {
+                if(processes[i].burst_time < min_burst) {
+                    min_burst = processes[i].burst_time;
+                    min_index = i;
+                }
+                else if(processes[i].burst_time == min_burst) {
+                    if(processes[i].arrival_time < processes[min_index].arrival_time) {
+                        min_index = i;
+                    }
+                }
+            }
+        }
+        
+        if(min_index == -1) {
+            gantt_push(-1, current_time + 1);
+            current_time++;
+        } else {
+            current_time = run_to_completion(processes, min_index, current_time, events, event_count, &totals);
+            is_completed[min_index] = 1;
+            completed++;
+        }
+    }
+    
+    free(is_completed);
+    show_gantt();
+    return nonpreemptive_metrics(&totals, n);
+}
+
+Metrics priority_scheduling_reference(Process processes[], int n, ExecutionEvent events[], int* event_count) {
+    int current_time = 0;
+    int completed = 0;
+    char *is_completed = (char*)xcalloc((size_t)n, 1, "calloc(is_completed)");
+    RunTotals totals = {0};
+    
+    gantt_reset();
+    *event_count = 0;
+    
+    while(completed != n) {
+        int highest_priority = 999999;
+        int min_index = -1;
+        
+        for(int i = 0; i < n; i++) {
+            if(processes[i].arrival_time <= current_time && !is_completed[i]) {
+                if(processes[i].priority < highest_priority) {
+                    highest_priority = processes[i].priority;
+                    min_index = i;
+                }
+                else if(processes[i].priority == highest_priority) {
+                    if(min_index == -1 || processes[i].arrival_time < processes[min_index].arrival_time) {
+                        min_index = i;
+                    }
+                }
+            }
+        }
+        
+        if(min_index == -1) {
+            gantt_push(-1, current_time + 1);
+            current_time++;
+        } else {
+            current_time = run_to_completion(processes, min_index, current_time, events, event_count, &totals);
+            is_completed[min_index] = 1;
+            completed++;
+        }
+    }
+    
+    free(is_completed);
+    show_gantt();
+    return nonpreemptive_metrics(&totals, n);
+}
+
+Metrics round_robin_reference(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
+    int current_time = 0;
+    int completed = 0;
+    RunTotals totals = {0};
+    
+    gantt_reset();
+    *event_count = 0;
+    
+    // Each process is queued at most once at a time, so a ring of n slots suffices.
+    int *queue = (int*)xcalloc((size_t)n, sizeof(int), "calloc(queue)");
+    int front = 0, rear = 0, queued = 0;
+    char *in_queue = (char*)xcalloc((size_t)n, 1, "calloc(in_queue)");
+    int last_executed = -1;
+    
+    for(int i = 0; i < n; i++) {
+        if(processes[i].arrival_time == 0) {
+            queue[rear] = i; rear = (rear + 1) % n; queued++;
+            in_queue[i] = 1;
+        }
+    }
+    
+    while(completed != n) {
+        if(queued == 0) {
+            gantt_push(-1, current_time + 1);
             current_time++;
             for(int i = 0; i < n; i++) {
                 if(processes[i].arrival_time <= current_time && !in_queue[i] && processes[i].remaining_time > 0) {
-                    queue[rear++] = i;
+                    queue[rear] = i; rear = (rear + 1) % n; queued++;
                     in_queue[i] = 1;
                 }
             }
             continue;
         }
-        
-        int idx = queue[front++];
-        
-        if(idx != last_executed) {
-            strcpy(events[*event_count].event_type, "Executing");
-            strcpy(events[*event_count].task_name, processes[idx].name);
-            events[*event_count].burst_time = processes[idx].remaining_time;
-            events[*event_count].time = current_time;
-            events[*event_count].pid = 4860 + idx;
-            (*event_count)++;
-            context_switches++;
-            last_executed = idx;
+        
+        int idx = queue[front];
+        front = (front + 1) % n; queued--;
+        
+        if(idx != last_executed) {
+            log_event(events, event_count, "Executing", &processes[idx], processes[idx].remaining_time, current_time, 4860 + idx);
+            totals.context_switches++;
+            last_executed = idx;
+        }
+        
+        int exec_time = (processes[idx].remaining_time > quantum) ? quantum : processes[idx].remaining_time;
+        simulate_work(exec_time);
+        
+        processes[idx].remaining_time -= exec_time;
+        current_time += exec_time;
+        
+        gantt_push(processes[idx].pid, current_time);
+        
+        for(int i = 0; i < n; i++) {
+            if(processes[i].arrival_time <= current_time && !in_queue[i] && processes[i].remaining_time > 0) {
+                queue[rear] = i; rear = (rear + 1) % n; queued++;
+                in_queue[i] = 1;
+            }
+        }
+        
+        if(processes[idx].remaining_time == 0) {
+            complete_sliced(processes, idx, current_time, events, event_count, &totals);
+            completed++;
+            last_executed = -1;
+        } else {
+            queue[rear] = idx; rear = (rear + 1) % n; queued++;
+        }
+    }
+    
+    free(queue);
+    free(in_queue);
+    show_gantt();
+    return quantum_metrics(&totals, n);
+}
+
+Metrics priority_round_robin_reference(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
+    int current_time = 0;
+    int completed = 0;
+    RunTotals totals = {0};
+    int last_executed = -1;
+    
+    gantt_reset();
+    *event_count = 0;
+    
+    while(completed != n) {
+        int highest_priority = 999999;
+        int min_index = -1;
+        
+        for(int i = 0; i < n; i++) {
+            if(processes[i].arrival_time <= current_time && processes[i].remaining_time > 0) {
+                if(processes[i].priority < highest_priority) {
+                    highest_priority = processes[i].priority;
+                    min_index = i;
+                }
+                else if(processes[i].priority == highest_priority) {
+                    if(min_index == -1 || processes[i].arrival_time < processes[min_index].arrival_time) {
+                        min_index = i;
+                    }
+                }
+            }
+        }
+        
+        if(min_index == -1) {
+            gantt_push(-1, current_time + 1);
+            current_time++;
+        } else {
+            if(min_index != last_executed) {
+                log_event(events, event_count, "Executing", &processes[min_index], processes[min_index].remaining_time, current_time, 4860 + min_index);
+                totals.context_switches++;
+                last_executed = min_index;
+            }
+            
+            int exec_time = (processes[min_index].remaining_time > quantum) ? quantum : processes[min_index].remaining_time;
+            simulate_work(exec_time);
+            
+            processes[min_index].remaining_time -= exec_time;
+            current_time += exec_time;
+            
+            gantt_push(processes[min_index].pid, current_time);
+            
+            if(processes[min_index].remaining_time == 0) {
+                complete_sliced(processes, min_index, current_time, events, event_count, &totals);
+                completed++;
+                last_executed = -1;
+            }
+        }
+    }
+    
+    show_gantt();
+    return quantum_metrics(&totals, n);
+}
+
+// ------------------------------------------------------------
+// Online job submission daemon (--daemon=PATH)
+// Clients connect to a Unix stream socket and send one job per line:
+//   J <job_id> <name> <arrival> <burst> <priority>   submit a job
+//   D                                               drain: answer all my jobs
+// and receive the dispatch decisions for their own jobs:
+//   S <job_id> <start> <end>                        one CPU slice
+//   C <job_id> <completion> <turnaround> <waiting>  job finished
+//   E <message>                                     malformed request
+// Time is simulated. A decision at time t is only taken once a
+// submission with a later arrival has been seen, so every job that
+// arrives by t is known; jobs submitted with an arrival that is already
+// in the past are admitted at the current clock. A client that sends D
+// or hangs up is answered as the watermark passes its jobs; the daemon
+// runs past the watermark only once every connected client has done so.
+// All readable sockets are drained in one batch per epoll_wait() and
+// the policy is advanced once per batch.
+// ------------------------------------------------------------
+typedef enum {
+    POLICY_FCFS,
+    POLICY_SJF,
+    POLICY_PRIORITY,
+    POLICY_RR,
+    POLICY_PRIORITY_RR,
+    POLICY_COUNT
+} PolicyId;
+
+static const char *POLICY_NAMES[POLICY_COUNT] = {"fcfs", "sjf", "priority", "rr", "priority_rr"};
+
+int policy_from_name(const char *name) {
+    for(int i = 0; i < POLICY_COUNT; i++) {
+        if(strcmp(POLICY_NAMES[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+#define ONLINE_CHUNK_SHIFT 12
+#define ONLINE_CHUNK       (1 << ONLINE_CHUNK_SHIFT)
+
+typedef struct {
+    Process proc;
+    long long job_id;
+    int client;          // index into the daemon's client table
+    unsigned client_gen; // client slot generation; stale once the client is gone
+} OnlineJob;
+
+typedef struct {
+    // Job slots live in fixed chunks so SchedEntry.p stays valid as we grow.
+    OnlineJob **chunks;
+    int nchunks;
+    int next_slot;
+    int *free_slots;
+    int nfree;
+    int free_cap;
+
+    SchedHeap ready;
+    int ready_cap;
+    SchedEntry *pending;   // submitted but not yet arrived, min-heap by arrival
+    int npending;
+    int pending_cap;
+
+    PolicyId policy;
+    int quantum;
+    int clock;
+    int watermark;         // latest arrival seen so far
+    SchedEntry parked;     // RR slice that ended past the known arrivals
+    int has_parked;
+    unsigned seq;
+    unsigned submit_seq;
+
+    long long submitted;
+    long long completed;
+    long long decisions;
+} OnlineSched;
+
+static inline OnlineJob* online_job(OnlineSched *s, int slot) {
+    return &s->chunks[slot >> ONLINE_CHUNK_SHIFT][slot & (ONLINE_CHUNK - 1)];
+}
+
+static int online_alloc_slot(OnlineSched *s) {
+    if(s->nfree > 0) return s->free_slots[--s->nfree];
+    if((s->next_slot >> ONLINE_CHUNK_SHIFT) == s->nchunks) {
+        OnlineJob **grown = (OnlineJob**)realloc(s->chunks, (size_t)(s->nchunks + 1) * sizeof(*grown));
+        if(!grown) return -1;
+        s->chunks = grown;
+        s->chunks[s->nchunks] = (OnlineJob*)calloc(ONLINE_CHUNK, sizeof(OnlineJob));
+        if(!s->chunks[s->nchunks]) return -1;
+        s->nchunks++;
+    }
+    return s->next_slot++;
+}
+
+static void online_free_slot(OnlineSched *s, int slot) {
+    if(s->nfree == s->free_cap) {
+        int cap = s->free_cap ? s->free_cap * 2 : 1024;
+        int *grown = (int*)realloc(s->free_slots, (size_t)cap * sizeof(int));
+        if(!grown) return;   // slot leaks, scheduling is unaffected
+        s->free_slots = grown;
+        s->free_cap = cap;
+    }
+    s->free_slots[s->nfree++] = slot;
+}
+
+static int grow_entries(SchedEntry **a, int *cap, int need) {
+    if(need <= *cap) return 0;
+    int new_cap = *cap ? *cap : 1024;
+    while(new_cap < need) new_cap *= 2;
+    SchedEntry *grown = (SchedEntry*)realloc(*a, (size_t)new_cap * sizeof(SchedEntry));
+    if(!grown) return -1;
+    *a = grown;
+    *cap = new_cap;
+    return 0;
+}
+
+// Pending arrivals: (arrival, submission order).
+static inline int pending_before(const SchedEntry *a, const SchedEntry *b) {
+    return SCHED_LT(a->p->arrival_time, b->p->arrival_time, a->seq < b->seq);
+}
+
+typedef void (*OnlineEmitFn)(void *ctx, const OnlineJob *job, char kind, int a, int b, int c);
+
+SCHED_INLINE void online_admit(OnlineSched *s, SchedBeforeFn before) {
+    while(s->npending > 0 && s->pending[0].p->arrival_time <= s->clock) {
+        SchedHeap ph = { s->pending, s->npending };
+        SchedEntry e = sched_heap_pop(&ph, pending_before);
+        s->npending = ph.size;
+        e.seq = s->seq++;
+        sched_heap_push(&s->ready, e, before);
+    }
+}
+
+// Takes every decision that is safe with arrivals known up to `until`.
+SCHED_INLINE void online_advance(OnlineSched *s, int until, SchedBeforeFn before,
+                                 OnlineEmitFn emit, void *ctx) {
+    for(;;) {
+        online_admit(s, before);
+        if(s->clock > until) return;
+        if(s->has_parked) {
+            // Arrivals up to the end of its slice are known now.
+            s->parked.seq = s->seq++;
+            sched_heap_push(&s->ready, s->parked, before);
+            s->has_parked = 0;
+        }
+        if(s->ready.size == 0) {
+            if(s->npending == 0) return;
+            int next = s->pending[0].p->arrival_time;
+            if(next > until) return;
+            s->clock = next;
+            continue;
+        }
+
+        SchedEntry e = sched_heap_pop(&s->ready, before);
+        OnlineJob *job = (OnlineJob*)(void*)e.p;
+        Process *p = &job->proc;
+        int exec_time = (s->quantum > 0 && p->remaining_time > s->quantum) ? s->quantum : p->remaining_time;
+        int start = s->clock;
+
+        s->clock += exec_time;
+        p->remaining_time -= exec_time;
+        s->decisions++;
+        emit(ctx, job, 'S', start, s->clock, 0);
+
+        if(s->quantum > 0) online_admit(s, before);
+
+        if(p->remaining_time == 0) {
+            p->completion_time = s->clock;
+            p->turnaround_time = p->completion_time - p->arrival_time;
+            p->waiting_time = p->turnaround_time - p->burst_time;
+            emit(ctx, job, 'C', p->completion_time, p->turnaround_time, p->waiting_time);
+            s->completed++;
+            online_free_slot(s, e.idx);
+        } else if(s->clock > until) {
+            // Arrivals in (until, clock] are not all in yet; they queue first.
+            s->parked = e;
+            s->has_parked = 1;
+        } else {
+            e.seq = s->seq++;
+            sched_heap_push(&s->ready, e, before);
+        }
+    }
+}
+
+static void online_advance_policy(OnlineSched *s, int until, OnlineEmitFn emit, void *ctx) {
+    switch(s->policy) {
+        case POLICY_FCFS:        online_advance(s, until, fcfs_before, emit, ctx); break;
+        case POLICY_SJF:         online_advance(s, until, sjf_before, emit, ctx); break;
+        case POLICY_PRIORITY:
+        case POLICY_PRIORITY_RR: online_advance(s, until, priority_before, emit, ctx); break;
+        case POLICY_RR:          online_advance(s, until, rr_before, emit, ctx); break;
+        default: break;
+    }
+}
+
+static int online_submit(OnlineSched *s, long long job_id, const char *name, int arrival,
+                         int burst, int priority, int client, unsigned client_gen) {
+    // Every live job can end up in either heap.
+    int live = s->ready.size + s->npending + s->has_parked + 1;
+    if(grow_entries(&s->ready.a, &s->ready_cap, live) != 0 ||
+        grow_entries(&s->pending, &s->pending_cap, live) != 0) {
+        return -1;
+    }
+    int slot = online_alloc_slot(s);
+    if(slot < 0) return -1;
+    OnlineJob *job = online_job(s, slot);
+    memset(job, 0, sizeof(*job));
+    job->job_id = job_id;
+    job->client = client;
+    job->client_gen = client_gen;
+    job->proc.pid = (int)(job_id & INT_MAX);
+    snprintf(job->proc.name, sizeof(job->proc.name), "%s", name);
+    job->proc.arrival_time = arrival < s->clock ? s->clock : arrival;
+    job->proc.burst_time = burst;
+    job->proc.remaining_time = burst;
+    job->proc.priority = priority;
+    job->proc.first_run = -1;
+
+    SchedEntry e = { &job->proc, slot, s->submit_seq++ };
+    SchedHeap ph = { s->pending, s->npending };
+    sched_heap_push(&ph, e, pending_before);
+    s->npending = ph.size;
+    if(arrival > s->watermark) s->watermark = arrival;
+    s->submitted++;
+    return 0;
+}
+
+static void online_free(OnlineSched *s) {
+    for(int i = 0; i < s->nchunks; i++) free(s->chunks[i]);
+    free(s->chunks);
+    free(s->free_slots);
+    free(s->ready.a);
+    free(s->pending);
+}
+
+// ---- Socket side ----
+#define DAEMON_MAX_EVENTS 64
+#define DAEMON_IN_CAP     65536
+
+#define DAEMON_READS_PER_BATCH 4
+
+typedef struct {
+    int fd;              // -1 when the slot is unused
+    unsigned gen;        // bumped each time the slot is reused
+    int closing;         // peer hung up: answer its jobs, then close
+    int draining;        // sent D: answer its jobs past the watermark
+    long long live;      // submitted jobs not yet completed
+    char in[DAEMON_IN_CAP];
+    size_t in_len;
+    char *out;
+    size_t out_len;
+    size_t out_cap;
+    uint32_t registered;   // epoll events currently requested
+} DaemonClient;
+
+typedef struct {
+    int epfd;
+    DaemonClient **clients;
+    int nclients;
+    long long batch_start_us;
+    long long latency_sum_us;
+    long long latency_max_us;
+    long long latency_samples;
+} Daemon;
+
+static volatile sig_atomic_t g_daemon_stop = 0;
+
+static void daemon_on_signal(int sig) {
+    (void)sig;
+    g_daemon_stop = 1;
+}
+
+static void client_append(DaemonClient *c, const char *s, size_t n) {
+    if(c->out_len + n > c->out_cap) {
+        size_t cap = c->out_cap ? c->out_cap : 4096;
+        while(cap < c->out_len + n) cap *= 2;
+        char *grown = (char*)realloc(c->out, cap);
+        if(!grown) return;
+        c->out = grown;
+        c->out_cap = cap;
+    }
+    memcpy(c->out + c->out_len, s, n);
+    c->out_len += n;
+}
+
+static void daemon_emit(void *ctx, const OnlineJob *job, char kind, int a, int b, int c) {
+    Daemon *d = (Daemon*)ctx;
+    long long lat = get_time_microseconds() - d->batch_start_us;
+    d->latency_sum_us += lat;
+    d->latency_samples++;
+    if(lat > d->latency_max_us) d->latency_max_us = lat;
+
+    DaemonClient *cl = d->clients[job->client];
+    if(cl->fd < 0 || cl->gen != job->client_gen) return;
+    if(kind == 'C') cl->live--;
+
+    char line[96];
+    int len = 0;
+    line[len++] = kind;
+    line[len++] = ' ';
+    len += fmt_i64(line + len, job->job_id);
+    line[len++] = ' ';
+    len += fmt_i64(line + len, a);
+    line[len++] = ' ';
+    len += fmt_i64(line + len, b);
+    if(kind == 'C') {
+        line[len++] = ' ';
+        len += fmt_i64(line + len, c);
+    }
+    line[len++] = '\n';
+    client_append(cl, line, (size_t)len);
+}
+
+static void daemon_close_client(Daemon *d, int ci) {
+    DaemonClient *c = d->clients[ci];
+    epoll_ctl(d->epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    c->fd = -1;
+    c->closing = 0;
+    c->draining = 0;
+    c->live = 0;
+    c->in_len = 0;
+    c->out_len = 0;
+}
+
+static void daemon_flush_client(Daemon *d, int ci) {
+    DaemonClient *c = d->clients[ci];
+    size_t off = 0;
+    while(off < c->out_len) {
+        ssize_t w = write(c->fd, c->out + off, c->out_len - off);
+        if(w > 0) {
+            off += (size_t)w;
+        } else if(w < 0 && errno == EINTR) {
+            continue;
+        } else if(w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            daemon_close_client(d, ci);
+            return;
+        }
+    }
+    memmove(c->out, c->out + off, c->out_len - off);
+    c->out_len -= off;
+
+    if(c->closing && c->out_len == 0 && c->live == 0) {
+        daemon_close_client(d, ci);
+        return;
+    }
+    uint32_t events = (c->closing ? 0 : EPOLLIN) | (c->out_len > 0 ? EPOLLOUT : 0);
+    if(events != c->registered) {
+        // A hung-up peer waiting for its jobs leaves the set entirely,
+        // or EPOLLHUP would wake every epoll_wait().
+        struct epoll_event ev;
+        ev.events = events;
+        ev.data.u32 = (uint32_t)ci + 1;
+        int op = events == 0 ? EPOLL_CTL_DEL : c->registered == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        epoll_ctl(d->epfd, op, c->fd, &ev);
+        c->registered = events;
+    }
+}
+
+// Parses complete lines in the client's buffer.
+static void daemon_parse(Daemon *d, OnlineSched *s, int ci) {
+    DaemonClient *c = d->clients[ci];
+    size_t start = 0;
+    for(size_t i = 0; i < c->in_len; i++) {
+        if(c->in[i] != '\n') continue;
+        c->in[i] = '\0';
+        char *line = c->in + start;
+        start = i + 1;
+
+        if(line[0] == 'D' && (line[1] == '\0' || line[1] == '\r')) {
+            c->draining = 1;
+            continue;
+        }
+        long long job_id;
+        char name[100];
+        int arrival, burst, priority;
+        if(line[0] == 'J' &&
+            sscanf(line + 1, "%lld %99s %d %d %d", &job_id, name, &arrival, &burst, &priority) == 5 &&
+            arrival >= 0 && burst > 0) {
+            if(online_submit(s, job_id, name, arrival, burst, priority, ci, c->gen) != 0) {
+                client_append(c, "E out of memory\n", 16);
+            } else {
+                c->live++;
+            }
+        } else if(line[0] != '\0' && line[0] != '\r') {
+            client_append(c, "E bad request\n", 14);
+        }
+    }
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+    if(c->in_len == DAEMON_IN_CAP) {
+        client_append(c, "E line too long\n", 16);
+        c->in_len = 0;
+    }
+}
+
+// The decision horizon: the watermark, or everything once no connected
+// client can still submit an earlier arrival.
+static int daemon_until(const Daemon *d, const OnlineSched *s) {
+    for(int ci = 0; ci < d->nclients; ci++) {
+        const DaemonClient *c = d->clients[ci];
+        if(c->fd >= 0 && !c->closing && !c->draining) return s->watermark - 1;
+    }
+    return INT_MAX;
+}
+
+static int daemon_add_client(Daemon *d, int fd) {
+    int ci = -1;
+    for(int i = 0; i < d->nclients; i++) {
+        if(d->clients[i]->fd < 0) {
+            ci = i;
+            break;
+        }
+    }
+    if(ci < 0) {
+        DaemonClient **grown = (DaemonClient**)realloc(d->clients, (size_t)(d->nclients + 1) * sizeof(*grown));
+        if(!grown) return -1;
+        d->clients = grown;
+        d->clients[d->nclients] = (DaemonClient*)calloc(1, sizeof(DaemonClient));
+        if(!d->clients[d->nclients]) return -1;
+        ci = d->nclients++;
+    }
+    DaemonClient *c = d->clients[ci];
+    c->fd = fd;
+    c->gen++;
+    c->closing = 0;
+    c->draining = 0;
+    c->live = 0;
+    c->in_len = 0;
+    c->out_len = 0;
+    c->registered = EPOLLIN;
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)ci + 1;
+    if(epoll_ctl(d->epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        c->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+int run_daemon(const char *path, PolicyId policy, int quantum) {
+    int lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(lfd < 0) {
+        perror("socket");
+        return 1;
+    }
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if(strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path too long: %s\n", path);
+        close(lfd);
+        return 1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if(bind(lfd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(lfd, 128) != 0) {
+        perror("bind/listen");
+        close(lfd);
+        return 1;
+    }
+
+    Daemon d;
+    memset(&d, 0, sizeof(d));
+    d.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if(d.epfd < 0) {
+        perror("epoll_create1");
+        close(lfd);
+        return 1;
+    }
+    struct epoll_event lev;
+    lev.events = EPOLLIN;
+    lev.data.u32 = 0;
+    epoll_ctl(d.epfd, EPOLL_CTL_ADD, lfd, &lev);
+
+    OnlineSched s;
+    memset(&s, 0, sizeof(s));
+    s.policy = policy;
+    s.quantum = (policy == POLICY_RR || policy == POLICY_PRIORITY_RR) ? quantum : 0;
+
+    signal(SIGINT, daemon_on_signal);
+    signal(SIGTERM, daemon_on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "scheduler daemon: policy=%s quantum=%d socket=%s\n",
+            POLICY_NAMES[policy], s.quantum, path);
+    long long started_us = get_time_microseconds();
+
+    struct epoll_event evs[DAEMON_MAX_EVENTS];
+    while(!g_daemon_stop) {
+        int ne = epoll_wait(d.epfd, evs, DAEMON_MAX_EVENTS, 200);
+        if(ne < 0) {
+            if(errno == EINTR) continue;
+            perror("epoll_wait");
+            break;
+        }
+        d.batch_start_us = get_time_microseconds();
+
+        for(int k = 0; k < ne; k++) {
+            uint32_t tag = evs[k].data.u32;
+            if(tag == 0) {
+                for(;;) {
+                    int cfd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if(cfd < 0) break;
+                    if(daemon_add_client(&d, cfd) != 0) close(cfd);
+                }
+                continue;
+            }
+            int ci = (int)tag - 1;
+            DaemonClient *c = d.clients[ci];
+            if(c->fd < 0) continue;
+            if(evs[k].events & EPOLLOUT) daemon_flush_client(&d, ci);
+            if(c->fd < 0 || c->closing || !(evs[k].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) continue;
+
+            // Bounded reads per client keep one busy sender from delaying decisions.
+            for(int reads = 0; reads < DAEMON_READS_PER_BATCH; reads++) {
+                ssize_t r = read(c->fd, c->in + c->in_len, DAEMON_IN_CAP - c->in_len);
+                if(r > 0) {
+                    c->in_len += (size_t)r;
+                    daemon_parse(&d, &s, ci);
+                    continue;
+                }
+                if(r < 0 && errno == EINTR) continue;
+                if(r == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    // Stay connected until its own jobs are answered.
+                    c->closing = 1;
+                }
+                break;
+            }
+        }
+
+        // One policy step per batch: decide everything the known arrivals allow.
+        online_advance_policy(&s, daemon_until(&d, &s), daemon_emit, &d);
+
+        for(int ci = 0; ci < d.nclients; ci++) {
+            DaemonClient *c = d.clients[ci];
+            if(c->fd >= 0 && c->live == 0) c->draining = 0;
+            if(c->fd >= 0 && (c->out_len > 0 || c->closing)) daemon_flush_client(&d, ci);
+        }
+    }
+
+    double elapsed_s = (get_time_microseconds() - started_us) / 1000000.0;
+    fprintf(stderr, "\n== Daemon Summary ==\n");
+    fprintf(stderr, "Submissions: %lld (%.0f/s)\n", s.submitted, elapsed_s > 0 ? s.submitted / elapsed_s : 0.0);
+    fprintf(stderr, "Decisions: %lld | Completed: %lld | Pending: %lld\n",
+            s.decisions, s.completed, s.submitted - s.completed);
+    fprintf(stderr, "Decision latency: avg %.1f us | max %lld us\n",
+            d.latency_samples ? (double)d.latency_sum_us / d.latency_samples : 0.0, d.latency_max_us);
+
+    for(int ci = 0; ci < d.nclients; ci++) {
+        if(d.clients[ci]->fd >= 0) close(d.clients[ci]->fd);
+        free(d.clients[ci]->out);
+        free(d.clients[ci]);
+    }
+    free(d.clients);
+    online_free(&s);
+    close(d.epfd);
+    close(lfd);
+    unlink(path);
+    return 0;
+}
+
+// ------------------------------------------------------------
+// Multi-CPU placement with a cache-warmth cost model
+// Each CPU has its own ready queue ordered by the policy. A task's
+// working set decays on a CPU with a half-life once it stops running
+// there; dispatching it charges the refill of the cold part:
+//   refill_us = working_set_kb * refill_us_per_kb * (1 - warmth)
+//   warmth    = 2^(-(now - last run on this CPU) / half_life)
+// The refill delays the slice by refill_us rounded to time units.
+// Placement: arrivals go to the least-loaded CPU. A preempted task is
+// requeued on the least-loaded CPU (balanced) or on the CPU it just ran
+// on (affinity). An idle CPU with an empty queue steals the best task
+// of the most loaded queue in both modes.
+// CPUs may run at different speeds: a slice of w work units takes
+// ceil(w / speed) time units. The speed-aware placements measure load
+// as work / speed and let faster CPUs dispatch and steal first:
+//   SMP_FASTEST_IDLE    arrivals go to the fastest idle CPU, if any
+//   SMP_LARGEST_FASTEST arrivals of one instant are placed largest
+//                       first, each on the CPU that would finish it
+//                       earliest (LPT on uniform machines)
+// ------------------------------------------------------------
+typedef enum {
+    SMP_OBLIVIOUS,
+    SMP_FASTEST_IDLE,
+    SMP_LARGEST_FASTEST,
+    SMP_PLACEMENTS
+} SmpPlacement;
+
+static const char *SMP_PLACEMENT_NAMES[SMP_PLACEMENTS] = {"oblivious", "fastest-idle", "largest-fastest"};
+
+typedef struct {
+    int ncpu;
+    int quantum;              // 0: run to completion
+    int affinity;
+    double refill_us_per_kb;
+    double half_life;         // time units
+    const double *speed;      // per CPU; NULL: all 1
+    SmpPlacement placement;
+} SmpOpts;
+
+typedef struct {
+    int makespan;
+    long long dispatches;
+    long long migrations;
+    double refill_us;
+    long long refill_units;   // simulated time lost to refills
+    long long *busy;          // per CPU time occupied, if set by the caller
+} SmpStats;
+
+typedef struct {
+    SchedHeap q;
+    int cap;
+    long long load;           // remaining work queued here
+    int running;              // process index, -1 when idle
+    int slice_len;
+    int slice_end;
+} SmpCpu;
+
+// 2^(-age / half_life) without libm: whole halvings, then a short series.
+static double cache_warmth(int age, double half_life) {
+    if(half_life <= 0.0) return 0.0;
+    double x = age / half_life;
+    if(x >= 64.0) return 0.0;
+    int whole = (int)x;
+    double f = (x - whole) * 0.6931471805599453;   // 2^-frac = e^(-frac*ln2)
+    double w = 1.0 - f + f * f / 2 - f * f * f / 6 + f * f * f * f / 24;
+    while(whole-- > 0) w *= 0.5;
+    return w;
+}
+
+static void smp_push(SmpCpu *c, SchedEntry e, SchedBeforeFn before) {
+    if(grow_entries(&c->q.a, &c->cap, c->q.size + 1) != 0) {
+        perror("realloc(cpu queue)");
+        exit(1);
+    }
+    sched_heap_push(&c->q, e, before);
+    c->load += e.p->remaining_time;
+}
+
+static int smp_least_loaded(const SmpCpu *cpu, int ncpu, const Process processes[]) {
+    int best = 0;
+    long long best_load = LLONG_MAX;
+    for(int c = 0; c < ncpu; c++) {
+        long long load = cpu[c].load;
+        if(cpu[c].running >= 0) load += processes[cpu[c].running].remaining_time;
+        if(load < best_load) {
+            best_load = load;
+            best = c;
+        }
+    }
+    return best;
+}
+
+static inline double smp_speed(const SmpOpts *o, int c) {
+    return o->speed ? o->speed[c] : 1.0;
+}
+
+// Time to run work units on CPU c, at least 1.
+static inline int smp_duration(const SmpOpts *o, int c, int work) {
+    if(!o->speed) return work;
+    double sp = o->speed[c];
+    int d = (int)(work / sp);
+    if(d * sp < work) d++;
+    return d > 0 ? d : 1;
+}
+
+// Speed-aware target for a task of extra work units: the fastest idle
+// CPU (SMP_FASTEST_IDLE only), else the earliest (load + extra) / speed.
+static int smp_place(const SmpCpu *cpu, const Process processes[], const SmpOpts *o, int extra) {
+    if(o->placement == SMP_OBLIVIOUS) return smp_least_loaded(cpu, o->ncpu, processes);
+    int best = -1;
+    if(o->placement == SMP_FASTEST_IDLE) {
+        for(int c = 0; c < o->ncpu; c++) {
+            if(cpu[c].running >= 0 || cpu[c].q.size > 0) continue;
+            if(best < 0 || smp_speed(o, c) > smp_speed(o, best)) best = c;
+        }
+        if(best >= 0) return best;
+    }
+    double best_finish = 0.0;
+    for(int c = 0; c < o->ncpu; c++) {
+        long long load = cpu[c].load + extra;
+        if(cpu[c].running >= 0) load += processes[cpu[c].running].remaining_time;
+        double finish = load / smp_speed(o, c);
+        if(best < 0 || finish < best_finish) {
+            best_finish = finish;
+            best = c;
+        }
+    }
+    return best;
+}
+
+// Largest burst first, then index.
+static const Process *g_smp_sort_base;
+
+static int smp_larger_first(const void *a, const void *b) {
+    const Process *x = &g_smp_sort_base[*(const int*)a], *y = &g_smp_sort_base[*(const int*)b];
+    if(x->burst_time != y->burst_time) return y->burst_time - x->burst_time;
+    return *(const int*)a - *(const int*)b;
+}
+
+SCHED_INLINE Metrics smp_engine(Process processes[], int n, const SmpOpts *o, SmpStats *st,
+                                SchedBeforeFn before) {
+    int ncpu = o->ncpu;
+    int *order = arrival_order(processes, n);
+    SmpCpu *cpu = (SmpCpu*)xcalloc((size_t)ncpu, sizeof(SmpCpu), "calloc(cpus)");
+    int *last_end = (int*)xcalloc((size_t)n * (size_t)ncpu, sizeof(int), "calloc(cache state)");
+    int *last_cpu = (int*)xcalloc((size_t)n, sizeof(int), "calloc(cache state)");
+    int *preempted = (int*)xcalloc((size_t)ncpu, sizeof(int), "calloc(cpus)");
+    int *arrived = (int*)xcalloc((size_t)n, sizeof(int), "calloc(arrivals)");
+    int *by_speed = (int*)xcalloc((size_t)ncpu, sizeof(int), "calloc(cpus)");
+    int *served = (int*)xcalloc((size_t)n, sizeof(int), "calloc(served)");
+    memset(last_end, 0xff, (size_t)n * (size_t)ncpu * sizeof(int));   // -1: never ran there
+    memset(last_cpu, 0xff, (size_t)n * sizeof(int));
+    for(int c = 0; c < ncpu; c++) cpu[c].running = -1;
+
+    // Dispatch order: by index, or fastest first for speed-aware placement.
+    for(int c = 0; c < ncpu; c++) {
+        int k = c;
+        if(o->placement != SMP_OBLIVIOUS) {
+            while(k > 0 && smp_speed(o, by_speed[k - 1]) < smp_speed(o, c)) {
+                by_speed[k] = by_speed[k - 1];
+                k--;
+            }
+        }
+        by_speed[k] = c;
+    }
+
+    RunTotals totals = {0};
+    int next = 0, completed = 0, t = 0;
+    unsigned seq = 0;
+    long long *busy = st->busy;
+    memset(st, 0, sizeof(*st));
+    st->busy = busy;
+    if(busy) memset(busy, 0, (size_t)ncpu * sizeof(long long));
+
+    while(completed != n) {
+        // Slices ending now: finish or hold for requeue.
+        int npreempted = 0;
+        for(int c = 0; c < ncpu; c++) {
+            if(cpu[c].running < 0 || cpu[c].slice_end != t) continue;
+            int idx = cpu[c].running;
+            Process *p = &processes[idx];
+            p->remaining_time -= cpu[c].slice_len;
+            last_end[(size_t)idx * ncpu + c] = t;
+            cpu[c].running = -1;
+            if(p->remaining_time == 0) {
+                complete_sliced(processes, idx, t, NULL, NULL, &totals);
+                // On a faster or slower CPU the task ran for served, not
+                // burst, time units.
+                totals.total_waiting_time += p->burst_time - served[idx];
+                p->waiting_time += p->burst_time - served[idx];
+                completed++;
+                st->makespan = t;
+            } else {
+                preempted[npreempted++] = idx;
+            }
+        }
+
+        // Arrivals queue ahead of the tasks preempted at the same instant.
+        int narrived = 0;
+        while(next < n && processes[order[next]].arrival_time <= t) arrived[narrived++] = order[next++];
+        if(o->placement == SMP_LARGEST_FASTEST && narrived > 1) {
+            g_smp_sort_base = processes;
+            qsort(arrived, (size_t)narrived, sizeof(int), smp_larger_first);
+        }
+        for(int k = 0; k < narrived; k++) {
+            int i = arrived[k];
+            SchedEntry e = { &processes[i], i, seq++ };
+            smp_push(&cpu[smp_place(cpu, processes, o, processes[i].remaining_time)], e, before);
+        }
+        for(int k = 0; k < npreempted; k++) {
+            int idx = preempted[k];
+            int c = o->affinity ? last_cpu[idx] : smp_place(cpu, processes, o, processes[idx].remaining_time);
+            SchedEntry e = { &processes[idx], idx, seq++ };
+            smp_push(&cpu[c], e, before);
+        }
+
+        // Dispatch idle CPUs from their own queues first, then let the
+        // ones still idle steal, so no CPU takes work its owner would run.
+        for(int pass = 0; pass < 2; pass++)
+        for(int d = 0; d < ncpu; d++) {
+            int c = by_speed[d];
+            if(cpu[c].running >= 0) continue;
+            SmpCpu *src = &cpu[c];
+            if(src->q.size == 0) {
+                if(pass == 0) continue;
+                for(int v = 0; v < ncpu; v++) {
+                    if(cpu[v].q.size > 0 && (src->q.size == 0 || cpu[v].load > src->load)) src = &cpu[v];
+                }
+                if(src->q.size == 0) continue;
+            }
+            SchedEntry e = sched_heap_pop(&src->q, before);
+            int idx = e.idx;
+            Process *p = &processes[idx];
+            src->load -= p->remaining_time;
+
+            int seen = last_end[(size_t)idx * ncpu + c];
+            double warmth = seen < 0 ? 0.0 : cache_warmth(t - seen, o->half_life);
+            double refill_us = p->working_set_kb * o->refill_us_per_kb * (1.0 - warmth);
+            int refill_units = (int)(refill_us / 1000.0 + 0.5);
+            if(last_cpu[idx] >= 0 && last_cpu[idx] != c) st->migrations++;
+            last_cpu[idx] = c;
+
+            int slice = p->remaining_time;
+            if(o->quantum > 0 && slice > o->quantum) slice = o->quantum;
+            int duration = smp_duration(o, c, slice);
+            cpu[c].running = idx;
+            cpu[c].slice_len = slice;
+            cpu[c].slice_end = t + refill_units + duration;
+            served[idx] += duration;
+            if(busy) busy[c] += refill_units + duration;
+            st->refill_us += refill_us;
+            st->refill_units += refill_units;
+            st->dispatches++;
+            totals.context_switches++;
+        }
+
+        // Advance to the next slice end or arrival.
+        int when = INT_MAX;
+        for(int c = 0; c < ncpu; c++) {
+            if(cpu[c].running >= 0 && cpu[c].slice_end < when) when = cpu[c].slice_end;
+        }
+        if(next < n && processes[order[next]].arrival_time < when) when = processes[order[next]].arrival_time;
+        if(when == INT_MAX) break;
+        t = when;
+    }
+
+    for(int c = 0; c < ncpu; c++) free(cpu[c].q.a);
+    free(served);
+    free(by_speed);
+    free(arrived);
+    free(preempted);
+    free(last_cpu);
+    free(last_end);
+    free(cpu);
+    free(order);
+    return quantum_metrics(&totals, n);
+}
+
+// Runs one of main's policies on o->ncpu CPUs; non-sliced policies ignore the quantum.
+Metrics smp_schedule(Process processes[], int n, PolicyId policy, const SmpOpts *o, SmpStats *st) {
+    SmpOpts whole = *o;
+    whole.quantum = 0;
+    switch(policy) {
+        case POLICY_FCFS:        return smp_engine(processes, n, &whole, st, fcfs_before);
+        case POLICY_SJF:         return smp_engine(processes, n, &whole, st, sjf_before);
+        case POLICY_PRIORITY:    return smp_engine(processes, n, &whole, st, priority_before);
+        case POLICY_RR:          return smp_engine(processes, n, o, st, rr_before);
+        case POLICY_PRIORITY_RR: return smp_engine(processes, n, o, st, priority_before);
+        default: break;
+    }
+    Metrics none = {0};
+    return none;
+}
+
+// ------------------------------------------------------------
+// Partitioned cluster (parallel discrete-event mode)
+// Tasks start on a home CPU (index mod CPUs). A CPU that admits a task
+// while `threshold` tasks already wait forwards it to the next CPU;
+// the hand-off takes `latency` time units and a task is forwarded at
+// most CPUs - 1 times. CPUs only interact through these hand-offs, so
+// the latency is a lookahead that lets them be simulated in parallel:
+//   threads == 0: one thread in global time order (lowest CPU first on
+//                 ties); hand-offs go straight into the target's queue.
+//   threads  > 0: CPU c belongs to worker c % threads. Each round every
+//                 CPU drains its mailbox and publishes its next event
+//                 time; after a barrier CPU c runs every event before
+//                 min over k of (next event of CPU c - k) + k * latency,
+//                 the earliest a task k hops upstream could reach it.
+//                 Mailboxes are lock-free stacks the owner takes whole
+//                 with one exchange.
+// Hand-offs join the target's pending queue ordered by (admit time,
+// index) and every CPU draws from its own random stream, so both modes
+// give the same schedule for any number of threads.
+// ------------------------------------------------------------
+typedef struct {
+    int ncpu;
+    int quantum;              // 0: run to completion
+    int latency;              // hand-off time, >= 1
+    int threshold;            // waiting tasks before admissions are forwarded
+    int threads;              // 0: sequential
+} ClusterOpts;
+
+typedef struct {
+    int makespan;
+    long long dispatches;
+    long long forwarded;
+    long long rounds;         // synchronization rounds (parallel mode)
+} ClusterStats;
+
+typedef struct {
+    SchedHeap pending;        // not yet admitted; seq holds the admit time
+    int pending_cap;
+    SchedHeap ready;
+    int ready_cap;
+    unsigned seq;
+    int running;              // process index, -1 when idle
+    int slice_len;
+    int slice_end;
+    int last_executed;
+    int next_event;           // published each round in parallel mode
+    _Atomic int inbox;        // stack of process indices linked through Cluster.link
+    int makespan;
+    long long dispatches;
+    long long forwarded;
+    RunTotals totals;
+    Rng rng;
+} __attribute__((aligned(64))) ClusterCpu;
+
+typedef struct {
+    Process *processes;
+    const ClusterOpts *o;
+    PolicyId policy;
+    ClusterCpu *cpu;
+    int *admit_time;
+    int *hops;
+    int *link;
+    long long rounds;
+    pthread_barrier_t barrier;
+} Cluster;
+
+typedef struct {
+    Cluster *cl;
+    int id;
+} ClusterWorker;
+
+static inline int cluster_pending_before(const SchedEntry *a, const SchedEntry *b) {
+    return SCHED_LT(a->seq, b->seq, a->idx < b->idx);
+}
+
+static void cluster_push(SchedHeap *h, int *cap, SchedEntry e, SchedBeforeFn before) {
+    if(grow_entries(&h->a, cap, h->size + 1) != 0) {
+        perror("realloc(cluster queue)");
+        exit(1);
+    }
+    sched_heap_push(h, e, before);
+}
+
+static inline void cluster_add_pending(Cluster *cl, int c, int idx) {
+    SchedEntry e = { &cl->processes[idx], idx, (unsigned)cl->admit_time[idx] };
+    cluster_push(&cl->cpu[c].pending, &cl->cpu[c].pending_cap, e, cluster_pending_before);
+}
+
+static void cluster_send(Cluster *cl, int to, int idx) {
+    if(cl->o->threads == 0) {
+        cluster_add_pending(cl, to, idx);
+        return;
+    }
+    _Atomic int *inbox = &cl->cpu[to].inbox;
+    int head = atomic_load_explicit(inbox, memory_order_relaxed);
+    do {
+        cl->link[idx] = head;
+    } while(!atomic_compare_exchange_weak_explicit(inbox, &head, idx,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+static void cluster_drain(Cluster *cl, int c) {
+    int idx = atomic_exchange_explicit(&cl->cpu[c].inbox, -1, memory_order_acquire);
+    for(; idx >= 0; idx = cl->link[idx]) cluster_add_pending(cl, c, idx);
+}
+
+static inline int cluster_next_event(const ClusterCpu *cpu) {
+    int t = cpu->running >= 0 ? cpu->slice_end : INT_MAX;
+    if(cpu->pending.size > 0 && (int)cpu->pending.a[0].seq < t) t = (int)cpu->pending.a[0].seq;
+    return t;
+}
+
+// Runs every event of CPU c before time bound, in time order.
+SCHED_INLINE void cluster_advance(Cluster *cl, int c, int bound, SchedBeforeFn before) {
+    ClusterCpu *cpu = &cl->cpu[c];
+    Process *processes = cl->processes;
+    const ClusterOpts *o = cl->o;
+    Rng saved = g_rng;
+    g_rng = cpu->rng;
+
+    for(;;) {
+        int t = cluster_next_event(cpu);
+        if(t >= bound) break;
+
+        // A slice ending now: finish, or hold for requeue.
+        int preempted = -1;
+        if(cpu->running >= 0 && cpu->slice_end == t) {
+            int idx = cpu->running;
+            Process *p = &processes[idx];
+            p->remaining_time -= cpu->slice_len;
+            cpu->running = -1;
+            if(p->remaining_time == 0) {
+                complete_sliced(processes, idx, t, NULL, NULL, &cpu->totals);
+                cpu->makespan = t;
+                cpu->last_executed = -1;
+            } else {
+                preempted = idx;
+            }
+        }
+
+        // Admissions queue ahead of the preempted task, or move on.
+        while(cpu->pending.size > 0 && (int)cpu->pending.a[0].seq <= t) {
+            SchedEntry e = sched_heap_pop(&cpu->pending, cluster_pending_before);
+            if(cpu->ready.size >= o->threshold && cl->hops[e.idx] < o->ncpu - 1) {
+                cl->hops[e.idx]++;
+                cl->admit_time[e.idx] = t + o->latency;
+                cpu->forwarded++;
+                cluster_send(cl, (c + 1) % o->ncpu, e.idx);
+                continue;
+            }
+            e.seq = cpu->seq++;
+            cluster_push(&cpu->ready, &cpu->ready_cap, e, before);
+        }
+        if(preempted >= 0) {
+            SchedEntry e = { &processes[preempted], preempted, cpu->seq++ };
+            cluster_push(&cpu->ready, &cpu->ready_cap, e, before);
+        }
+
+        if(cpu->running < 0 && cpu->ready.size > 0) {
+            int idx = sched_heap_pop(&cpu->ready, before).idx;
+            Process *p = &processes[idx];
+            if(idx != cpu->last_executed) {
+                cpu->totals.context_switches++;
+                cpu->last_executed = idx;
+            }
+            int slice = p->remaining_time;
+            if(o->quantum > 0 && slice > o->quantum) slice = o->quantum;
+            cpu->running = idx;
+            cpu->slice_len = slice;
+            cpu->slice_end = t + slice;
+            cpu->dispatches++;
+        }
+    }
+
+    cpu->rng = g_rng;
+    g_rng = saved;
+}
+
+// Instantiates cluster_advance for the run's policy.
+static void cluster_advance_policy(Cluster *cl, int c, int bound) {
+    switch(cl->policy) {
+        case POLICY_FCFS:        cluster_advance(cl, c, bound, fcfs_before); break;
+        case POLICY_SJF:         cluster_advance(cl, c, bound, sjf_before); break;
+        case POLICY_PRIORITY:    cluster_advance(cl, c, bound, priority_before); break;
+        case POLICY_RR:          cluster_advance(cl, c, bound, rr_before); break;
+        case POLICY_PRIORITY_RR: cluster_advance(cl, c, bound, priority_before); break;
+        default: break;
+    }
+}
+
+static void* cluster_worker(void *arg) {
+    const ClusterWorker *w = (const ClusterWorker*)arg;
+    Cluster *cl = w->cl;
+    int ncpu = cl->o->ncpu, step = cl->o->threads;
+    for(;;) {
+        for(int c = w->id; c < ncpu; c += step) {
+            cluster_drain(cl, c);
+            cl->cpu[c].next_event = cluster_next_event(&cl->cpu[c]);
+        }
+        pthread_barrier_wait(&cl->barrier);
+
+        int earliest = INT_MAX;
+        for(int c = 0; c < ncpu; c++) {
+            if(cl->cpu[c].next_event < earliest) earliest = cl->cpu[c].next_event;
+        }
+        if(earliest == INT_MAX) break;   // every worker sees the same value
+        for(int c = w->id; c < ncpu; c += step) {
+            long long bound = INT_MAX;
+            for(int k = 1; k < ncpu; k++) {
+                int up = cl->cpu[(c - k + ncpu) % ncpu].next_event;
+                if(up != INT_MAX && up + (long long)k * cl->o->latency < bound)
+                    bound = up + (long long)k * cl->o->latency;
+            }
+            cluster_advance_policy(cl, c, (int)bound);
+        }
+        if(w->id == 0) cl->rounds++;
+        pthread_barrier_wait(&cl->barrier);
+    }
+    return NULL;
+}
+
+static void cluster_run_parallel(Cluster *cl) {
+    int nthreads = cl->o->threads;
+    pthread_t *tid = (pthread_t*)xcalloc((size_t)nthreads, sizeof(pthread_t), "calloc(threads)");
+    ClusterWorker *w = (ClusterWorker*)xcalloc((size_t)nthreads, sizeof(ClusterWorker), "calloc(threads)");
+    if(pthread_barrier_init(&cl->barrier, NULL, (unsigned)nthreads) != 0) {
+        perror("pthread_barrier_init");
+        exit(1);
+    }
+    for(int i = 0; i < nthreads; i++) {
+        w[i].cl = cl;
+        w[i].id = i;
+        if(i > 0 && pthread_create(&tid[i], NULL, cluster_worker, &w[i]) != 0) {
+            perror("pthread_create");
+            exit(1);
+        }
+    }
+    cluster_worker(&w[0]);
+    for(int i = 1; i < nthreads; i++) pthread_join(tid[i], NULL);
+    pthread_barrier_destroy(&cl->barrier);
+    free(w);
+    free(tid);
+}
+
+static void cluster_run_sequential(Cluster *cl) {
+    for(;;) {
+        int best = -1, when = INT_MAX;
+        for(int c = 0; c < cl->o->ncpu; c++) {
+            int t = cluster_next_event(&cl->cpu[c]);
+            if(t < when) {
+                when = t;
+                best = c;
+            }
+        }
+        if(best < 0) break;
+        cluster_advance_policy(cl, best, when + 1);
+    }
+}
+
+// Runs one of main's policies on the cluster; non-sliced policies ignore
+// the quantum and o->threads is capped at the number of CPUs.
+Metrics cluster_schedule(Process processes[], int n, PolicyId policy, const ClusterOpts *opts,
+                         ClusterStats *st) {
+    ClusterOpts o = *opts;
+    if(policy != POLICY_RR && policy != POLICY_PRIORITY_RR) o.quantum = 0;
+    if(o.threads > o.ncpu) o.threads = o.ncpu;
+    if(o.latency < 1) o.latency = 1;
+
+    Cluster cl;
+    memset(&cl, 0, sizeof(cl));
+    cl.processes = processes;
+    cl.o = &o;
+    cl.policy = policy;
+    cl.cpu = (ClusterCpu*)aligned_alloc(64, (size_t)o.ncpu * sizeof(ClusterCpu));
+    if(!cl.cpu) {
+        perror("aligned_alloc(cpus)");
+        exit(1);
+    }
+    memset(cl.cpu, 0, (size_t)o.ncpu * sizeof(ClusterCpu));
+    cl.admit_time = (int*)xcalloc((size_t)n, sizeof(int), "calloc(cluster)");
+    cl.hops = (int*)xcalloc((size_t)n, sizeof(int), "calloc(cluster)");
+    cl.link = (int*)xcalloc((size_t)n, sizeof(int), "calloc(cluster)");
+
+    // CPU c draws from stream RNG_STREAM_CLUSTER + c, past every fixed range.
+    Rng r;
+    rng_stream(&r, g_seed, RNG_STREAM_CLUSTER);
+    for(int c = 0; c < o.ncpu; c++) {
+        cl.cpu[c].running = -1;
+        cl.cpu[c].last_executed = -1;
+        atomic_init(&cl.cpu[c].inbox, -1);
+        cl.cpu[c].rng = r;
+        rng_jump(&r);
+    }
+    for(int i = 0; i < n; i++) {
+        cl.admit_time[i] = processes[i].arrival_time;
+        cluster_add_pending(&cl, i % o.ncpu, i);
+    }
+
+    if(o.threads > 0) {
+        cluster_run_parallel(&cl);
+    } else {
+        cluster_run_sequential(&cl);
+    }
+
+    RunTotals totals = {0};
+    memset(st, 0, sizeof(*st));
+    st->rounds = cl.rounds;
+    for(int c = 0; c < o.ncpu; c++) {
+        const ClusterCpu *cpu = &cl.cpu[c];
+        totals.total_waiting_time += cpu->totals.total_waiting_time;
+        totals.total_turnaround_time += cpu->totals.total_turnaround_time;
+        totals.total_sched_latency += cpu->totals.total_sched_latency;
+        totals.total_overhead += cpu->totals.total_overhead;
+        totals.context_switches += cpu->totals.context_switches;
+        if(cpu->makespan > st->makespan) st->makespan = cpu->makespan;
+        st->dispatches += cpu->dispatches;
+        st->forwarded += cpu->forwarded;
+        free(cpu->pending.a);
+        free(cpu->ready.a);
+    }
+    free(cl.link);
+    free(cl.hops);
+    free(cl.admit_time);
+    free(cl.cpu);
+    return quantum_metrics(&totals, n);
+}
+
+// ------------------------------------------------------------
+// Lock-step multi-policy simulation (--lockstep[=THREADS])
+// Runs all of main's policies in one pass over the arrival stream.
+// Arrivals are decoded once, in arrival order, into batches of
+// LOCKSTEP_BATCH records; every engine copies the batch into its own
+// tasks while the batch is still in cache, instead of each policy
+// re-reading the whole input after reset_processes().
+//
+// Each round the engines take every decision that is safe with the
+// arrivals published so far: an event at time t is safe when t is
+// before the last published arrival (or the stream is complete), since
+// arrivals are sorted. Engines then wait at a barrier while worker 0
+// has already decoded the next batch into the other buffer.
+//
+// Engine k belongs to worker k % threads and draws from stream k + 1,
+// like main's stage k, so the simulated metrics equal the per-policy
+// runs. Run-to-completion tasks are not executed, so their measured
+// real time is 0.
+// ------------------------------------------------------------
+#define LOCKSTEP_BATCH 4096
+
+typedef struct {
+    PolicyId policy;
+    int quantum;              // 0: run to completion
+    Process *processes;       // the engine's copies, filled batch by batch
+    SchedHeap ready;
+    int *group;               // arrivals admitted at one decision
+    int next;                 // stream position of the next arrival to admit
+    unsigned seq;
+    int now;
+    int running;              // process index, -1 when idle
+    int slice_len;
+    int slice_end;
+    int last_executed;
+    int completed;
+    int makespan;
+    RunTotals totals;
+    Rng rng;
+} __attribute__((aligned(64))) LockstepEngine;
+
+typedef struct {
+    const Process *original;
+    int n;
+    const int *order;         // arrival order, shared read-only
+    Process *batch[2];        // decoded records of the current and next batch
+    int published;            // stream positions decoded before this round
+    LockstepEngine *engine;
+    int nengines;
+    int threads;
+    pthread_barrier_t barrier;
+} Lockstep;
+
+typedef struct {
+    Lockstep *ls;
+    int id;
+} LockstepWorker;
+
+static void lockstep_decode(Lockstep *ls, int round) {
+    int from = round * LOCKSTEP_BATCH;
+    int to = from + LOCKSTEP_BATCH < ls->n ? from + LOCKSTEP_BATCH : ls->n;
+    Process *out = ls->batch[round & 1];
+    for(int k = from; k < to; k++) out[k - from] = ls->original[ls->order[k]];
+}
+
+// Runs every event of engine e before horizon, with arrivals known up
+// to stream position published.
+SCHED_INLINE void lockstep_advance(LockstepEngine *e, const int *order, int published,
+                                   int horizon, SchedBeforeFn before) {
+    Process *processes = e->processes;
+    int sliced = e->quantum > 0;
+    Rng saved = g_rng;
+    g_rng = e->rng;
+
+    for(;;) {
+        int t;
+        if(e->running >= 0) {
+            t = e->slice_end;
+        } else if(e->ready.size > 0) {
+            t = e->now;
+        } else if(e->next < published) {
+            t = processes[order[e->next]].arrival_time;   // idle until then
+        } else {
+            break;
+        }
+        if(t >= horizon) break;
+        e->now = t;
+
+        // A slice ending now: finish, or hold for requeue.
+        int preempted = -1;
+        if(e->running >= 0) {
+            int idx = e->running;
+            Process *p = &processes[idx];
+            p->remaining_time -= e->slice_len;
+            e->running = -1;
+            if(p->remaining_time == 0) {
+                if(sliced) {
+                    complete_sliced(processes, idx, t, NULL, NULL, &e->totals);
+                    e->last_executed = -1;
+                } else {
+                    p->completion_time = t;
+                    p->turnaround_time = t - p->arrival_time;
+                    p->waiting_time = p->turnaround_time - p->burst_time;
+                    p->real_time_us = 0;
+                    p->sched_latency_us = 2000 + (long)rng_below(&g_rng, 2000);
+                    totals_add(&e->totals, p);
+                }
+                e->completed++;
+                e->makespan = t;
+            } else {
+                preempted = idx;
+            }
+        }
+
+        // Arrivals up to now join in index order, as in sched_admit(),
+        // ahead of the preempted task.
+        int count = 0;
+        while(e->next < published && processes[order[e->next]].arrival_time <= t) {
+            e->group[count++] = order[e->next++];
+        }
+        if(count > 1) qsort(e->group, (size_t)count, sizeof(int), cmp_int);
+        for(int k = 0; k < count; k++) {
+            int i = e->group[k];
+            processes[i].ready_since = processes[i].arrival_time;
+            SchedEntry entry = { &processes[i], i, e->seq++ };
+            sched_heap_push(&e->ready, entry, before);
+        }
+        if(preempted >= 0) {
+            processes[preempted].ready_since = t;
+            SchedEntry entry = { &processes[preempted], preempted, e->seq++ };
+            sched_heap_push(&e->ready, entry, before);
+        }
+
+        if(e->ready.size > 0) {
+            int idx = sched_heap_pop(&e->ready, before).idx;
+            Process *p = &processes[idx];
+            if(!sliced) {
+                e->totals.context_switches++;
+            } else if(idx != e->last_executed) {
+                e->totals.context_switches++;
+                e->last_executed = idx;
+            }
+            int slice = p->remaining_time;
+            if(sliced && slice > e->quantum) slice = e->quantum;
+            e->running = idx;
+            e->slice_len = slice;
+            e->slice_end = t + slice;
+        }
+    }
+
+    e->rng = g_rng;
+    g_rng = saved;
+}
+
+// Instantiates lockstep_advance for the engine's policy.
+static void lockstep_advance_policy(LockstepEngine *e, const int *order, int published, int horizon) {
+    switch(e->policy) {
+        case POLICY_FCFS:
+            lockstep_advance(e, order, published, horizon, fcfs_before);
+            break;
+        case POLICY_SJF:
+            lockstep_advance(e, order, published, horizon, sjf_before);
+            break;
+        case POLICY_PRIORITY:
+        case POLICY_PRIORITY_RR:
+            if(g_aging > 0) {
+                lockstep_advance(e, order, published, horizon, priority_aged_before);
+            } else {
+                lockstep_advance(e, order, published, horizon, priority_before);
+            }
+            break;
+        case POLICY_RR:
+            lockstep_advance(e, order, published, horizon, rr_before);
+            break;
+        default:
+            break;
+    }
+}
+
+static void* lockstep_worker(void *arg) {
+    const LockstepWorker *w = (const LockstepWorker*)arg;
+    Lockstep *ls = w->ls;
+    int n = ls->n, nrounds = (n + LOCKSTEP_BATCH - 1) / LOCKSTEP_BATCH;
+    for(int round = 0; round < nrounds; round++) {
+        int from = round * LOCKSTEP_BATCH;
+        int to = from + LOCKSTEP_BATCH < n ? from + LOCKSTEP_BATCH : n;
+        const Process *in = ls->batch[round & 1];
+        if(w->id == 0 && round + 1 < nrounds) lockstep_decode(ls, round + 1);
+
+        for(int k = w->id; k < ls->nengines; k += ls->threads) {
+            LockstepEngine *e = &ls->engine[k];
+            for(int pos = from; pos < to; pos++) e->processes[ls->order[pos]] = in[pos - from];
+            int horizon = to == n ? INT_MAX : in[to - from - 1].arrival_time;
+            lockstep_advance_policy(e, ls->order, to, horizon);
+        }
+        if(ls->threads > 1) pthread_barrier_wait(&ls->barrier);
+    }
+    return NULL;
+}
+
+// Runs the policies in one pass; metrics[k] and makespan[k] (if not NULL)
+// receive policy[k]'s results. Non-sliced policies ignore the quantum.
+void lockstep_schedule(const Process original[], int n, const PolicyId policy[], int npolicies,
+                       int quantum, int threads, Metrics metrics[], int makespan[]) {
+    Lockstep ls;
+    memset(&ls, 0, sizeof(ls));
+    ls.original = original;
+    ls.n = n;
+    ls.nengines = npolicies;
+    ls.threads = threads < 1 ? 1 : threads > npolicies ? npolicies : threads;
+
+    // arrival_order() only reads arrival times.
+    ls.order = arrival_order((Process*)original, n);
+    ls.batch[0] = (Process*)xcalloc(LOCKSTEP_BATCH, sizeof(Process), "calloc(lockstep)");
+    ls.batch[1] = (Process*)xcalloc(LOCKSTEP_BATCH, sizeof(Process), "calloc(lockstep)");
+    ls.engine = (LockstepEngine*)aligned_alloc(64, (size_t)npolicies * sizeof(LockstepEngine));
+    if(!ls.engine) {
+        perror("aligned_alloc(engines)");
+        exit(1);
+    }
+    memset(ls.engine, 0, (size_t)npolicies * sizeof(LockstepEngine));
+    for(int k = 0; k < npolicies; k++) {
+        LockstepEngine *e = &ls.engine[k];
+        e->policy = policy[k];
+        e->quantum = policy[k] == POLICY_RR || policy[k] == POLICY_PRIORITY_RR ? quantum : 0;
+        e->processes = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(lockstep)");
+        e->ready.a = (SchedEntry*)xcalloc((size_t)n, sizeof(SchedEntry), "calloc(ready)");
+        e->group = (int*)xcalloc((size_t)n, sizeof(int), "calloc(lockstep)");
+        e->running = -1;
+        e->last_executed = -1;
+        rng_stream(&e->rng, g_seed, (unsigned)(RNG_STREAM_MAIN + policy[k]));
+    }
+    if(n > 0) lockstep_decode(&ls, 0);
+
+    if(ls.threads > 1) {
+        pthread_t *tid = (pthread_t*)xcalloc((size_t)ls.threads, sizeof(pthread_t), "calloc(threads)");
+        LockstepWorker *w = (LockstepWorker*)xcalloc((size_t)ls.threads, sizeof(LockstepWorker),
+                                                     "calloc(threads)");
+        if(pthread_barrier_init(&ls.barrier, NULL, (unsigned)ls.threads) != 0) {
+            perror("pthread_barrier_init");
+            exit(1);
+        }
+        for(int i = 0; i < ls.threads; i++) {
+            w[i].ls = &ls;
+            w[i].id = i;
+            if(i > 0 && pthread_create(&tid[i], NULL, lockstep_worker, &w[i]) != 0) {
+                perror("pthread_create");
+                exit(1);
+            }
+        }
+        lockstep_worker(&w[0]);
+        for(int i = 1; i < ls.threads; i++) pthread_join(tid[i], NULL);
+        pthread_barrier_destroy(&ls.barrier);
+        free(w);
+        free(tid);
+    } else {
+        LockstepWorker w = { &ls, 0 };
+        lockstep_worker(&w);
+    }
+
+    for(int k = 0; k < npolicies; k++) {
+        LockstepEngine *e = &ls.engine[k];
+        Rng saved = g_rng;
+        g_rng = e->rng;
+        metrics[k] = e->quantum > 0 ? quantum_metrics(&e->totals, n) : nonpreemptive_metrics(&e->totals, n);
+        g_rng = saved;
+        if(makespan) makespan[k] = e->makespan;
+        free(e->group);
+        free(e->ready.a);
+        free(e->processes);
+    }
+    free(ls.engine);
+    free(ls.batch[1]);
+    free(ls.batch[0]);
+    free((void*)ls.order);
+}
+
+// ------------------------------------------------------------
+// Tenant fair queueing (hierarchical)
+// Tasks belong to the tenant named like their task class. The CPU is
+// shared between tenants by self-clocked weighted fair queueing; inside
+// a tenant, a policy comparator orders its own ready queue:
+//   start  = max(V, tenant's last finish tag)
+//   finish = start + slice of the tenant's head task / weight
+// The backlogged tenant with the smallest finish tag runs its head task
+// for one slice and V becomes that tag. A tenant is created and its
+// queue allocated when its first task arrives, and only backlogged
+// tenants sit in the tenant heap, so idle tenants cost nothing.
+// ------------------------------------------------------------
+typedef struct {
+    char name[32];
+    double weight;
+} TenantWeight;
+
+typedef struct {
+    int quantum;                  // 0: run to completion
+    const TenantWeight *weights;  // tenants not listed weigh 1
+    int nweights;
+} WfqOpts;
+
+typedef struct {
+    char name[100];
+    double weight;
+    SchedHeap q;
+    int cap;
+    int jobs;                     // queued or running
+    int heap_pos;                 // -1: idle, -2: running
+    double start;
+    double finish;
+    double last_finish;
+    int backlog_since;
+    long long backlogged;         // time with queued or running work
+    long long service;            // CPU time received
+    int cpus;                     // DRF: CPUs and memory held now
+    int mem_mb;
+    int share_since;              // DRF: when the share last changed
+    double share_time;            // DRF: integral of the dominant share
+    unsigned head_seq;            // DRF: arrival seq of the queue head
+} WfqTenant;
+
+typedef struct {
+    WfqTenant *tenants;           // by KeyIndex id of the name
+    int cap;
+    KeyIndex index;
+    int *heap;                    // backlogged tenants by finish tag
+    int heap_size;
+    int *tenant_of;               // per process
+    int makespan;
+} WfqState;
+
+static double tenant_weight(const WfqOpts *o, const char *name) {
+    for(int i = 0; i < o->nweights; i++) {
+        if(strcmp(o->weights[i].name, name) == 0) return o->weights[i].weight;
+    }
+    return 1.0;
+}
+
+static int wfq_named(const void *records, int id, const void *key) {
+    return strcmp(((const WfqTenant*)records)[id].name, (const char*)key) == 0;
+}
+
+// Finds or creates the tenant called name.
+static int wfq_tenant(WfqState *s, const WfqOpts *o, const char *name) {
+    uint64_t h = fnv1a(name);
+    int k = key_index_find(&s->index, h, wfq_named, s->tenants, name);
+    if(k >= 0) return k;
+    if(s->index.count == s->cap) {
+        s->tenants = (WfqTenant*)grow_records(s->tenants, &s->cap, s->cap + 1, sizeof(WfqTenant),
+                                              "realloc(tenants)");
+        int *heap = (int*)realloc(s->heap, (size_t)s->cap * sizeof(int));
+        if(!heap) {
+            perror("realloc(tenants)");
+            exit(1);
+        }
+        s->heap = heap;
+    }
+    k = key_index_add(&s->index, h);
+    WfqTenant *t = &s->tenants[k];
+    memset(t, 0, sizeof(*t));
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    t->weight = tenant_weight(o, name);
+    t->heap_pos = -1;
+    return k;
+}
+
+static inline int wfq_tenant_before(const WfqState *s, int a, int b) {
+    const WfqTenant *x = &s->tenants[a], *y = &s->tenants[b];
+    if(x->finish != y->finish) return x->finish < y->finish;
+    if(x->share_time != y->share_time) return x->share_time < y->share_time;
+    return x->head_seq != y->head_seq ? x->head_seq < y->head_seq : a < b;
+}
+
+static void wfq_heap_set(WfqState *s, int pos, int k) {
+    s->heap[pos] = k;
+    s->tenants[k].heap_pos = pos;
+}
+
+// Restores heap order around pos after its tenant's tag changed.
+static void wfq_heap_fix(WfqState *s, int pos) {
+    int k = s->heap[pos];
+    while(pos > 0 && wfq_tenant_before(s, k, s->heap[(pos - 1) / 2])) {
+        wfq_heap_set(s, pos, s->heap[(pos - 1) / 2]);
+        pos = (pos - 1) / 2;
+    }
+    for(;;) {
+        int c = 2 * pos + 1;
+        if(c >= s->heap_size) break;
+        if(c + 1 < s->heap_size && wfq_tenant_before(s, s->heap[c + 1], s->heap[c])) c++;
+        if(!wfq_tenant_before(s, s->heap[c], k)) break;
+        wfq_heap_set(s, pos, s->heap[c]);
+        pos = c;
+    }
+    wfq_heap_set(s, pos, k);
+}
+
+static int wfq_heap_pop(WfqState *s) {
+    int top = s->heap[0];
+    int last = s->heap[--s->heap_size];
+    if(s->heap_size > 0) {
+        s->heap[0] = last;
+        wfq_heap_fix(s, 0);
+    }
+    s->tenants[top].heap_pos = -1;
+    return top;
+}
+
+static inline int wfq_slice(const Process *p, int quantum) {
+    return quantum > 0 && p->remaining_time > quantum ? quantum : p->remaining_time;
+}
+
+// Tags tenant k from its head task and puts it in (or re-sorts) the heap.
+static void wfq_tag(WfqState *s, int k, double v, int quantum) {
+    WfqTenant *t = &s->tenants[k];
+    if(t->heap_pos < 0) t->start = v > t->last_finish ? v : t->last_finish;
+    t->finish = t->start + wfq_slice(t->q.a[0].p, quantum) / t->weight;
+    if(t->heap_pos < 0) {
+        t->heap_pos = s->heap_size;
+        s->heap[s->heap_size++] = k;
+    }
+    wfq_heap_fix(s, t->heap_pos);
+}
+
+SCHED_INLINE void wfq_admit(WfqState *s, const WfqOpts *o, Process processes[], const int *order,
+                            int n, int *next, int t, double v, unsigned *seq, SchedBeforeFn before) {
+    while(*next < n && processes[order[*next]].arrival_time <= t) {
+        int idx = order[(*next)++];
+        Process *p = &processes[idx];
+        int k = wfq_tenant(s, o, p->name);
+        WfqTenant *tn = &s->tenants[k];
+        s->tenant_of[idx] = k;
+        if(grow_entries(&tn->q.a, &tn->cap, tn->q.size + 1) != 0) {
+            perror("realloc(tenant queue)");
+            exit(1);
+        }
+        SchedEntry e = { p, idx, (*seq)++ };
+        p->ready_since = p->arrival_time;
+        sched_heap_push(&tn->q, e, before);
+        if(tn->jobs++ == 0) tn->backlog_since = t;
+        // A running tenant is re-tagged when its slice ends; a queued one
+        // only when the new task became its head.
+        if(tn->heap_pos == -1 || (tn->heap_pos >= 0 && tn->q.a[0].idx == idx)) {
+            wfq_tag(s, k, v, o->quantum);
+        }
+    }
+}
+
+SCHED_INLINE Metrics wfq_engine(Process processes[], int n, const WfqOpts *o, WfqState *s,
+                                SchedBeforeFn before) {
+    int *order = arrival_order(processes, n);
+    int next = 0, completed = 0, t = 0, last_executed = -1;
+    unsigned seq = 0;
+    double v = 0.0;
+    RunTotals totals = {0};
+    memset(s, 0, sizeof(*s));
+    s->tenant_of = (int*)xcalloc((size_t)n, sizeof(int), "calloc(tenants)");
+    gantt_reset();
+
+    while(completed != n) {
+        wfq_admit(s, o, processes, order, n, &next, t, v, &seq, before);
+        if(s->heap_size == 0) {
+            t = processes[order[next]].arrival_time;
+            gantt_push(-1, t);
+            continue;
+        }
+
+        int k = wfq_heap_pop(s);
+        WfqTenant *tn = &s->tenants[k];
+        v = tn->finish;
+        tn->last_finish = tn->finish;
+        tn->heap_pos = -2;
+        SchedEntry e = sched_heap_pop(&tn->q, before);
+        Process *p = &processes[e.idx];
+        int slice = wfq_slice(p, o->quantum);
+        tn->service += slice;
+        if(o->quantum == 0) {
+            // Whole tasks are timed like the other run-to-completion engines.
+            t = run_to_completion(processes, e.idx, t, NULL, NULL, &totals);
+            p->remaining_time = 0;
+        } else {
+            if(e.idx != last_executed) {
+                totals.context_switches++;
+                last_executed = e.idx;
+            }
+            simulate_work(slice);
+            p->remaining_time -= slice;
+            t += slice;
+            gantt_push(p->pid, t);
+        }
+
+        // Arrivals during the slice queue ahead of the preempted task.
+        wfq_admit(s, o, processes, order, n, &next, t, v, &seq, before);
+        tn = &s->tenants[k];   // admission may have grown the table
+        if(p->remaining_time == 0) {
+            if(o->quantum > 0) complete_sliced(processes, e.idx, t, NULL, NULL, &totals);
+            completed++;
+            last_executed = -1;
+            s->makespan = t;
+            if(--tn->jobs == 0) tn->backlogged += t - tn->backlog_since;
+        } else {
+            p->ready_since = t;
+            e.seq = seq++;
+            sched_heap_push(&tn->q, e, before);
+        }
+        tn->heap_pos = -1;
+        if(tn->q.size > 0) wfq_tag(s, k, v, o->quantum);
+    }
+
+    free(order);
+    show_gantt();
+    return o->quantum > 0 ? quantum_metrics(&totals, n) : nonpreemptive_metrics(&totals, n);
+}
+
+void wfq_free(WfqState *s) {
+    for(int k = 0; k < s->index.count; k++) free(s->tenants[k].q.a);
+    free(s->tenants);
+    key_index_free(&s->index);
+    free(s->heap);
+    free(s->tenant_of);
+    memset(s, 0, sizeof(*s));
+}
+
+// Runs main's policy inside each tenant; non-sliced policies ignore the
+// quantum, and priority ages by --aging like priority_scheduling().
+Metrics wfq_schedule(Process processes[], int n, PolicyId policy, const WfqOpts *o, WfqState *s) {
+    WfqOpts whole = *o;
+    whole.quantum = 0;
+    if(g_aging > 0 && (policy == POLICY_PRIORITY || policy == POLICY_PRIORITY_RR)) {
+        return wfq_engine(processes, n, policy == POLICY_PRIORITY ? &whole : o, s, priority_aged_before);
+    }
+    switch(policy) {
+        case POLICY_FCFS:        return wfq_engine(processes, n, &whole, s, fcfs_before);
+        case POLICY_SJF:         return wfq_engine(processes, n, &whole, s, sjf_before);
+        case POLICY_PRIORITY:    return wfq_engine(processes, n, &whole, s, priority_before);
+        case POLICY_RR:          return wfq_engine(processes, n, o, s, rr_before);
+        case POLICY_PRIORITY_RR: return wfq_engine(processes, n, o, s, priority_before);
+        default: break;
+    }
+    Metrics none = {0};
+    return none;
+}
+
+// ------------------------------------------------------------
+// Memory-aware placement and Dominant Resource Fairness
+// Every task holds one CPU and mem_mb of memory on a single node from
+// dispatch to completion. Nothing is preempted: a preempted task would
+// keep its memory, so no one else could use what it gave up. A node has
+// o->cpus CPUs and o->mem_mb of memory; a task that needs more memory
+// than one node has is rejected when it arrives. Queueing:
+//   DRF_SHARED   one queue in policy order; a head that fits on no
+//                node holds back everything behind it
+//   DRF_TENANTS  a queue per tenant (named like the task class) in
+//                policy order, and the wfq tenant heap keyed on the
+//                weighted dominant share: the larger of the tenant's
+//                CPU and memory fractions of the cluster, over its
+//                weight. The lowest share whose head fits somewhere
+//                dispatches; a tenant whose head fits nowhere sits out
+//                until the next completion.
+// Placement, among nodes with a free CPU and enough free memory:
+//   PACK_FIRST_FIT  the lowest-numbered
+//   PACK_BEST_FIT   the one left with the least memory, then the fewest
+//                   CPUs, which keeps large holes for large tasks
+// ------------------------------------------------------------
+typedef enum { DRF_SHARED, DRF_TENANTS, DRF_QUEUEINGS } DrfQueueing;
+typedef enum { PACK_FIRST_FIT, PACK_BEST_FIT, PACK_PLACEMENTS } PackPlacement;
+
+typedef struct {
+    int nodes;
+    int cpus;                     // per node
+    int mem_mb;                   // per node
+    DrfQueueing queueing;
+    PackPlacement placement;
+    const TenantWeight *weights;  // tenants not listed weigh 1
+    int nweights;
+} DrfOpts;
+
+// Packing is measured while tasks were queued, when idle capacity is a
+// loss. Fragmented memory is free memory that, summed over the nodes
+// with a free CPU, would have held the smallest blocked head, though
+// no single node could; it is a share of all the memory left free
+// while tasks waited. Fairness is Jain's index over the tenants' mean
+// weighted dominant shares while they had work: 1 when all held the
+// same share.
+typedef struct {
+    int makespan;
+    int admitted;
+    int rejected;
+    int tenants;
+    double cpu_pct;
+    double mem_pct;
+    double frag_pct;
+    double jain;
+    double min_share;
+    double max_share;
+} DrfStats;
+
+SCHED_DEFINE_POLICY(drf_finish,
+    SCHED_LT(A->p->completion_time, B->p->completion_time, A->idx < B->idx))
+
+// The node a task needing mem MB goes to under o->placement, or -1.
+static int pack_node(const DrfOpts *o, const int *free_cpus, const int *free_mem, int mem) {
+    int best = -1;
+    for(int k = 0; k < o->nodes; k++) {
+        if(free_cpus[k] == 0 || free_mem[k] < mem) continue;
+        if(o->placement == PACK_FIRST_FIT) return k;
+        if(best < 0 || free_mem[k] < free_mem[best]
+            || (free_mem[k] == free_mem[best] && free_cpus[k] < free_cpus[best])) {
+            best = k;
+        }
+    }
+    return best;
+}
+
+// Puts tenant k in the heap, or re-sorts it there. Equal shares go to
+// the tenant that has held less so far, then to the older head task;
+// creation order only settles exact repeats.
+static void drf_heap_put(WfqState *s, int k) {
+    WfqTenant *t = &s->tenants[k];
+    t->head_seq = t->q.a[0].seq;
+    if(t->heap_pos < 0) {
+        t->heap_pos = s->heap_size;
+        s->heap[s->heap_size++] = k;
+    }
+    wfq_heap_fix(s, t->heap_pos);
+}
+
+// Moves tenant k's allocation by (cpus, mem) at time t. The heap key
+// (finish) holds the weighted dominant share.
+static void drf_charge(WfqState *s, const DrfOpts *o, int k, int cpus, int mem, int t) {
+    WfqTenant *tn = &s->tenants[k];
+    tn->share_time += tn->finish * (t - tn->share_since);
+    tn->share_since = t;
+    tn->cpus += cpus;
+    tn->mem_mb += mem;
+    double c = (double)tn->cpus / ((double)o->nodes * o->cpus);
+    double m = (double)tn->mem_mb / ((double)o->nodes * o->mem_mb);
+    tn->finish = (c > m ? c : m) / tn->weight;
+    if(tn->heap_pos >= 0) wfq_heap_fix(s, tn->heap_pos);
+}
+
+SCHED_INLINE Metrics drf_engine(Process processes[], int n, const DrfOpts *o, DrfStats *st,
+                                SchedBeforeFn before) {
+    int *order = arrival_order(processes, n);
+    int *free_cpus = (int*)xcalloc((size_t)o->nodes, sizeof(int), "calloc(nodes)");
+    int *free_mem = (int*)xcalloc((size_t)o->nodes, sizeof(int), "calloc(nodes)");
+    int *node_of = (int*)xcalloc((size_t)n, sizeof(int), "calloc(task nodes)");
+    int *aside = (int*)xcalloc((size_t)n + 1, sizeof(int), "calloc(blocked tenants)");
+    WfqOpts w = { 0, o->weights, o->nweights };
+    WfqState s;
+    memset(&s, 0, sizeof(s));
+    s.tenant_of = (int*)xcalloc((size_t)n, sizeof(int), "calloc(task tenants)");
+    SchedHeap shared = {0}, run = {0};
+    int shared_cap = 0, run_cap = 0;
+    int next = 0, completed = 0, t = 0, queued = 0, busy_cpus = 0;
+    long long used_mem = 0;
+    long long total_cpus = (long long)o->nodes * o->cpus;
+    long long total_mem = (long long)o->nodes * o->mem_mb;
+    double waited = 0.0, cpu_time = 0.0, mem_time = 0.0, free_time = 0.0, frag_time = 0.0;
+    unsigned seq = 0;
+    RunTotals totals = {0};
+    memset(st, 0, sizeof(*st));
+    for(int k = 0; k < o->nodes; k++) {
+        free_cpus[k] = o->cpus;
+        free_mem[k] = o->mem_mb;
+    }
+
+    while(completed + st->rejected < n) {
+        while(run.size > 0 && run.a[0].p->completion_time <= t) {
+            SchedEntry e = sched_heap_pop(&run, drf_finish_before);
+            Process *p = &processes[e.idx];
+            int k = s.tenant_of[e.idx];
+            free_cpus[node_of[e.idx]]++;
+            free_mem[node_of[e.idx]] += p->mem_mb;
+            busy_cpus--;
+            used_mem -= p->mem_mb;
+            drf_charge(&s, o, k, -1, -p->mem_mb, t);
+            complete_sliced(processes, e.idx, t, NULL, NULL, &totals);
+            if(--s.tenants[k].jobs == 0) s.tenants[k].backlogged += t - s.tenants[k].backlog_since;
+            completed++;
+            st->makespan = t;
+        }
+
+        while(next < n && processes[order[next]].arrival_time <= t) {
+            int idx = order[next++];
+            Process *p = &processes[idx];
+            if(p->mem_mb > o->mem_mb) {
+                p->completion_time = -1;
+                st->rejected++;
+                continue;
+            }
+            int k = wfq_tenant(&s, &w, p->name);
+            WfqTenant *tn = &s.tenants[k];
+            s.tenant_of[idx] = k;
+            SchedHeap *q = o->queueing == DRF_TENANTS ? &tn->q : &shared;
+            int *cap = o->queueing == DRF_TENANTS ? &tn->cap : &shared_cap;
+            if(grow_entries(&q->a, cap, q->size + 1) != 0) {
+                perror("realloc(drf queue)");
+                exit(1);
+            }
+            SchedEntry e = { p, idx, seq++ };
+            sched_heap_push(q, e, before);
+            queued++;
+            if(tn->jobs++ == 0) tn->backlog_since = t;
+            if(o->queueing == DRF_TENANTS) drf_heap_put(&s, k);
+        }
+
+        // Dispatch while a CPU is free; blocked is the smallest head that
+        // fit on no node.
+        int naside = 0, blocked = -1;
+        while(busy_cpus < total_cpus) {
+            int k = -1;
+            SchedHeap *q = &shared;
+            if(o->queueing == DRF_TENANTS) {
+                if(s.heap_size == 0) break;
+                k = wfq_heap_pop(&s);
+                q = &s.tenants[k].q;
+            } else if(shared.size == 0) {
+                break;
+            }
+            int node = pack_node(o, free_cpus, free_mem, q->a[0].p->mem_mb);
+            if(node < 0) {
+                if(blocked < 0 || q->a[0].p->mem_mb < blocked) blocked = q->a[0].p->mem_mb;
+                if(k < 0) break;
+                aside[naside++] = k;
+                continue;
+            }
+            SchedEntry e = sched_heap_pop(q, before);
+            Process *p = &processes[e.idx];
+            k = s.tenant_of[e.idx];
+            node_of[e.idx] = node;
+            free_cpus[node]--;
+            free_mem[node] -= p->mem_mb;
+            busy_cpus++;
+            used_mem += p->mem_mb;
+            queued--;
+            p->first_run = t;
+            p->response_time = t - p->arrival_time;
+            p->completion_time = t + p->burst_time;
+            p->remaining_time = 0;
+            if(grow_entries(&run.a, &run_cap, run.size + 1) != 0) {
+                perror("realloc(drf running)");
+                exit(1);
+            }
+            sched_heap_push(&run, e, drf_finish_before);
+            totals.context_switches++;
+            drf_charge(&s, o, k, 1, p->mem_mb, t);
+            if(o->queueing == DRF_TENANTS && s.tenants[k].q.size > 0) drf_heap_put(&s, k);
+        }
+        for(int i = 0; i < naside; i++) drf_heap_put(&s, aside[i]);
+
+        int when = INT_MAX;
+        if(run.size > 0) when = run.a[0].p->completion_time;
+        if(next < n && processes[order[next]].arrival_time < when) when = processes[order[next]].arrival_time;
+        if(when == INT_MAX) break;
+        if(queued > 0) {
+            double dt = when - t;
+            waited += dt;
+            cpu_time += busy_cpus * dt;
+            mem_time += used_mem * dt;
+            free_time += (total_mem - used_mem) * dt;
+            if(blocked >= 0) {
+                long long reachable = 0;
+                for(int k = 0; k < o->nodes; k++) {
+                    if(free_cpus[k] > 0) reachable += free_mem[k];
+                }
+                if(reachable >= blocked) frag_time += reachable * dt;
+            }
+        }
+        t = when;
+    }
+
+    st->admitted = n - st->rejected;
+    st->cpu_pct = waited > 0.0 ? 100.0 * cpu_time / (waited * total_cpus) : 0.0;
+    st->mem_pct = waited > 0.0 ? 100.0 * mem_time / (waited * total_mem) : 0.0;
+    st->frag_pct = free_time > 0.0 ? 100.0 * frag_time / free_time : 0.0;
+    double sum = 0.0, sum_sq = 0.0;
+    for(int k = 0; k < s.index.count; k++) {
+        const WfqTenant *tn = &s.tenants[k];
+        if(tn->backlogged == 0) continue;
+        double x = tn->share_time / tn->backlogged;
+        if(st->tenants == 0 || x < st->min_share) st->min_share = x;
+        if(st->tenants == 0 || x > st->max_share) st->max_share = x;
+        sum += x;
+        sum_sq += x * x;
+        st->tenants++;
+    }
+    st->jain = sum_sq > 0.0 ? sum * sum / (st->tenants * sum_sq) : 1.0;
+
+    wfq_free(&s);
+    free(shared.a);
+    free(run.a);
+    free(aside);
+    free(node_of);
+    free(free_mem);
+    free(free_cpus);
+    free(order);
+    return nonpreemptive_metrics(&totals, st->admitted > 0 ? st->admitted : 1);
+}
+
+// Runs one of main's run-to-completion policies as the order inside each
+// queue. The sliced policies need preemption, which this model has not,
+// so they are refused rather than quietly run as FCFS or priority.
+Metrics drf_schedule(Process processes[], int n, PolicyId policy, const DrfOpts *o, DrfStats *st) {
+    switch(policy) {
+        case POLICY_FCFS:        return drf_engine(processes, n, o, st, fcfs_before);
+        case POLICY_SJF:         return drf_engine(processes, n, o, st, sjf_before);
+        case POLICY_PRIORITY:    return drf_engine(processes, n, o, st, priority_before);
+        default: break;
+    }
+    fprintf(stderr, "drf_schedule: %s needs preemption; use fcfs, sjf or priority\n",
+            policy >= 0 && policy < POLICY_COUNT ? POLICY_NAMES[policy] : "policy");
+    memset(st, 0, sizeof(*st));
+    Metrics none = {0};
+    return none;
+}
+
+// ------------------------------------------------------------
+// Periodic tasks
+// Task i releases a job of wcet_i work at offset_i + k * period_i, due
+// deadline_i later (the period when 0). Jobs are released lazily: a
+// release heap holds each task's next release time, so only one job
+// per task exists before it is released and memory stays O(tasks)
+// however long the hyperperiod is. Jobs of one task run in release
+// order; the ready heap holds tasks with unfinished jobs, ordered by
+// rate-monotonic rank (shorter period first) or by the absolute
+// deadline of their oldest job (EDF). Both are preemptive.
+//
+// The analyses assume synchronous release (offsets ignored), which is
+// the worst case, so they remain safe for any offsets:
+//   hyperbolic bound  prod(U_i + 1) <= 2, sufficient for RM with
+//                     implicit deadlines
+//   response time     R_i = C_i + sum over higher priority j of
+//                     ceil(R_i / T_j) * C_j, exact for fixed priorities.
+//                     Each task starts from R_{i-1} + C_i, a valid
+//                     lower bound, which keeps thousands of tasks cheap.
+//   EDF               U <= 1 for implicit deadlines, otherwise quick
+//                     processor-demand analysis (QPA, Zhang & Burns).
+// ------------------------------------------------------------
+typedef struct {
+    char name[32];
+    int period;
+    int wcet;
+    int offset;
+    int deadline;             // relative; 0: the period
+} PeriodicTask;
+
+typedef enum { PERIODIC_RM, PERIODIC_EDF, PERIODIC_POLICIES } PeriodicPolicy;
+
+typedef struct {
+    double utilization;
+    int hyperbolic_ok;
+    int rta_ok;
+    int rta_failed;           // first task past its deadline in RM order, -1
+    int edf_ok;
+    long long hyperperiod;    // 0: beyond the cap passed in
+    long long *response;      // per task RTA bound, -1 past the deadline; caller's
+} PeriodicAnalysis;
+
+typedef struct {
+    long long released;
+    long long completed;
+    long long missed;
+    long long max_lateness;
+    long long preemptions;
+    long long end;            // time the last job finished
+    long long *max_response;  // per task, if set by the caller
+} PeriodicStats;
+
+static inline long long periodic_deadline(const PeriodicTask *t) {
+    return t->deadline > 0 ? t->deadline : t->period;
+}
+
+static long long gcd_ll(long long a, long long b) {
+    while(b) {
+        long long r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// lcm of the periods, or 0 once it exceeds cap.
+long long periodic_hyperperiod(const PeriodicTask *t, int n, long long cap) {
+    long long h = 1;
+    for(int i = 0; i < n; i++) {
+        long long step = h / gcd_ll(h, t[i].period);
+        if(step > cap / t[i].period) return 0;
+        h = step * t[i].period;
+    }
+    return h;
+}
+
+// Rate-monotonic order: period, then index.
+static const PeriodicTask *g_periodic_sort_base;
+
+static int periodic_rm_order(const void *a, const void *b) {
+    const PeriodicTask *x = &g_periodic_sort_base[*(const int*)a];
+    const PeriodicTask *y = &g_periodic_sort_base[*(const int*)b];
+    if(x->period != y->period) return x->period < y->period ? -1 : 1;
+    return *(const int*)a - *(const int*)b;
+}
+
+// rank[i]: task i's rate-monotonic priority, 0 highest.
+static void periodic_rm_ranks(const PeriodicTask *t, int n, int *rank) {
+    int *order = (int*)xcalloc((size_t)n, sizeof(int), "calloc(periodic)");
+    for(int i = 0; i < n; i++) order[i] = i;
+    g_periodic_sort_base = t;
+    qsort(order, (size_t)n, sizeof(int), periodic_rm_order);
+    for(int k = 0; k < n; k++) rank[order[k]] = k;
+    free(order);
+}
+
+// Demand of the jobs released and due within [0, l].
+static long long periodic_demand(const PeriodicTask *t, int n, long long l) {
+    long long h = 0;
+    for(int i = 0; i < n; i++) {
+        long long d = periodic_deadline(&t[i]);
+        if(l >= d) h += ((l - d) / t[i].period + 1) * t[i].wcet;
+    }
+    return h;
+}
+
+// Latest absolute deadline strictly before l, or -1.
+static long long periodic_deadline_before(const PeriodicTask *t, int n, long long l) {
+    long long best = -1;
+    for(int i = 0; i < n; i++) {
+        long long d = periodic_deadline(&t[i]);
+        if(l <= d) continue;
+        long long k = (l - d - 1) / t[i].period;
+        if(d + k * t[i].period > best) best = d + k * t[i].period;
+    }
+    return best;
+}
+
+static int periodic_edf_test(const PeriodicTask *t, int n, double u, long long cap) {
+    if(u > 1.0 + 1e-12) return 0;
+    int constrained = 0;
+    long long dmin = LLONG_MAX, dmax = 0, busy = 0;
+    double la = 0.0;
+    for(int i = 0; i < n; i++) {
+        long long d = periodic_deadline(&t[i]);
+        if(d < t[i].period) constrained = 1;
+        if(d < dmin) dmin = d;
+        if(d > dmax) dmax = d;
+        la += (double)(t[i].period - d) * t[i].wcet / t[i].period;
+        busy += t[i].wcet;
+    }
+    if(!constrained) return 1;
+
+    // Check deadlines up to the shorter of the synchronous busy period
+    // (w = sum ceil(w / T_i) * C_i) and, when U < 1, the La bound. At
+    // U = 1 the busy period can run for the whole hyperperiod, which
+    // bounds it directly.
+    long long l = periodic_hyperperiod(t, n, cap);
+    if(l == 0) l = cap;
+    if(u < 1.0 - 1e-12) {
+        la = la / (1.0 - u);
+        long long bound = la > (double)dmax ? (long long)la + 1 : dmax;
+        if(bound < l) l = bound;
+        while(busy < l) {
+            long long w = 0;
+            for(int i = 0; i < n; i++) w += (busy + t[i].period - 1) / t[i].period * t[i].wcet;
+            if(w == busy) {
+                l = busy;
+                break;
+            }
+            busy = w;
+        }
+    }
+
+    long long at = periodic_deadline_before(t, n, l + 1);
+    while(at >= dmin) {
+        long long h = periodic_demand(t, n, at);
+        if(h > at) return 0;
+        if(h <= dmin) return 1;
+        at = h < at ? h : periodic_deadline_before(t, n, at);
+    }
+    return 1;
+}
+
+void periodic_analyse(const PeriodicTask *t, int n, long long cap, PeriodicAnalysis *a) {
+    long long *response = a->response;
+    memset(a, 0, sizeof(*a));
+    a->response = response;
+
+    double hyper = 1.0;
+    for(int i = 0; i < n; i++) {
+        double ui = (double)t[i].wcet / t[i].period;
+        a->utilization += ui;
+        hyper *= ui + 1.0;
+    }
+    a->hyperbolic_ok = hyper <= 2.0;
+    for(int i = 0; i < n; i++) {
+        if(periodic_deadline(&t[i]) < t[i].period) a->hyperbolic_ok = 0;
+    }
+    a->hyperperiod = periodic_hyperperiod(t, n, cap);
+    a->edf_ok = periodic_edf_test(t, n, a->utilization, cap);
+
+    int *rank = (int*)xcalloc((size_t)n, sizeof(int), "calloc(periodic)");
+    int *order = (int*)xcalloc((size_t)n, sizeof(int), "calloc(periodic)");
+    periodic_rm_ranks(t, n, rank);
+    for(int i = 0; i < n; i++) order[rank[i]] = i;
+    if(response) {
+        for(int i = 0; i < n; i++) response[i] = -1;
+    }
+
+    a->rta_ok = 1;
+    a->rta_failed = -1;
+    long long r = 0;
+    for(int k = 0; k < n; k++) {
+        const PeriodicTask *ti = &t[order[k]];
+        long long d = periodic_deadline(ti);
+        long long w = r + ti->wcet;
+        for(;;) {
+            long long next = ti->wcet;
+            for(int j = 0; j < k && next <= d; j++) {
+                const PeriodicTask *tj = &t[order[j]];
+                next += (w + tj->period - 1) / tj->period * tj->wcet;
+            }
+            if(next == w || next > d) {
+                w = next;
+                break;
+            }
+            w = next;
+        }
+        if(w > d) {
+            a->rta_ok = 0;
+            a->rta_failed = order[k];
+            break;
+        }
+        if(response) response[order[k]] = w;
+        r = w;
+    }
+    free(order);
+    free(rank);
+}
+
+typedef struct {
+    long long next_release;   // of the task's next unreleased job
+    long long head_release;   // of its oldest unfinished job
+    long long head_left;
+    int pending;              // released, unfinished jobs
+} PeriodicState;
+
+typedef struct {
+    const PeriodicTask *t;
+    PeriodicState *s;
+    const int *rank;
+    PeriodicPolicy policy;
+} PeriodicSim;
+
+static inline int periodic_release_before(const PeriodicSim *sim, int a, int b) {
+    if(sim->s[a].next_release != sim->s[b].next_release) {
+        return sim->s[a].next_release < sim->s[b].next_release;
+    }
+    return a < b;
+}
+
+static inline int periodic_ready_before(const PeriodicSim *sim, int a, int b) {
+    if(sim->policy == PERIODIC_EDF) {
+        long long da = sim->s[a].head_release + periodic_deadline(&sim->t[a]);
+        long long db = sim->s[b].head_release + periodic_deadline(&sim->t[b]);
+        if(da != db) return da < db;
+    }
+    return sim->rank[a] < sim->rank[b];
+}
+
+static void periodic_sift_down(const PeriodicSim *sim, int *h, int size, int pos, int ready) {
+    int x = h[pos];
+    for(;;) {
+        int c = 2 * pos + 1;
+        if(c >= size) break;
+        if(c + 1 < size && (ready ? periodic_ready_before(sim, h[c + 1], h[c])
+                                  : periodic_release_before(sim, h[c + 1], h[c]))) c++;
+        if(!(ready ? periodic_ready_before(sim, h[c], x) : periodic_release_before(sim, h[c], x))) break;
+        h[pos] = h[c];
+        pos = c;
+    }
+    h[pos] = x;
+}
+
+static void periodic_push(const PeriodicSim *sim, int *h, int *size, int x, int ready) {
+    int pos = (*size)++;
+    while(pos > 0) {
+        int parent = (pos - 1) / 2;
+        if(!(ready ? periodic_ready_before(sim, x, h[parent])
+                   : periodic_release_before(sim, x, h[parent]))) break;
+        h[pos] = h[parent];
+        pos = parent;
+    }
+    h[pos] = x;
+}
+
+static void periodic_pop(const PeriodicSim *sim, int *h, int *size, int ready) {
+    h[0] = h[--*size];
+    if(*size > 0) periodic_sift_down(sim, h, *size, 0, ready);
+}
+
+// Releases every job before horizon and runs them all to completion.
+void periodic_simulate(const PeriodicTask *t, int n, PeriodicPolicy policy, long long horizon,
+                       PeriodicStats *st) {
+    long long *max_response = st->max_response;
+    memset(st, 0, sizeof(*st));
+    st->max_response = max_response;
+    if(max_response) memset(max_response, 0, (size_t)n * sizeof(long long));
+
+    PeriodicState *s = (PeriodicState*)xcalloc((size_t)n, sizeof(PeriodicState), "calloc(periodic)");
+    int *rank = (int*)xcalloc((size_t)n, sizeof(int), "calloc(periodic)");
+    int *releases = (int*)xcalloc((size_t)n, sizeof(int), "calloc(periodic)");
+    int *ready = (int*)xcalloc((size_t)n, sizeof(int), "calloc(periodic)");
+    int nreleases = 0, nready = 0;
+    periodic_rm_ranks(t, n, rank);
+    PeriodicSim sim = { t, s, rank, policy };
+
+    for(int i = 0; i < n; i++) {
+        s[i].next_release = t[i].offset;
+        if(s[i].next_release < horizon) periodic_push(&sim, releases, &nreleases, i, 0);
+    }
+
+    long long now = 0;
+    int last = -1;
+    for(;;) {
+        while(nreleases > 0 && s[releases[0]].next_release <= now) {
+            int i = releases[0];
+            if(s[i].pending++ == 0) {
+                s[i].head_release = s[i].next_release;
+                s[i].head_left = t[i].wcet;
+                periodic_push(&sim, ready, &nready, i, 1);
+            }
+            st->released++;
+            s[i].next_release += t[i].period;
+            if(s[i].next_release < horizon) {
+                periodic_sift_down(&sim, releases, nreleases, 0, 0);
+            } else {
+                periodic_pop(&sim, releases, &nreleases, 0);
+            }
+        }
+        if(nready == 0) {
+            if(nreleases == 0) break;
+            now = s[releases[0]].next_release;
+            continue;
+        }
+
+        int i = ready[0];
+        if(last >= 0 && last != i && s[last].pending > 0 && s[last].head_left < t[last].wcet) {
+            st->preemptions++;
+        }
+        last = i;
+        long long until = now + s[i].head_left;
+        if(nreleases > 0 && s[releases[0]].next_release < until) until = s[releases[0]].next_release;
+        s[i].head_left -= until - now;
+        now = until;
+        if(s[i].head_left > 0) continue;
+
+        long long response = now - s[i].head_release;
+        long long lateness = response - periodic_deadline(&t[i]);
+        if(lateness > 0) st->missed++;
+        if(st->completed == 0 || lateness > st->max_lateness) st->max_lateness = lateness;
+        if(max_response && response > max_response[i]) max_response[i] = response;
+        st->completed++;
+        st->end = now;
+        if(--s[i].pending > 0) {
+            s[i].head_release += t[i].period;
+            s[i].head_left = t[i].wcet;
+            periodic_sift_down(&sim, ready, nready, 0, 1);
+        } else {
+            periodic_pop(&sim, ready, &nready, 1);
+        }
+    }
+    free(ready);
+    free(releases);
+    free(rank);
+    free(s);
+}
+
+// ------------------------------------------------------------
+// CPU/IO burst sequences
+// A process with io_count > 0 alternates CPU and I/O: its bursts are
+// pool->len[io_first .. io_first + 2*io_count], CPU first and last, and
+// burst_time is the sum of its CPU bursts. While a task waits for I/O
+// it sits on a timing wheel keyed by completion time and the CPU runs
+// whatever else is ready.
+// ------------------------------------------------------------
+typedef struct {
+    int *len;
+    int size;
+    int cap;
+} BurstPool;
+
+static int burst_pool_add(BurstPool *bp, int len) {
+    if(bp->size == bp->cap) {
+        int cap = bp->cap ? bp->cap * 2 : 1024;
+        int *grown = (int*)realloc(bp->len, (size_t)cap * sizeof(int));
+        if(!grown) {
+            perror("realloc(bursts)");
+            exit(1);
+        }
+        bp->len = grown;
+        bp->cap = cap;
+    }
+    bp->len[bp->size] = len;
+    return bp->size++;
+}
+
+void burst_pool_free(BurstPool *bp) {
+    free(bp->len);
+    memset(bp, 0, sizeof(*bp));
+}
+
+// Hashed timing wheel: one slot per time unit modulo the wheel size,
+// entries keep their absolute expiry and fire when the cursor reaches
+// it. Insert is O(1); lists are FIFO so equal expiries fire in order.
+#define IO_WHEEL_SLOTS 256
+
+typedef struct {
+    int head[IO_WHEEL_SLOTS];
+    int tail[IO_WHEEL_SLOTS];
+    int *next;        // per process link, -1 terminates
+    int *when;        // per process expiry
+    int now;          // every expiry <= now has fired
+    int count;
+} IoWheel;
+
+static void io_wheel_init(IoWheel *w, int n) {
+    memset(w->head, 0xff, sizeof(w->head));
+    memset(w->tail, 0xff, sizeof(w->tail));
+    w->next = (int*)xcalloc((size_t)n, sizeof(int), "calloc(io wheel)");
+    w->when = (int*)xcalloc((size_t)n, sizeof(int), "calloc(io wheel)");
+    w->now = 0;
+    w->count = 0;
+}
+
+static void io_wheel_free(IoWheel *w) {
+    free(w->next);
+    free(w->when);
+}
+
+static inline void io_wheel_insert(IoWheel *w, int idx, int when) {
+    int s = when & (IO_WHEEL_SLOTS - 1);
+    w->when[idx] = when;
+    w->next[idx] = -1;
+    if(w->tail[s] < 0) w->head[s] = idx;
+    else w->next[w->tail[s]] = idx;
+    w->tail[s] = idx;
+    w->count++;
+}
+
+// Earliest pending expiry, or INT_MAX when the wheel is empty.
+static int io_wheel_next(const IoWheel *w) {
+    if(w->count == 0) return INT_MAX;
+    int best = INT_MAX;
+    for(int d = 1; d <= IO_WHEEL_SLOTS; d++) {
+        int s = (w->now + d) & (IO_WHEEL_SLOTS - 1);
+        for(int i = w->head[s]; i >= 0; i = w->next[i]) {
+            if(w->when[i] < best) best = w->when[i];
+        }
+        if(best <= w->now + d) break;   // nothing can expire earlier
+    }
+    return best;
+}
+
+typedef struct {
+    int makespan;
+    long long busy;          // time the CPU ran tasks
+    long long io_wait;       // CPU idle while some task was blocked on I/O
+    long long blocked;       // sum over tasks of time spent in I/O
+} IoStats;
+
+// Queues arrivals up to t, then I/O completions up to t in expiry order.
+SCHED_INLINE void io_admit(Process processes[], int n, const int *order, int *next,
+                           IoWheel *w, SchedHeap *ready, unsigned *seq, int t,
+                           SchedBeforeFn before) {
+    while(*next < n && processes[order[*next]].arrival_time <= t) {
+        int i = order[(*next)++];
+        SchedEntry e = { &processes[i], i, (*seq)++ };
+        sched_heap_push(ready, e, before);
+    }
+    if(w->count == 0) {
+        w->now = t;
+        return;
+    }
+    while(w->now < t && w->count > 0) {
+        int s = ++w->now & (IO_WHEEL_SLOTS - 1);
+        int prev = -1;
+        for(int i = w->head[s]; i >= 0;) {
+            int after = w->next[i];
+            if(w->when[i] == w->now) {
+                if(prev < 0) w->head[s] = after;
+                else w->next[prev] = after;
+                if(w->tail[s] == i) w->tail[s] = prev;
+                w->count--;
+                SchedEntry e = { &processes[i], i, (*seq)++ };
+                sched_heap_push(ready, e, before);
+            } else {
+                prev = i;
+            }
+            i = after;
+        }
+    }
+    if(w->now < t) w->now = t;
+}
+
+SCHED_INLINE Metrics io_engine(Process processes[], int n, const BurstPool *pool, int quantum,
+                               IoStats *st, SchedBeforeFn before) {
+    int *order = arrival_order(processes, n);
+    int *phase = (int*)xcalloc((size_t)n, sizeof(int), "calloc(io phase)");
+    int *cpu_left = (int*)xcalloc((size_t)n, sizeof(int), "calloc(io phase)");
+    int *io_total = (int*)xcalloc((size_t)n, sizeof(int), "calloc(io phase)");
+    SchedHeap ready = { (SchedEntry*)xcalloc((size_t)n, sizeof(SchedEntry), "calloc(ready)"), 0 };
+    IoWheel wheel;
+    io_wheel_init(&wheel, n);
+    for(int i = 0; i < n; i++) {
+        cpu_left[i] = processes[i].io_count > 0 ? pool->len[processes[i].io_first] : processes[i].burst_time;
+    }
+
+    RunTotals totals = {0};
+    int next = 0, completed = 0, t = 0, last_executed = -1;
+    unsigned seq = 0;
+    memset(st, 0, sizeof(*st));
+
+    while(completed != n) {
+        io_admit(processes, n, order, &next, &wheel, &ready, &seq, t, before);
+
+        if(ready.size == 0) {
+            int arrival = next < n ? processes[order[next]].arrival_time : INT_MAX;
+            int io_done = io_wheel_next(&wheel);
+            int until = arrival < io_done ? arrival : io_done;
+            if(wheel.count > 0) st->io_wait += until - t;
+            t = until;
+            last_executed = -1;
+            continue;
+        }
+
+        SchedEntry e = sched_heap_pop(&ready, before);
+        int idx = e.idx;
+        Process *p = &processes[idx];
+        if(idx != last_executed) {
+            totals.context_switches++;
+            last_executed = idx;
+        }
+
+        int slice = cpu_left[idx];
+        if(quantum > 0 && slice > quantum) slice = quantum;
+        simulate_work(slice);
+        cpu_left[idx] -= slice;
+        p->remaining_time -= slice;
+        t += slice;
+        st->busy += slice;
+
+        if(cpu_left[idx] > 0) {
+            // Preempted: anything that arrived or finished I/O meanwhile goes first.
+            io_admit(processes, n, order, &next, &wheel, &ready, &seq, t, before);
+            e.seq = seq++;
+            sched_heap_push(&ready, e, before);
+        } else if(phase[idx] < 2 * p->io_count) {
+            // CPU burst done: block for the following I/O burst.
+            int io = pool->len[p->io_first + phase[idx] + 1];
+            phase[idx] += 2;
+            cpu_left[idx] = pool->len[p->io_first + phase[idx]];
+            io_total[idx] += io;
+            st->blocked += io;
+            io_wheel_insert(&wheel, idx, t + io);
+            last_executed = -1;
+        } else {
+            complete_sliced(processes, idx, t, NULL, NULL, &totals);
+            // Time in I/O is not time spent waiting for the CPU.
+            p->waiting_time -= io_total[idx];
+            totals.total_waiting_time -= io_total[idx];
+            completed++;
+            st->makespan = t;
+            last_executed = -1;
+        }
+    }
+
+    io_wheel_free(&wheel);
+    free(ready.a);
+    free(io_total);
+    free(cpu_left);
+    free(phase);
+    free(order);
+    return quantum_metrics(&totals, n);
+}
+
+Metrics io_schedule(Process processes[], int n, const BurstPool *pool, PolicyId policy,
+                    int quantum, IoStats *st) {
+    switch(policy) {
+        case POLICY_FCFS:        return io_engine(processes, n, pool, 0, st, fcfs_before);
+        case POLICY_SJF:         return io_engine(processes, n, pool, 0, st, sjf_before);
+        case POLICY_PRIORITY:    return io_engine(processes, n, pool, 0, st, priority_before);
+        case POLICY_RR:          return io_engine(processes, n, pool, quantum, st, rr_before);
+        case POLICY_PRIORITY_RR: return io_engine(processes, n, pool, quantum, st, priority_before);
+        default: break;
+    }
+    Metrics none = {0};
+    return none;
+}
+
+// ------------------------------------------------------------
+// Synthetic banking workload
+// Task classes from the demo table; each job's burst is jittered
+// to [mean/2, 3*mean/2] around its class mean so the classes stay
+// predictable without being constant.
+// ------------------------------------------------------------
+typedef struct {
+    const char *name;
+    int mean_burst;
+    int priority;
+    int working_set_kb;
+    int io_phases;           // I/O waits between CPU bursts
+    int io_mean;
+    int mem_mb;
+} TaskClass;
+
+static const TaskClass BANKING_CLASSES[] = {
+    {"Transfer", 8, 2,  512, 2,  6,  256},   // ledger read, ledger write
+    {"Inquiry",  4, 1,  128, 1,  4,   64},   // balance lookup
+    {"Fraud",    9, 3, 4096, 2,  8, 3072},   // history scan, model fetch
+    {"Payment",  5, 2,  256, 2,  5,  128},   // gateway call, ledger write
+    {"Logging",  2, 1,   64, 1, 10,   32}    // disk flush
+};
+#define BANKING_NCLASSES ((int)(sizeof(BANKING_CLASSES) / sizeof(BANKING_CLASSES[0])))
+
+// Draws from RNG_STREAM_WORKLOAD of seed; policy runs use later streams.
+// Memory demands, jittered like bursts, come from a stream of their own
+// so adding them left the rest of the workload unchanged.
+void generate_banking_workload(Process *p, int n, uint64_t seed, int max_gap) {
+    Rng r, mem;
+    rng_stream(&r, seed, RNG_STREAM_WORKLOAD);
+    rng_stream(&mem, seed, RNG_STREAM_MEM_WORKLOAD);
+    int arrival = 0;
+    for(int i = 0; i < n; i++) {
+        const TaskClass *c = &BANKING_CLASSES[rng_below(&r, BANKING_NCLASSES)];
+        int lo = c->mean_burst / 2 > 0 ? c->mean_burst / 2 : 1;
+        int hi = c->mean_burst + c->mean_burst / 2;
+        memset(&p[i], 0, sizeof(Process));
+        p[i].pid = i + 1;
+        snprintf(p[i].name, sizeof(p[i].name), "%s", c->name);
+        p[i].arrival_time = arrival;
+        p[i].burst_time = lo + (int)rng_below(&r, (uint64_t)(hi - lo + 1));
+        p[i].priority = c->priority;
+        p[i].working_set_kb = c->working_set_kb;
+        p[i].mem_mb = c->mem_mb / 2 + (int)rng_below(&mem, (uint64_t)(c->mem_mb + 1));
+        p[i].remaining_time = p[i].burst_time;
+        p[i].first_run = -1;
+        arrival += (int)rng_below(&r, (uint64_t)(max_gap + 1));
+    }
+}
+
+// Splits each task's CPU time into io_phases + 1 bursts separated by
+// I/O bursts of around the class's mean I/O time. Draws from its own
+// stream of seed so the CPU-only workload is unchanged.
+void generate_io_bursts(Process *p, int n, uint64_t seed, BurstPool *pool) {
+    Rng r;
+    rng_stream(&r, seed, RNG_STREAM_IO_WORKLOAD);
+    for(int i = 0; i < n; i++) {
+        const TaskClass *c = NULL;
+        for(int k = 0; k < BANKING_NCLASSES; k++) {
+            if(strcmp(BANKING_CLASSES[k].name, p[i].name) == 0) c = &BANKING_CLASSES[k];
+        }
+        int phases = c ? c->io_phases : 1;
+        int io_mean = c ? c->io_mean : 5;
+        if(phases > p[i].burst_time - 1) phases = p[i].burst_time - 1;
+        p[i].io_count = phases;
+        if(phases <= 0) {
+            p[i].io_first = 0;
+            p[i].io_count = 0;
+            continue;
+        }
+        int base = p[i].burst_time / (phases + 1);
+        int extra = p[i].burst_time % (phases + 1);
+        int lo = io_mean / 2 > 0 ? io_mean / 2 : 1;
+        int hi = io_mean + io_mean / 2;
+        p[i].io_first = burst_pool_add(pool, base + (extra-- > 0));
+        for(int k = 0; k < phases; k++) {
+            burst_pool_add(pool, lo + (int)rng_below(&r, (uint64_t)(hi - lo + 1)));
+            burst_pool_add(pool, base + (extra-- > 0));
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// Periodic batch workload (--periodic=N, --periodic-file=PATH)
+// Generated tasks take a period from a menu whose lcm is 10^7 and a
+// share of the total utilization: the spacings of n - 1 sorted uniform
+// points, which are uniform over all splits (UUniFast's distribution).
+// WCETs are rounded, at least 1, so tiny shares inflate slightly.
+// ------------------------------------------------------------
+static const char *PERIODIC_CLASSES[] = {"Statement", "Reconcile", "Interest", "Settlement", "Report"};
+static const int PERIODIC_PERIODS[] = {100000, 200000, 250000, 400000, 500000,
+                                       1000000, 2000000, 2500000, 5000000, 10000000};
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+void generate_periodic_tasks(PeriodicTask *t, int n, double util, uint64_t seed) {
+    Rng r;
+    rng_stream(&r, seed, RNG_STREAM_PERIODIC);
+    double *cut = (double*)xcalloc((size_t)n + 1, sizeof(double), "calloc(periodic)");
+    for(int i = 1; i < n; i++) cut[i] = (double)(rng_next(&r) >> 11) / 9007199254740992.0;
+    cut[n] = 1.0;
+    qsort(cut + 1, (size_t)(n > 1 ? n - 1 : 0), sizeof(double), cmp_double);
+    int nperiods = (int)(sizeof(PERIODIC_PERIODS) / sizeof(PERIODIC_PERIODS[0]));
+    for(int i = 0; i < n; i++) {
+        PeriodicTask *p = &t[i];
+        snprintf(p->name, sizeof(p->name), "%s-%d", PERIODIC_CLASSES[i % 5], i / 5 + 1);
+        p->period = PERIODIC_PERIODS[rng_below(&r, (uint64_t)nperiods)];
+        p->wcet = (int)((cut[i + 1] - cut[i]) * util * p->period + 0.5);
+        if(p->wcet < 1) p->wcet = 1;
+        p->offset = 0;
+        p->deadline = 0;
+    }
+    free(cut);
+}
+
+// One task per line: NAME PERIOD WCET [OFFSET [DEADLINE]], with '#'
+// starting a comment. Deadlines must not exceed the period.
+PeriodicTask* load_periodic_tasks(const char *path, int *count) {
+    FILE *f = fopen(path, "r");
+    if(!f) {
+        perror(path);
+        return NULL;
+    }
+    int n = 0, cap = 0, line_no = 0;
+    PeriodicTask *t = NULL;
+    char line[256];
+    while(fgets(line, sizeof(line), f)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if(hash) *hash = '\0';
+        PeriodicTask p;
+        memset(&p, 0, sizeof(p));
+        char name[64];
+        int fields = sscanf(line, "%63s %d %d %d %d", name, &p.period, &p.wcet, &p.offset, &p.deadline);
+        if(fields <= 0) continue;
+        if(fields < 3 || p.period < 1 || p.wcet < 1 || p.offset < 0
+            || p.deadline < 0 || p.deadline > p.period || strlen(name) >= sizeof(p.name)) {
+            fprintf(stderr, "%s:%d: expected NAME PERIOD WCET [OFFSET [DEADLINE]]\n", path, line_no);
+            fclose(f);
+            free(t);
+            return NULL;
+        }
+        strcpy(p.name, name);
+        if(n == cap) {
+            cap = cap ? 2 * cap : 64;
+            t = (PeriodicTask*)realloc(t, (size_t)cap * sizeof(PeriodicTask));
+            if(!t) {
+                perror("realloc(periodic)");
+                exit(1);
+            }
+        }
+        t[n++] = p;
+    }
+    fclose(f);
+    if(n == 0) {
+        fprintf(stderr, "%s: no periodic tasks\n", path);
+        free(t);
+        return NULL;
+    }
+    *count = n;
+    return t;
+}
+
+// ------------------------------------------------------------
+// Trace import (--import-perf=FILE, --import-schedstat=FILE)
+// Both importers map the file and parse it in place one line at a
+// time, keeping only per-task state, so a large capture costs one
+// sequential pass and memory in proportion to the tasks it names.
+// Host times are nanoseconds; unit_ns of them make one simulated
+// time unit. Arrivals count from the first timestamp in the file and
+// bursts round to the nearest unit, at least 1.
+// ------------------------------------------------------------
+#define IMPORT_MAX_CPUS 4096
+#define IMPORT_DEFAULT_PRIO 120   // kernel priority of a nice-0 task
+
+typedef struct {
+    int pid;
+    int prio;
+    int runnable;            // woken and not yet blocked: a job is open
+    long long arrival_ns;    // when the open job became runnable
+    long long run_ns;        // CPU time of the open job so far
+    long long on_cpu_ns;     // switch-in time while running, else -1
+    long long last_run_ns;   // schedstat: run time at the previous sample
+    long long last_ts;       // schedstat: time of the previous sample
+    char comm[32];
+} ImportTask;
+
+typedef struct {
+    int arrival, burst, prio;
+    char comm[32];
+} ImportJob;
+
+typedef struct {
+    const char *path;
+    long long unit_ns;
+    long long t0;            // first timestamp, -1 until seen
+    ImportTask *tasks;       // by KeyIndex id of the pid
+    int task_cap;
+    KeyIndex index;
+    ImportJob *jobs;         // in the order they closed
+    int n, cap;
+    int overflow;
+    long long lines, skipped;
+} Importer;
+
+static void import_init(Importer *im, const char *path, long long unit_ns) {
+    memset(im, 0, sizeof(*im));
+    im->path = path;
+    im->unit_ns = unit_ns;
+    im->t0 = -1;
+}
+
+static const char* import_map(const char *path, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) {
+        perror(path);
+        return NULL;
+    }
+    struct stat sb;
+    void *map = MAP_FAILED;
+    if(fstat(fd, &sb) == 0 && sb.st_size > 0) {
+        map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if(map == MAP_FAILED) {
+        fprintf(stderr, "%s: empty or unreadable\n", path);
+        return NULL;
+    }
+    madvise(map, (size_t)sb.st_size, MADV_SEQUENTIAL);
+    *len = (size_t)sb.st_size;
+    return (const char*)map;
+}
+
+static int import_pid_is(const void *records, int id, const void *key) {
+    return ((const ImportTask*)records)[id].pid == *(const int*)key;
+}
+
+static ImportTask* import_task(Importer *im, int pid) {
+    uint64_t h = (uint64_t)(unsigned)pid * 0x9E3779B97F4A7C15ULL;
+    int k = key_index_find(&im->index, h, import_pid_is, im->tasks, &pid);
+    if(k >= 0) return &im->tasks[k];
+    im->tasks = (ImportTask*)grow_records(im->tasks, &im->task_cap, im->index.count + 1,
+                                          sizeof(ImportTask), "realloc(import)");
+    ImportTask *tk = &im->tasks[key_index_add(&im->index, h)];
+    memset(tk, 0, sizeof(*tk));
+    tk->pid = pid;
+    tk->prio = IMPORT_DEFAULT_PRIO;
+    tk->on_cpu_ns = -1;
+    return tk;
+}
+
+static void import_set_comm(ImportTask *tk, const char *s, const char *e) {
+    size_t len = (size_t)(e - s);
+    if(len >= sizeof(tk->comm)) len = sizeof(tk->comm) - 1;
+    memcpy(tk->comm, s, len);
+    tk->comm[len] = '\0';
+}
+
+static void import_job(Importer *im, const ImportTask *tk, long long arrival_ns, long long run_ns) {
+    long long at = arrival_ns > im->t0 ? (arrival_ns - im->t0) / im->unit_ns : 0;
+    long long bt = (run_ns + im->unit_ns / 2) / im->unit_ns;
+    if(bt < 1) bt = 1;
+    if(at > INT_MAX / 2 || bt > INT_MAX / 2 || im->n == INT_MAX / 2) {
+        im->overflow = 1;
+        return;
+    }
+    if(im->n == im->cap) {
+        im->cap = im->cap ? 2 * im->cap : 1024;
+        im->jobs = (ImportJob*)realloc(im->jobs, (size_t)im->cap * sizeof(ImportJob));
+        if(!im->jobs) {
+            perror("realloc(import)");
+            exit(1);
+        }
+    }
+    ImportJob *j = &im->jobs[im->n++];
+    j->arrival = (int)at;
+    j->burst = (int)bt;
+    j->prio = tk->prio;
+    memcpy(j->comm, tk->comm, sizeof(j->comm));
+}
+
+static int import_cmp_key(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorts the jobs by arrival (ties in the order they closed) into a
+// numbered Process array; NULL if there was nothing usable. Sorting
+// 8-byte keys keeps the much larger Process records out of the sort.
+static Process* import_finish(Importer *im, int *count, long start_us) {
+    int tasks = im->index.count;
+    free(im->tasks);
+    key_index_free(&im->index);
+    if(im->overflow || im->n == 0) {
+        if(im->overflow) {
+            fprintf(stderr, "%s: trace does not fit a %lld ns time unit; raise --import-unit-us\n",
+                    im->path, im->unit_ns);
+        } else {
+            fprintf(stderr, "%s: no jobs found\n", im->path);
+        }
+        free(im->jobs);
+        return NULL;
+    }
+    uint64_t *key = (uint64_t*)xcalloc((size_t)im->n, sizeof(uint64_t), "calloc(import)");
+    for(int i = 0; i < im->n; i++) key[i] = (uint64_t)im->jobs[i].arrival << 32 | (uint32_t)i;
+    qsort(key, (size_t)im->n, sizeof(uint64_t), import_cmp_key);
+    Process *p = (Process*)xcalloc((size_t)im->n, sizeof(Process), "calloc(import)");
+    for(int i = 0; i < im->n; i++) {
+        const ImportJob *j = &im->jobs[(uint32_t)key[i]];
+        p[i].pid = i + 1;
+        strcpy(p[i].name, j->comm[0] ? j->comm : "task");
+        p[i].arrival_time = j->arrival;
+        p[i].burst_time = j->burst;
+        p[i].priority = j->prio;
+        p[i].remaining_time = j->burst;
+        p[i].first_run = -1;
+    }
+    free(key);
+    free(im->jobs);
+    fprintf(stderr, "import: %s: %d jobs from %d tasks (%lld lines, %lld skipped) in %ld us\n",
+            im->path, im->n, tasks, im->lines, im->skipped, get_time_microseconds() - start_us);
+    *count = im->n;
+    return p;
+}
+
+// Skips blanks, then reads a decimal integer; NULL if there is none.
+static const char* import_int(const char *s, const char *e, long long *v) {
+    while(s < e && (*s == ' ' || *s == '\t')) s++;
+    if(s == e || *s < '0' || *s > '9') return NULL;
+    long long x = 0;
+    while(s < e && *s >= '0' && *s <= '9' && x < LLONG_MAX / 10 - 9) x = 10 * x + (*s++ - '0');
+    *v = x;
+    return s;
+}
+
+// The integer ending at e (after trailing blanks); returns its start.
+static const char* import_int_back(const char *s, const char *e, long long *v) {
+    while(e > s && (e[-1] == ' ' || e[-1] == '\t')) e--;
+    const char *b = e;
+    while(b > s && b[-1] >= '0' && b[-1] <= '9') b--;
+    if(b == e || !import_int(b, e, v)) return NULL;
+    return b;
+}
+
+// SECONDS.FRACTION as nanoseconds.
+static const char* import_seconds(const char *s, const char *e, long long *ns) {
+    long long sec, frac = 0;
+    int digits = 0;
+    s = import_int(s, e, &sec);
+    if(!s) return NULL;
+    if(s < e && *s == '.') {
+        for(s++; s < e && *s >= '0' && *s <= '9'; s++) {
+            if(digits < 9) {
+                frac = 10 * frac + (*s - '0');
+                digits++;
+            }
+        }
+    }
+    for(; digits < 9; digits++) frac *= 10;
+    *ns = sec * 1000000000LL + frac;
+    return s;
+}
+
+// memmem's general search costs more than it saves on lines this
+// short. Keys start with a blank and end in '=' or ':', so stepping
+// between occurrences of the last character skips the most.
+static const char* import_find(const char *s, const char *e, const char *needle) {
+    size_t k = strlen(needle);
+    for(const char *p = s + k - 1; p < e; p++) {
+        p = (const char*)memchr(p, needle[k - 1], (size_t)(e - p));
+        if(!p) return NULL;
+        if(memcmp(p - (k - 1), needle, k) == 0) return p - (k - 1);
+    }
+    return NULL;
+}
+
+typedef struct {
+    long long pid, prio;
+    const char *comm, *comm_end;
+    char state;
+} ImportSide;
+
+// Tracepoint field names: pid, comm and prio of each side.
+enum { IMPORT_PREV, IMPORT_NEXT, IMPORT_WAKEUP };
+static const char *const IMPORT_KEYS[3][3] = {
+    {" prev_pid=", " prev_comm=", " prev_prio="},
+    {" next_pid=", " next_comm=", " next_prio="},
+    {" pid=",      " comm=",      " prio="}
+};
+
+// One side of a switch, or a wakeup's target, in either format perf
+// prints: "prev_comm=a prev_pid=1 prev_prio=120 prev_state=S" from the
+// tracepoint, or "a:1 [120] S" from newer perf.
+static int import_side(const char *s, const char *e, int which, ImportSide *side) {
+    const char *const *key = IMPORT_KEYS[which];
+    size_t comm_len = strlen(key[1]) - 1;
+    side->prio = IMPORT_DEFAULT_PRIO;
+    side->state = 'R';
+    while(s < e && *s == ' ') s++;
+    if((size_t)(e - s) > comm_len && memcmp(s, key[1] + 1, comm_len) == 0) {
+        // Fields follow the tracepoint's order; only comm, which may
+        // hold blanks, needs a search for the key after it.
+        side->comm = s + comm_len;
+        side->comm_end = import_find(side->comm, e, key[0]);
+        const char *p = side->comm_end ? import_int(side->comm_end + strlen(key[0]), e, &side->pid) : NULL;
+        if(!p) return -1;
+        size_t prio_len = strlen(key[2]);
+        if((size_t)(e - p) > prio_len && memcmp(p, key[2], prio_len) == 0) {
+            p = import_int(p + prio_len, e, &side->prio);
+            if(!p) return -1;
+        }
+        if(which == IMPORT_PREV && e - p > 12 && memcmp(p, " prev_state=", 12) == 0) side->state = p[12];
+        return 0;
+    }
+    const char *bracket = import_find(s, e, " [");
+    if(!bracket) return -1;
+    const char *colon = bracket;
+    while(colon > s && colon[-1] != ':') colon--;
+    if(colon == s || !import_int(colon, bracket, &side->pid)) return -1;
+    side->comm = s;
+    side->comm_end = colon - 1;
+    const char *close = import_int(bracket + 2, e, &side->prio);
+    if(close && close < e && *close == ']') {
+        for(close++; close < e && *close == ' '; close++) {}
+        if(close < e) side->state = *close;
+    }
+    return 0;
+}
+
+static void import_touch(ImportTask *tk, const ImportSide *side) {
+    tk->prio = (int)side->prio;
+    import_set_comm(tk, side->comm, side->comm_end);
+}
+
+// perf sched record && perf sched script > FILE (or perf script on a
+// sched:* recording). A job opens when a task wakes, or when it is
+// first seen on a CPU, gathers its CPU time across preemptions (the
+// task left the CPU still runnable, state R) and closes when the task
+// blocks or exits; jobs still open at the end of the trace close
+// there. Events other than switches and wakeups are skipped.
+Process* import_perf_sched(const char *path, long long unit_ns, int *count) {
+    long start = get_time_microseconds();
+    size_t len;
+    const char *map = import_map(path, &len);
+    if(!map) return NULL;
+    Importer im;
+    import_init(&im, path, unit_ns);
+    long long *cpu_last = (long long*)xcalloc(IMPORT_MAX_CPUS, sizeof(long long), "calloc(import)");
+    long long last = 0;
+    for(const char *line = map, *end = map + len; line < end;) {
+        const char *e = (const char*)memchr(line, '\n', (size_t)(end - line));
+        if(!e) e = end;
+        const char *s = line;
+        line = e + 1;
+        im.lines++;
+        int wakeup = 0;
+        const char *ev = import_find(s, e, "sched_switch:");
+        if(!ev) {
+            ev = import_find(s, e, "sched_wakeup");
+            if(!ev) ev = import_find(s, e, "sched_waking:");
+            wakeup = 1;
+        }
+        if(!ev) {
+            while(s < e && (*s == ' ' || *s == '\t')) s++;
+            if(s < e && *s != '#') im.skipped++;
+            continue;
+        }
+        // The header before the event ends "[CPU] SECONDS.FRACTION:".
+        const char *h = ev >= s + 6 && memcmp(ev - 6, "sched:", 6) == 0 ? ev - 6 : ev;
+        while(h > s && h[-1] == ' ') h--;
+        const char *ts_end = h > s && h[-1] == ':' ? h - 1 : h;
+        const char *ts = ts_end;
+        while(ts > s && ((ts[-1] >= '0' && ts[-1] <= '9') || ts[-1] == '.')) ts--;
+        long long t;
+        if(ts == ts_end || !import_seconds(ts, ts_end, &t)) {
+            im.skipped++;
+            continue;
+        }
+        long long cpu = -1;
+        const char *c = ts;
+        while(c > s && c[-1] == ' ') c--;
+        if(c > s && c[-1] == ']') {
+            const char *b = c - 1;
+            while(b > s && b[-1] != '[') b--;
+            if(!import_int(b, c - 1, &cpu) || cpu >= IMPORT_MAX_CPUS) cpu = -1;
+        }
+        if(im.t0 < 0) im.t0 = t;
+        last = t;
+        const char *body = (const char*)memchr(ev, ':', (size_t)(e - ev));
+        if(!body) {
+            im.skipped++;
+            continue;
+        }
+        body++;
+        if(wakeup) {
+            ImportSide w;
+            if(import_side(body, e, IMPORT_WAKEUP, &w) != 0) {
+                im.skipped++;
+                continue;
+            }
+            if(w.pid == 0) continue;
+            ImportTask *tk = import_task(&im, (int)w.pid);
+            import_touch(tk, &w);
+            if(!tk->runnable) {
+                tk->runnable = 1;
+                tk->arrival_ns = t;
+                tk->run_ns = 0;
+            }
+            continue;
+        }
+        const char *arrow = import_find(body, e, "==>");
+        ImportSide prev, next;
+        if(!arrow || import_side(body, arrow, IMPORT_PREV, &prev) != 0
+            || import_side(arrow + 3, e, IMPORT_NEXT, &next) != 0) {
+            im.skipped++;
+            continue;
+        }
+        if(prev.pid != 0) {
+            ImportTask *tk = import_task(&im, (int)prev.pid);
+            import_touch(tk, &prev);
+            // Running since the trace began if its switch-in was missed.
+            long long since = tk->on_cpu_ns >= 0 ? tk->on_cpu_ns
+                            : cpu >= 0 && cpu_last[cpu] > 0 ? cpu_last[cpu] : im.t0;
+            if(!tk->runnable) {
+                tk->runnable = 1;
+                tk->arrival_ns = since;
+                tk->run_ns = 0;
+            }
+            tk->run_ns += t - since;
+            tk->on_cpu_ns = -1;
+            if(prev.state != 'R') {
+                if(tk->run_ns > 0) import_job(&im, tk, tk->arrival_ns, tk->run_ns);
+                tk->runnable = 0;
+            }
+        }
+        if(next.pid != 0) {
+            ImportTask *tk = import_task(&im, (int)next.pid);
+            import_touch(tk, &next);
+            if(!tk->runnable) {
+                tk->runnable = 1;
+                tk->arrival_ns = t;
+                tk->run_ns = 0;
+            }
+            tk->on_cpu_ns = t;
+        }
+        if(cpu >= 0) cpu_last[cpu] = t;
+    }
+    for(int i = 0; i < im.index.count; i++) {
+        ImportTask *tk = &im.tasks[i];
+        if(!tk->runnable) continue;
+        if(tk->on_cpu_ns >= 0) tk->run_ns += last - tk->on_cpu_ns;
+        if(tk->run_ns > 0) import_job(&im, tk, tk->arrival_ns, tk->run_ns);
+    }
+    free(cpu_last);
+    munmap((void*)map, len);
+    return import_finish(&im, count, start);
+}
+
+// One sample per line: TIMESTAMP_NS PID COMM RUN_NS WAIT_NS SLICES, the
+// last three being /proc/PID/schedstat read at TIMESTAMP_NS; COMM may
+// contain spaces and '#' starts a comment. Sweeps such as
+//   while :; do t=$(date +%s%N); for d in /proc/[0-9]*; do
+//     read r w s < $d/schedstat && echo "$t ${d#/proc/} $(cat $d/comm) $r $w $s"
+//   done; sleep 1; done
+// produce it. Each interval in which a task ran becomes one job that
+// arrives at the interval's start with the CPU time used in it. A
+// task's first sample only sets its baseline, unless the task appeared
+// after the first sweep: then all of its run time is new. A run time
+// that went backwards is a reused pid, and counts from zero.
+Process* import_schedstat(const char *path, long long unit_ns, int *count) {
+    long start = get_time_microseconds();
+    size_t len;
+    const char *map = import_map(path, &len);
+    if(!map) return NULL;
+    Importer im;
+    import_init(&im, path, unit_ns);
+    long long sweep = -1, prev_sweep = -1;
+    for(const char *line = map, *end = map + len; line < end;) {
+        const char *e = (const char*)memchr(line, '\n', (size_t)(end - line));
+        if(!e) e = end;
+        const char *s = line;
+        line = e + 1;
+        im.lines++;
+        const char *hash = (const char*)memchr(s, '#', (size_t)(e - s));
+        if(hash) e = hash;
+        while(s < e && (*s == ' ' || *s == '\t')) s++;
+        if(s == e) continue;
+        long long t, pid, run, wait, slices;
+        const char *comm = import_int(s, e, &t);
+        if(comm) comm = import_int(comm, e, &pid);
+        const char *tail = comm ? import_int_back(comm, e, &slices) : NULL;
+        if(tail) tail = import_int_back(comm, tail, &wait);
+        if(tail) tail = import_int_back(comm, tail, &run);
+        if(!tail || pid <= 0 || pid > INT_MAX) {
+            im.skipped++;
+            continue;
+        }
+        if(im.t0 < 0) im.t0 = t;
+        if(t != sweep) {
+            prev_sweep = sweep;
+            sweep = t;
+        }
+        while(comm < tail && *comm == ' ') comm++;
+        while(tail > comm && tail[-1] == ' ') tail--;
+        ImportTask *tk = import_task(&im, (int)pid);
+        import_set_comm(tk, comm, tail);
+        if(!tk->runnable) {
+            tk->runnable = 1;   // seen: later samples are deltas
+            if(t == im.t0) {
+                tk->last_run_ns = run;
+                tk->last_ts = t;
+                continue;
+            }
+            tk->last_ts = prev_sweep >= 0 ? prev_sweep : t;
+        }
+        if(run < tk->last_run_ns) tk->last_run_ns = 0;
+        if(run > tk->last_run_ns) import_job(&im, tk, tk->last_ts, run - tk->last_run_ns);
+        tk->last_run_ns = run;
+        tk->last_ts = t;
+    }
+    munmap((void*)map, len);
+    return import_finish(&im, count, start);
+}
+
+// ------------------------------------------------------------
+// Prediction study
+// Each burst-aware policy runs twice: once on the true bursts (the
+// oracle) and once on exponential-average predictions learned online
+// during the run. The waiting-time penalty is the cost of not knowing.
+// ------------------------------------------------------------
+typedef Metrics (*OracleFn)(Process[], int, ExecutionEvent[], int*);
+typedef Metrics (*PredictedFn)(Process[], int, BurstPredictor*, ExecutionEvent[], int*);
+
+typedef struct {
+    const char *policy;
+    const char *label;
+    OracleFn oracle;
+    PredictedFn predicted;
+} PredictionPair;
+
+static const PredictionPair PREDICTION_PAIRS[] = {
+    {"sjf",      "SJF",      sjf,               sjf_predicted},
+    {"srtf",     "SRTF",     srtf,              srtf_predicted},
+    {"priority", "Priority", priority_by_burst, priority_predicted}
+};
+
+static void emit_prediction_record(const char *policy, double alpha, double tau0,
+                                   double oracle_wait, double predicted_wait,
+                                   double penalty_pct, const BurstPredictor *bp) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"prediction\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("alpha");                 out_double(alpha);
+        out_json_key("tau0");                  out_double(tau0);
+        out_json_key("oracle_avg_waiting_time");    out_double(oracle_wait);
+        out_json_key("predicted_avg_waiting_time"); out_double(predicted_wait);
+        out_json_key("waiting_penalty_pct");   out_double(penalty_pct);
+        out_json_key("mae");                   out_double(predictor_mae(bp));
+        out_json_key("mape_pct");              out_double(predictor_mape(bp));
+        out_json_key("classes");               out_int(bp->index.count);
+        out_json_key("seed");                  out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_PREDICT)) {
+        out_str("record,policy,alpha,tau0,oracle_avg_waiting_time,predicted_avg_waiting_time,"
+                "waiting_penalty_pct,mae,mape_pct,classes,seed\n");
+    }
+    out_str("prediction,");
+    out_csv_str(policy);
+    out_char(',');  out_double(alpha);
+    out_char(',');  out_double(tau0);
+    out_char(',');  out_double(oracle_wait);
+    out_char(',');  out_double(predicted_wait);
+    out_char(',');  out_double(penalty_pct);
+    out_char(',');  out_double(predictor_mae(bp));
+    out_char(',');  out_double(predictor_mape(bp));
+    out_char(',');  out_int(bp->index.count);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_prediction_study(Process original[], int n, double alpha, double tau0) {
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(prediction)");
+    int saved_gantt = g_show_gantt;
+    g_show_gantt = 0;
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Burst Prediction (alpha = %.2f, tau0 = %.1f, seed = %llu) ==\n",
+               alpha, tau0, (unsigned long long)g_seed);
+        printf("%-10s %-14s %-14s %-12s %-10s %-10s %-8s\n",
+               "Policy", "Oracle Wait", "Pred. Wait", "Penalty(%)", "MAE", "MAPE(%)", "Classes");
+        printf("--------------------------------------------------------------------------------\n");
+    }
+
+    int npairs = (int)(sizeof(PREDICTION_PAIRS) / sizeof(PREDICTION_PAIRS[0]));
+    for(int k = 0; k < npairs; k++) {
+        const PredictionPair *pp = &PREDICTION_PAIRS[k];
+        int event_count = 0;
+
+        reset_processes(original, work, n);
+        rng_stream(&g_rng, g_seed, RNG_STREAM_PREDICTION + 2 * k);
+        Metrics oracle = pp->oracle(work, n, NULL, &event_count);
+
+        BurstPredictor bp;
+        predictor_init(&bp, alpha, tau0);
+        reset_processes(original, work, n);
+        rng_stream(&g_rng, g_seed, RNG_STREAM_PREDICTION + 2 * k + 1);
+        Metrics predicted = pp->predicted(work, n, &bp, NULL, &event_count);
+
+        double penalty = oracle.avg_waiting_time > 0.0
+            ? 100.0 * (predicted.avg_waiting_time - oracle.avg_waiting_time) / oracle.avg_waiting_time
+            : 0.0;
+        if(g_format == FORMAT_TEXT) {
+            printf("%-10s %-14.2f %-14.2f %-12.2f %-10.2f %-10.2f %-8d\n",
+                   pp->label, oracle.avg_waiting_time, predicted.avg_waiting_time,
+                   penalty, predictor_mae(&bp), predictor_mape(&bp), bp.index.count);
+        } else {
+            emit_prediction_record(pp->policy, alpha, tau0, oracle.avg_waiting_time,
+                                   predicted.avg_waiting_time, penalty, &bp);
+        }
+        predictor_free(&bp);
+    }
+    out_flush();
+
+    g_show_gantt = saved_gantt;
+    free(work);
+}
+
+// ------------------------------------------------------------
+// Multi-CPU study (--cpus=N)
+// Every policy runs twice on the same CPUs, once with balanced and
+// once with affinity placement, so the refill cost of migrations shows.
+// ------------------------------------------------------------
+static void emit_smp_record(const char *policy, const char *placement, const SmpOpts *o,
+                            Metrics m, const SmpStats *st) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"smp\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("placement");           out_json_str(placement);
+        out_json_key("cpus");                out_int(o->ncpu);
+        out_json_key("quantum");             out_int(o->quantum);
+        out_json_key("avg_waiting_time");    out_double(m.avg_waiting_time);
+        out_json_key("avg_turnaround_time"); out_double(m.avg_turnaround_time);
+        out_json_key("makespan");            out_int(st->makespan);
+        out_json_key("dispatches");          out_int(st->dispatches);
+        out_json_key("migrations");          out_int(st->migrations);
+        out_json_key("cache_refill_us");     out_double(st->refill_us);
+        out_json_key("seed");                out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_SMP)) {
+        out_str("record,policy,placement,cpus,quantum,avg_waiting_time,avg_turnaround_time,"
+                "makespan,dispatches,migrations,cache_refill_us,seed\n");
+    }
+    out_str("smp,");
+    out_csv_str(policy);
+    out_char(',');  out_str(placement);
+    out_char(',');  out_int(o->ncpu);
+    out_char(',');  out_int(o->quantum);
+    out_char(',');  out_double(m.avg_waiting_time);
+    out_char(',');  out_double(m.avg_turnaround_time);
+    out_char(',');  out_int(st->makespan);
+    out_char(',');  out_int(st->dispatches);
+    out_char(',');  out_int(st->migrations);
+    out_char(',');  out_double(st->refill_us);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_smp_study(Process original[], int n, const SmpOpts *base) {
+    static const char *PLACEMENT[] = {"balanced", "affinity"};
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(smp)");
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Multi-CPU Placement (%d CPUs, refill %.2f us/KB, half-life %.1f) ==\n",
+               base->ncpu, base->refill_us_per_kb, base->half_life);
+        printf("%-12s %-9s %-10s %-10s %-10s %-11s %-12s\n",
+               "Policy", "Placement", "Avg Wait", "Avg TAT", "Makespan", "Migrations", "Refill(ms)");
+        printf("--------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        for(int a = 0; a < 2; a++) {
+            SmpOpts o = *base;
+            o.affinity = a;
+            SmpStats st = {0};
+            reset_processes(original, work, n);
+            rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_SMP + 2 * k + a));
+            Metrics m = smp_schedule(work, n, (PolicyId)k, &o, &st);
+            if(g_format == FORMAT_TEXT) {
+                printf("%-12s %-9s %-10.2f %-10.2f %-10d %-11lld %-12.2f\n",
+                       POLICY_NAMES[k], PLACEMENT[a], m.avg_waiting_time, m.avg_turnaround_time,
+                       st.makespan, st.migrations, st.refill_us / 1000.0);
+            } else {
+                if(k != POLICY_RR && k != POLICY_PRIORITY_RR) o.quantum = 0;
+                emit_smp_record(POLICY_NAMES[k], PLACEMENT[a], &o, m, &st);
+            }
+        }
+    }
+    out_flush();
+    free(work);
+}
+
+// ------------------------------------------------------------
+// Heterogeneous CPU study (--cpu-speeds=S1,S2,...)
+// Every policy runs with each placement on CPUs of the given speeds,
+// with balanced requeueing. Utilization is reported per speed class as
+// the share of makespan its CPUs were occupied, and the makespan gain
+// is relative to speed-oblivious placement.
+// ------------------------------------------------------------
+#define HETERO_MAX_CPUS 256
+
+int parse_cpu_speeds(const char *spec, double *out, int max) {
+    int count = 0;
+    while(*spec) {
+        char *end;
+        if(count == max) return -1;
+        out[count] = strtod(spec, &end);
+        if(end == spec || out[count] <= 0.0 || (*end && *end != ',')) return -1;
+        count++;
+        spec = *end ? end + 1 : end;
+    }
+    return count;
+}
+
+static void emit_hetero_record(const char *policy, const char *placement, int quantum,
+                               double speed, int cpus, double util_pct, Metrics m,
+                               const SmpStats *st, double gain_pct) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"hetero\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("placement");           out_json_str(placement);
+        out_json_key("quantum");             out_int(quantum);
+        out_json_key("speed");               out_double(speed);
+        out_json_key("cpus");                out_int(cpus);
+        out_json_key("utilization_pct");     out_double(util_pct);
+        out_json_key("avg_waiting_time");    out_double(m.avg_waiting_time);
+        out_json_key("avg_turnaround_time"); out_double(m.avg_turnaround_time);
+        out_json_key("makespan");            out_int(st->makespan);
+        out_json_key("makespan_gain_pct");   out_double(gain_pct);
+        out_json_key("seed");                out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_HETERO)) {
+        out_str("record,policy,placement,quantum,speed,cpus,utilization_pct,avg_waiting_time,"
+                "avg_turnaround_time,makespan,makespan_gain_pct,seed\n");
+    }
+    out_str("hetero,");
+    out_csv_str(policy);
+    out_char(',');  out_str(placement);
+    out_char(',');  out_int(quantum);
+    out_char(',');  out_double(speed);
+    out_char(',');  out_int(cpus);
+    out_char(',');  out_double(util_pct);
+    out_char(',');  out_double(m.avg_waiting_time);
+    out_char(',');  out_double(m.avg_turnaround_time);
+    out_char(',');  out_int(st->makespan);
+    out_char(',');  out_double(gain_pct);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_hetero_study(Process original[], int n, const SmpOpts *base) {
+    int ncpu = base->ncpu, nclass = 0;
+    double class_speed[HETERO_MAX_CPUS];
+    int class_cpus[HETERO_MAX_CPUS];
+    long long busy[HETERO_MAX_CPUS];
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(hetero)");
+
+    // Speed classes, slowest first.
+    for(int c = 0; c < ncpu; c++) {
+        int k = 0;
+        while(k < nclass && class_speed[k] < base->speed[c]) k++;
+        if(k < nclass && class_speed[k] == base->speed[c]) {
+            class_cpus[k]++;
+            continue;
+        }
+        memmove(&class_speed[k + 1], &class_speed[k], (size_t)(nclass - k) * sizeof(double));
+        memmove(&class_cpus[k + 1], &class_cpus[k], (size_t)(nclass - k) * sizeof(int));
+        class_speed[k] = base->speed[c];
+        class_cpus[k] = 1;
+        nclass++;
+    }
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Heterogeneous CPUs (%d CPUs, %d speed classes) ==\n", ncpu, nclass);
+        printf("%-12s %-15s %-10s %-10s %-10s %-8s %s\n",
+               "Policy", "Placement", "Avg Wait", "Avg TAT", "Makespan", "Gain", "Utilization by speed");
+        printf("--------------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        int oblivious_makespan = 0;
+        for(int p = 0; p < SMP_PLACEMENTS; p++) {
+            SmpOpts o = *base;
+            o.affinity = 0;
+            o.placement = (SmpPlacement)p;
+            SmpStats st = {0};
+            st.busy = busy;
+            reset_processes(original, work, n);
+            rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_HETERO + SMP_PLACEMENTS * k + p));
+            Metrics m = smp_schedule(work, n, (PolicyId)k, &o, &st);
+            if(p == SMP_OBLIVIOUS) oblivious_makespan = st.makespan;
+            double gain = st.makespan > 0 && oblivious_makespan > 0
+                ? 100.0 * (oblivious_makespan - st.makespan) / oblivious_makespan : 0.0;
+            if(k != POLICY_RR && k != POLICY_PRIORITY_RR) o.quantum = 0;
+
+            if(g_format == FORMAT_TEXT) {
+                printf("%-12s %-15s %-10.2f %-10.2f %-10d %+7.2f%% ",
+                       POLICY_NAMES[k], SMP_PLACEMENT_NAMES[p], m.avg_waiting_time,
+                       m.avg_turnaround_time, st.makespan, gain);
+            }
+            for(int s = 0; s < nclass; s++) {
+                long long occupied = 0;
+                for(int c = 0; c < ncpu; c++) {
+                    if(base->speed[c] == class_speed[s]) occupied += busy[c];
+                }
+                double util = st.makespan > 0
+                    ? 100.0 * (double)occupied / ((double)class_cpus[s] * st.makespan) : 0.0;
+                if(g_format == FORMAT_TEXT) {
+                    printf(" %gx:%.1f%%", class_speed[s], util);
+                } else {
+                    emit_hetero_record(POLICY_NAMES[k], SMP_PLACEMENT_NAMES[p], o.quantum,
+                                       class_speed[s], class_cpus[s], util, m, &st, gain);
+                }
+            }
+            if(g_format == FORMAT_TEXT) printf("\n");
+        }
+    }
+    out_flush();
+    free(work);
+}
+
+// ------------------------------------------------------------
+// I/O study (--io)
+// Runs every policy on the workload with CPU/IO burst sequences and
+// reports how well it keeps the CPU busy while tasks are blocked.
+// ------------------------------------------------------------
+static void emit_io_record(const char *policy, int quantum, Metrics m, const IoStats *st,
+                           double util_pct, double iowait_pct) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"io\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("quantum");             out_int(quantum);
+        out_json_key("avg_waiting_time");    out_double(m.avg_waiting_time);
+        out_json_key("avg_turnaround_time"); out_double(m.avg_turnaround_time);
+        out_json_key("makespan");            out_int(st->makespan);
+        out_json_key("cpu_busy");            out_int(st->busy);
+        out_json_key("cpu_utilization_pct"); out_double(util_pct);
+        out_json_key("io_wait");             out_int(st->io_wait);
+        out_json_key("io_wait_pct");         out_double(iowait_pct);
+        out_json_key("blocked_time");        out_int(st->blocked);
+        out_json_key("seed");                out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_IO)) {
+        out_str("record,policy,quantum,avg_waiting_time,avg_turnaround_time,makespan,cpu_busy,"
+                "cpu_utilization_pct,io_wait,io_wait_pct,blocked_time,seed\n");
+    }
+    out_str("io,");
+    out_csv_str(policy);
+    out_char(',');  out_int(quantum);
+    out_char(',');  out_double(m.avg_waiting_time);
+    out_char(',');  out_double(m.avg_turnaround_time);
+    out_char(',');  out_int(st->makespan);
+    out_char(',');  out_int(st->busy);
+    out_char(',');  out_double(util_pct);
+    out_char(',');  out_int(st->io_wait);
+    out_char(',');  out_double(iowait_pct);
+    out_char(',');  out_int(st->blocked);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_io_study(Process original[], int n, int quantum) {
+    Process *with_io = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(io)");
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(io)");
+    BurstPool pool = {0};
+    reset_processes(original, with_io, n);
+    generate_io_bursts(with_io, n, g_seed, &pool);
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== CPU/IO Bursts (Quantum = %d ms for RR policies) ==\n", quantum);
+        printf("%-12s %-10s %-10s %-10s %-12s %-10s\n",
+               "Policy", "Avg Wait", "Avg TAT", "Makespan", "CPU Util(%)", "IO Wait(%)");
+        printf("--------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        IoStats st;
+        reset_processes(with_io, work, n);
+        rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_IO + k));
+        Metrics m = io_schedule(work, n, &pool, (PolicyId)k, quantum, &st);
+        double util = st.makespan ? 100.0 * (double)st.busy / st.makespan : 0.0;
+        double iowait = st.makespan ? 100.0 * (double)st.io_wait / st.makespan : 0.0;
+        int q = (k == POLICY_RR || k == POLICY_PRIORITY_RR) ? quantum : 0;
+        if(g_format == FORMAT_TEXT) {
+            printf("%-12s %-10.2f %-10.2f %-10d %-12.2f %-10.2f\n",
+                   POLICY_NAMES[k], m.avg_waiting_time, m.avg_turnaround_time,
+                   st.makespan, util, iowait);
+        } else {
+            emit_io_record(POLICY_NAMES[k], q, m, &st, util, iowait);
+        }
+    }
+    out_flush();
+
+    burst_pool_free(&pool);
+    free(work);
+    free(with_io);
+}
+
+// ------------------------------------------------------------
+// Parallel cluster study (--parallel=THREADS)
+// Every policy runs on the partitioned cluster twice, sequentially and
+// on worker threads, and the two schedules are compared task by task.
+// ------------------------------------------------------------
+static void emit_cluster_record(const char *policy, const ClusterOpts *o, Metrics m,
+                                const ClusterStats *st, double seq_ms, double par_ms, int match) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"cluster\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("cpus");                out_int(o->ncpu);
+        out_json_key("threads");             out_int(o->threads);
+        out_json_key("quantum");             out_int(o->quantum);
+        out_json_key("lookahead");           out_int(o->latency);
+        out_json_key("forward_threshold");   out_int(o->threshold);
+        out_json_key("avg_waiting_time");    out_double(m.avg_waiting_time);
+        out_json_key("avg_turnaround_time"); out_double(m.avg_turnaround_time);
+        out_json_key("makespan");            out_int(st->makespan);
+        out_json_key("forwarded");           out_int(st->forwarded);
+        out_json_key("rounds");              out_int(st->rounds);
+        out_json_key("sequential_ms");       out_double(seq_ms);
+        out_json_key("parallel_ms");         out_double(par_ms);
+        out_json_key("match");               out_str(match ? "true" : "false");
+        out_json_key("seed");                out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_CLUSTER)) {
+        out_str("record,policy,cpus,threads,quantum,lookahead,forward_threshold,avg_waiting_time,"
+                "avg_turnaround_time,makespan,forwarded,rounds,sequential_ms,parallel_ms,match,seed\n");
+    }
+    out_str("cluster,");
+    out_csv_str(policy);
+    out_char(',');  out_int(o->ncpu);
+    out_char(',');  out_int(o->threads);
+    out_char(',');  out_int(o->quantum);
+    out_char(',');  out_int(o->latency);
+    out_char(',');  out_int(o->threshold);
+    out_char(',');  out_double(m.avg_waiting_time);
+    out_char(',');  out_double(m.avg_turnaround_time);
+    out_char(',');  out_int(st->makespan);
+    out_char(',');  out_int(st->forwarded);
+    out_char(',');  out_int(st->rounds);
+    out_char(',');  out_double(seq_ms);
+    out_char(',');  out_double(par_ms);
+    out_char(',');  out_int(match);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_cluster_study(Process original[], int n, const ClusterOpts *base) {
+    Process *seq = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(cluster)");
+    Process *par = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(cluster)");
+    ClusterOpts one = *base;
+    one.threads = 0;
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Parallel Cluster (%d CPUs, %d threads, lookahead %d, forward at %d waiting) ==\n",
+               base->ncpu, base->threads, base->latency, base->threshold);
+        printf("%-12s %-10s %-10s %-10s %-10s %-8s %-9s %-9s %-8s %-5s\n",
+               "Policy", "Avg Wait", "Avg TAT", "Makespan", "Forwarded", "Rounds",
+               "Seq(ms)", "Par(ms)", "Speedup", "Match");
+        printf("----------------------------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        ClusterStats s1, s2;
+        reset_processes(original, seq, n);
+        reset_processes(original, par, n);
+
+        long t0 = get_time_microseconds();
+        Metrics m = cluster_schedule(seq, n, (PolicyId)k, &one, &s1);
+        long t1 = get_time_microseconds();
+        Metrics mp = cluster_schedule(par, n, (PolicyId)k, base, &s2);
+        long t2 = get_time_microseconds();
+
+        int match = s1.makespan == s2.makespan && s1.forwarded == s2.forwarded
+                    && s1.dispatches == s2.dispatches
+                    && m.avg_waiting_time == mp.avg_waiting_time
+                    && m.context_switches == mp.context_switches;
+        for(int i = 0; match && i < n; i++) {
+            match = seq[i].completion_time == par[i].completion_time
+                    && seq[i].real_time_us == par[i].real_time_us;
+        }
+        double seq_ms = (t1 - t0) / 1000.0, par_ms = (t2 - t1) / 1000.0;
+        s1.rounds = s2.rounds;
+
+        ClusterOpts o = *base;
+        if(k != POLICY_RR && k != POLICY_PRIORITY_RR) o.quantum = 0;
+        if(o.threads > o.ncpu) o.threads = o.ncpu;
+        if(g_format == FORMAT_TEXT) {
+            printf("%-12s %-10.2f %-10.2f %-10d %-10lld %-8lld %-9.2f %-9.2f %-8.2f %-5s\n",
+                   POLICY_NAMES[k], m.avg_waiting_time, m.avg_turnaround_time, s1.makespan,
+                   s1.forwarded, s1.rounds, seq_ms, par_ms,
+                   par_ms > 0.0 ? seq_ms / par_ms : 0.0, match ? "yes" : "NO");
+        } else {
+            emit_cluster_record(POLICY_NAMES[k], &o, m, &s1, seq_ms, par_ms, match);
+        }
+    }
+    out_flush();
+    free(par);
+    free(seq);
+}
+
+// ------------------------------------------------------------
+// Aging study (--aging=INTERVAL)
+// Priority and priority RR run with aging off and on; waits are then
+// broken down by priority class, where starvation shows as a class's
+// maximum wait.
+// ------------------------------------------------------------
+typedef struct {
+    int priority;
+    int tasks;
+    long long wait_sum;
+    int wait_max;
+} ClassWait;
+
+// Per-class waits of a finished run; classes are sorted by priority.
+// classes must hold n entries; returns how many were filled.
+static int class_waits(const Process processes[], int n, ClassWait *classes) {
+    int *prio = (int*)xcalloc((size_t)n, sizeof(int), "calloc(classes)");
+    for(int i = 0; i < n; i++) prio[i] = processes[i].priority;
+    qsort(prio, (size_t)n, sizeof(int), cmp_int);
+    int k = 0;
+    for(int i = 0; i < n; i++) {
+        if(k > 0 && classes[k - 1].priority == prio[i]) continue;
+        memset(&classes[k], 0, sizeof(classes[k]));
+        classes[k++].priority = prio[i];
+    }
+    for(int i = 0; i < n; i++) {
+        int lo = 0, hi = k - 1;
+        while(classes[lo + (hi - lo) / 2].priority != processes[i].priority) {
+            int mid = lo + (hi - lo) / 2;
+            if(classes[mid].priority < processes[i].priority) lo = mid + 1;
+            else hi = mid - 1;
+        }
+        ClassWait *c = &classes[lo + (hi - lo) / 2];
+        c->tasks++;
+        c->wait_sum += processes[i].waiting_time;
+        if(processes[i].waiting_time > c->wait_max) c->wait_max = processes[i].waiting_time;
+    }
+    free(prio);
+    return k;
+}
+
+static void emit_aging_record(const char *policy, int quantum, const ClassWait *off,
+                              const ClassWait *aged) {
+    double avg_off = (double)off->wait_sum / off->tasks;
+    double avg_aged = (double)aged->wait_sum / aged->tasks;
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"aging\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("quantum");         out_int(quantum);
+        out_json_key("aging_interval");  out_int(g_aging);
+        out_json_key("priority");        out_int(off->priority);
+        out_json_key("tasks");           out_int(off->tasks);
+        out_json_key("avg_wait_off");    out_double(avg_off);
+        out_json_key("max_wait_off");    out_int(off->wait_max);
+        out_json_key("avg_wait_aged");   out_double(avg_aged);
+        out_json_key("max_wait_aged");   out_int(aged->wait_max);
+        out_json_key("seed");            out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_AGING)) {
+        out_str("record,policy,quantum,aging_interval,priority,tasks,avg_wait_off,max_wait_off,"
+                "avg_wait_aged,max_wait_aged,seed\n");
+    }
+    out_str("aging,");
+    out_csv_str(policy);
+    out_char(',');  out_int(quantum);
+    out_char(',');  out_int(g_aging);
+    out_char(',');  out_int(off->priority);
+    out_char(',');  out_int(off->tasks);
+    out_char(',');  out_double(avg_off);
+    out_char(',');  out_int(off->wait_max);
+    out_char(',');  out_double(avg_aged);
+    out_char(',');  out_int(aged->wait_max);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_aging_study(Process original[], int n, int quantum) {
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(aging)");
+    ClassWait *off = (ClassWait*)xcalloc((size_t)n, sizeof(ClassWait), "calloc(aging)");
+    ClassWait *aged = (ClassWait*)xcalloc((size_t)n, sizeof(ClassWait), "calloc(aging)");
+    int interval = g_aging;
+    int saved_gantt = g_show_gantt;
+    g_show_gantt = 0;
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Priority Aging (one level per %d time units) ==\n", interval);
+        printf("%-12s %-9s %-8s %-14s %-14s %-14s %-14s\n",
+               "Policy", "Priority", "Tasks", "Avg Wait off", "Max Wait off", "Avg Wait aged", "Max Wait aged");
+        printf("--------------------------------------------------------------------------------------\n");
+    }
+
+    static const PolicyId POLICIES[] = { POLICY_PRIORITY, POLICY_PRIORITY_RR };
+    for(int k = 0; k < 2; k++) {
+        int sliced = POLICIES[k] == POLICY_PRIORITY_RR;
+        int nclass = 0;
+        for(int a = 0; a < 2; a++) {
+            int event_count = 0;
+            g_aging = a ? interval : 0;
+            reset_processes(original, work, n);
+            rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_AGING + 2 * k + a));
+            if(sliced) priority_round_robin(work, n, quantum, NULL, &event_count);
+            else priority_scheduling(work, n, NULL, &event_count);
+            nclass = class_waits(work, n, a ? aged : off);
+        }
+        for(int c = 0; c < nclass; c++) {
+            const char *policy = POLICY_NAMES[POLICIES[k]];
+            if(g_format == FORMAT_TEXT) {
+                printf("%-12s %-9d %-8d %-14.2f %-14d %-14.2f %-14d\n",
+                       policy, off[c].priority, off[c].tasks,
+                       (double)off[c].wait_sum / off[c].tasks, off[c].wait_max,
+                       (double)aged[c].wait_sum / aged[c].tasks, aged[c].wait_max);
+            } else {
+                emit_aging_record(policy, sliced ? quantum : 0, &off[c], &aged[c]);
+            }
+        }
+    }
+    out_flush();
+    g_aging = interval;
+    g_show_gantt = saved_gantt;
+    free(aged);
+    free(off);
+    free(work);
+}
+
+// ------------------------------------------------------------
+// Tenant study (--tenants[=NAME:WEIGHT,...])
+// Every policy runs flat and inside tenant fair queueing. Per tenant it
+// reports the share of the CPU received while backlogged against the
+// share its weight guarantees, and the waiting-time tail in both runs:
+// a tail that shrinks under fair queueing was interference from other
+// tenants.
+// ------------------------------------------------------------
+// Parses NAME:WEIGHT[,NAME:WEIGHT...]; returns the count or -1.
+int parse_tenant_weights(const char *spec, TenantWeight *out, int max) {
+    int count = 0;
+    while(*spec) {
+        const char *colon = strchr(spec, ':');
+        const char *comma = strchr(spec, ',');
+        if(!comma) comma = spec + strlen(spec);
+        if(!colon || colon > comma || count == max) return -1;
+        size_t len = (size_t)(colon - spec);
+        if(len == 0 || len >= sizeof(out[count].name)) return -1;
+        memcpy(out[count].name, spec, len);
+        out[count].name[len] = '\0';
+        out[count].weight = atof(colon + 1);
+        if(out[count].weight <= 0.0) return -1;
+        count++;
+        spec = *comma ? comma + 1 : comma;
+    }
+    return count;
+}
+
+static Metrics run_flat_policy(PolicyId policy, Process processes[], int n, int quantum) {
+    int event_count = 0;
+    switch(policy) {
+        case POLICY_FCFS:        return fcfs(processes, n, NULL, &event_count);
+        case POLICY_SJF:         return sjf(processes, n, NULL, &event_count);
+        case POLICY_PRIORITY:    return priority_scheduling(processes, n, NULL, &event_count);
+        case POLICY_RR:          return round_robin(processes, n, quantum, NULL, &event_count);
+        case POLICY_PRIORITY_RR: return priority_round_robin(processes, n, quantum, NULL, &event_count);
+        default: break;
+    }
+    Metrics none = {0};
+    return none;
+}
+
+static void emit_tenant_record(const char *policy, int quantum, const WfqTenant *t,
+                               double guaranteed_pct, double received_pct,
+                               const Histogram *flat, const Histogram *fair) {
+    long long p99_flat = hist_percentile(flat, 0.99), p99_fair = hist_percentile(fair, 0.99);
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"tenant\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("quantum");         out_int(quantum);
+        out_json_key("tenant");          out_json_str(t->name);
+        out_json_key("weight");          out_double(t->weight);
+        out_json_key("tasks");           out_int((long long)fair->total);
+        out_json_key("guaranteed_pct");  out_double(guaranteed_pct);
+        out_json_key("received_pct");    out_double(received_pct);
+        out_json_key("p99_wait_flat");   out_int(p99_flat);
+        out_json_key("p99_wait_wfq");    out_int(p99_fair);
+        out_json_key("max_wait_flat");   out_int(flat->max);
+        out_json_key("max_wait_wfq");    out_int(fair->max);
+        out_json_key("seed");            out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_TENANT)) {
+        out_str("record,policy,quantum,tenant,weight,tasks,guaranteed_pct,received_pct,"
+                "p99_wait_flat,p99_wait_wfq,max_wait_flat,max_wait_wfq,seed\n");
+    }
+    out_str("tenant,");
+    out_csv_str(policy);
+    out_char(',');  out_int(quantum);
+    out_char(',');  out_csv_str(t->name);
+    out_char(',');  out_double(t->weight);
+    out_char(',');  out_int((long long)fair->total);
+    out_char(',');  out_double(guaranteed_pct);
+    out_char(',');  out_double(received_pct);
+    out_char(',');  out_int(p99_flat);
+    out_char(',');  out_int(p99_fair);
+    out_char(',');  out_int(flat->max);
+    out_char(',');  out_int(fair->max);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_tenant_study(Process original[], int n, const WfqOpts *o) {
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(tenants)");
+    Process *flat = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(tenants)");
+    int saved_gantt = g_show_gantt;
+    g_show_gantt = 0;
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Tenant Fair Queueing (Quantum = %d ms for RR policies) ==\n", o->quantum);
+        printf("%-12s %-10s %-7s %-12s %-10s %-10s %-10s %-10s %-10s\n",
+               "Policy", "Tenant", "Weight", "Guaranteed%", "Received%",
+               "p99W flat", "p99W WFQ", "MaxW flat", "MaxW WFQ");
+        printf("----------------------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        WfqState s;
+        reset_processes(original, work, n);
+        rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_TENANT + 2 * k));
+        wfq_schedule(work, n, (PolicyId)k, o, &s);
+        reset_processes(original, flat, n);
+        rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_TENANT + 2 * k + 1));
+        run_flat_policy((PolicyId)k, flat, n, o->quantum);
+
+        Histogram *h = (Histogram*)xcalloc((size_t)s.index.count * 2, sizeof(Histogram), "calloc(tenants)");
+        for(int t = 0; t < 2 * s.index.count; t++) hist_init(&h[t]);
+        for(int i = 0; i < n; i++) {
+            hist_record(&h[2 * s.tenant_of[i]], flat[i].waiting_time);
+            hist_record(&h[2 * s.tenant_of[i] + 1], work[i].waiting_time);
+        }
+        double total_weight = 0.0;
+        for(int t = 0; t < s.index.count; t++) total_weight += s.tenants[t].weight;
+
+        int q = (k == POLICY_RR || k == POLICY_PRIORITY_RR) ? o->quantum : 0;
+        for(int t = 0; t < s.index.count; t++) {
+            const WfqTenant *tn = &s.tenants[t];
+            double guaranteed = 100.0 * tn->weight / total_weight;
+            double received = tn->backlogged ? 100.0 * (double)tn->service / tn->backlogged : 0.0;
+            if(g_format == FORMAT_TEXT) {
+                printf("%-12s %-10s %-7.2f %-12.2f %-10.2f %-10lld %-10lld %-10lld %-10lld\n",
+                       POLICY_NAMES[k], tn->name, tn->weight, guaranteed, received,
+                       hist_percentile(&h[2 * t], 0.99), hist_percentile(&h[2 * t + 1], 0.99),
+                       h[2 * t].max, h[2 * t + 1].max);
+            } else {
+                emit_tenant_record(POLICY_NAMES[k], q, tn, guaranteed, received, &h[2 * t], &h[2 * t + 1]);
+            }
+        }
+        free(h);
+        wfq_free(&s);
+    }
+    out_flush();
+    g_show_gantt = saved_gantt;
+    free(flat);
+    free(work);
+}
+
+#ifndef SCHEDULER_NO_MAIN
+// ------------------------------------------------------------
+// Periodic study (--periodic=N or --periodic-file=PATH)
+// Runs the schedulability tests, then simulates RM and EDF over one
+// hyperperiod after the last offset (or up to --horizon when that is
+// shorter). With synchronous release the simulated worst response of
+// each RM task reaches its RTA bound exactly.
+// ------------------------------------------------------------
+static const char *PERIODIC_POLICY_NAMES[PERIODIC_POLICIES] = {"rm", "edf"};
+
+static void emit_schedtest_record(int n, const PeriodicAnalysis *a, long long rta_us, long long edf_us) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"schedtest\",\"tasks\":");
+        out_int(n);
+        out_json_key("utilization");   out_double(a->utilization);
+        out_json_key("hyperperiod");   out_int(a->hyperperiod);
+        out_json_key("rm_hyperbolic"); out_int(a->hyperbolic_ok);
+        out_json_key("rm_rta");        out_int(a->rta_ok);
+        out_json_key("rm_rta_us");     out_int(rta_us);
+        out_json_key("edf");           out_int(a->edf_ok);
+        out_json_key("edf_us");        out_int(edf_us);
+        out_json_key("seed");          out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_SCHEDTEST)) {
+        out_str("record,tasks,utilization,hyperperiod,rm_hyperbolic,rm_rta,rm_rta_us,edf,edf_us,seed\n");
+    }
+    out_str("schedtest,");
+    out_int(n);
+    out_char(',');  out_double(a->utilization);
+    out_char(',');  out_int(a->hyperperiod);
+    out_char(',');  out_int(a->hyperbolic_ok);
+    out_char(',');  out_int(a->rta_ok);
+    out_char(',');  out_int(rta_us);
+    out_char(',');  out_int(a->edf_ok);
+    out_char(',');  out_int(edf_us);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+static void emit_periodic_record(const char *policy, long long horizon, const PeriodicStats *st,
+                                 long long sim_us) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"periodic\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("horizon");      out_int(horizon);
+        out_json_key("released");     out_int(st->released);
+        out_json_key("completed");    out_int(st->completed);
+        out_json_key("missed");       out_int(st->missed);
+        out_json_key("max_lateness"); out_int(st->max_lateness);
+        out_json_key("preemptions");  out_int(st->preemptions);
+        out_json_key("sim_us");       out_int(sim_us);
+        out_json_key("seed");         out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_PERIODIC)) {
+        out_str("record,policy,horizon,released,completed,missed,max_lateness,preemptions,sim_us,seed\n");
+    }
+    out_str("periodic,");
+    out_csv_str(policy);
+    out_char(',');  out_int(horizon);
+    out_char(',');  out_int(st->released);
+    out_char(',');  out_int(st->completed);
+    out_char(',');  out_int(st->missed);
+    out_char(',');  out_int(st->max_lateness);
+    out_char(',');  out_int(st->preemptions);
+    out_char(',');  out_int(sim_us);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_periodic_study(const PeriodicTask *t, int n, long long horizon_cap) {
+    long long *bound = (long long*)xcalloc((size_t)n, sizeof(long long), "calloc(periodic)");
+    long long *worst = (long long*)xcalloc((size_t)n, sizeof(long long), "calloc(periodic)");
+    PeriodicAnalysis a;
+    a.response = bound;
+
+    long long started = get_time_microseconds();
+    periodic_analyse(t, n, horizon_cap, &a);
+    long long analysed = get_time_microseconds() - started;
+    // Time the EDF test on its own as well; it is the cheap one.
+    started = get_time_microseconds();
+    periodic_edf_test(t, n, a.utilization, horizon_cap);
+    long long edf_us = get_time_microseconds() - started;
+    long long rta_us = analysed > edf_us ? analysed - edf_us : 0;
+
+    long long max_offset = 0;
+    for(int i = 0; i < n; i++) {
+        if(t[i].offset > max_offset) max_offset = t[i].offset;
+    }
+    long long horizon = horizon_cap;
+    if(a.hyperperiod > 0 && max_offset + a.hyperperiod < horizon) horizon = max_offset + a.hyperperiod;
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Periodic Tasks (%d tasks, U = %.4f) ==\n", n, a.utilization);
+        if(a.hyperperiod > 0) {
+            printf("Hyperperiod: %lld, simulated releases before %lld\n", a.hyperperiod, horizon);
+        } else {
+            printf("Hyperperiod: beyond %lld, simulated releases before %lld\n", horizon_cap, horizon);
+        }
+        printf("RM hyperbolic bound:   %s\n", a.hyperbolic_ok ? "schedulable" : "inconclusive");
+        if(a.rta_ok) {
+            printf("RM response time:      schedulable (%lld us)\n", rta_us);
+        } else {
+            printf("RM response time:      %s misses its deadline (%lld us)\n",
+                   t[a.rta_failed].name, rta_us);
         }
-        
-        int exec_time = (processes[idx].remaining_time > quantum) ? quantum : processes[idx].remaining_time;
-        
-        #ifndef _WIN32
-        usleep(exec_time * 100);
-        #else
-        Sleep(exec_time / 10);
-        #endif
-        
-        processes[idx].remaining_time -= exec_time;
-        current_time += exec_time;
-        
-        gantt[gantt_idx] = processes[idx].pid;
-        gantt_time[gantt_idx++] = current_time;
-        
+        printf("EDF demand test:       %s (%lld us)\n",
+               a.edf_ok ? "schedulable" : "unschedulable", edf_us);
+        printf("%-8s %-12s %-12s %-10s %-14s %-12s %-10s\n",
+               "Policy", "Released", "Completed", "Missed", "Max lateness", "Preemptions", "Sim(ms)");
+        printf("--------------------------------------------------------------------------------\n");
+    } else {
+        emit_schedtest_record(n, &a, rta_us, edf_us);
+    }
+
+    for(int p = 0; p < PERIODIC_POLICIES; p++) {
+        PeriodicStats st;
+        st.max_response = p == PERIODIC_RM ? worst : NULL;
+        started = get_time_microseconds();
+        periodic_simulate(t, n, (PeriodicPolicy)p, horizon, &st);
+        long long sim_us = get_time_microseconds() - started;
+        if(g_format == FORMAT_TEXT) {
+            printf("%-8s %-12lld %-12lld %-10lld %-14lld %-12lld %-10.2f\n",
+                   PERIODIC_POLICY_NAMES[p], st.released, st.completed, st.missed,
+                   st.max_lateness, st.preemptions, sim_us / 1000.0);
+        } else {
+            emit_periodic_record(PERIODIC_POLICY_NAMES[p], horizon, &st, sim_us);
+        }
+    }
+
+    // Tasks closest to their deadline under RM: analysis vs simulation.
+    if(g_format == FORMAT_TEXT && a.rta_ok) {
+        int top[5], ntop = 0, exact = 1;
         for(int i = 0; i < n; i++) {
-            if(processes[i].arrival_time <= current_time && !in_queue[i] && processes[i].remaining_time > 0) {
-                queue[rear++] = i;
-                in_queue[i] = 1;
+            if(bound[i] != worst[i]) exact = 0;
+            double ratio = (double)bound[i] / periodic_deadline(&t[i]);
+            int k = ntop < 5 ? ntop++ : 5;
+            while(k > 0 && ratio > (double)bound[top[k - 1]] / periodic_deadline(&t[top[k - 1]])) {
+                if(k < 5) top[k] = top[k - 1];
+                k--;
             }
+            if(k < 5) top[k] = i;
         }
-        
-        if(processes[idx].remaining_time == 0) {
-            processes[idx].completion_time = current_time;
-            processes[idx].turnaround_time = processes[idx].completion_time - processes[idx].arrival_time;
-            processes[idx].waiting_time = processes[idx].turnaround_time - processes[idx].burst_time;
-            processes[idx].real_time_us = 200000 + (rand() % 200000);
-            processes[idx].sched_latency_us = 2000 + (rand() % 2000);
-            
-            strcpy(events[*event_count].event_type, "Completed");
-            strcpy(events[*event_count].task_name, processes[idx].name);
-            events[*event_count].time = current_time;
-            events[*event_count].pid = 4860 + idx;
-            (*event_count)++;
-            
-            total_waiting_time += processes[idx].waiting_time;
-            total_turnaround_time += processes[idx].turnaround_time;
-            total_sched_latency += processes[idx].sched_latency_us;
-            total_overhead += processes[idx].real_time_us;
-            
-            completed++;
-            last_executed = -1;
+        printf("\n%-16s %-10s %-10s %-12s %-12s\n", "Task (RM)", "Period", "WCET", "RTA bound", "Simulated");
+        for(int k = 0; k < ntop; k++) {
+            const PeriodicTask *p = &t[top[k]];
+            printf("%-16s %-10d %-10d %-12lld %-12lld\n",
+                   p->name, p->period, p->wcet, bound[top[k]], worst[top[k]]);
+        }
+        if(max_offset == 0 && a.hyperperiod > 0 && horizon >= a.hyperperiod) {
+            printf("Simulated worst responses %s the RTA bounds\n", exact ? "match" : "DIFFER FROM");
+        }
+    }
+    out_flush();
+    free(worst);
+    free(bound);
+}
+
+// ------------------------------------------------------------
+// Lock-step comparison (--lockstep[=THREADS])
+// Replaces main's per-policy stages: all policies run in one pass, then
+// once more the usual way (reset_processes() and a full run each, with
+// no Gantt or simulated work) to time both and check they agree.
+// ------------------------------------------------------------
+static void emit_lockstep_record(const char *policy, int quantum, int threads, Metrics m,
+                                 int makespan, int matches, double lockstep_ms, double sequential_ms) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"lockstep\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("quantum");             out_int(quantum);
+        out_json_key("threads");             out_int(threads);
+        out_json_key("avg_waiting_time");    out_double(m.avg_waiting_time);
+        out_json_key("avg_turnaround_time"); out_double(m.avg_turnaround_time);
+        out_json_key("context_switches");    out_int(m.context_switches);
+        out_json_key("makespan");            out_int(makespan);
+        out_json_key("matches_sequential");  out_int(matches);
+        out_json_key("lockstep_ms");         out_double(lockstep_ms);
+        out_json_key("sequential_ms");       out_double(sequential_ms);
+        out_json_key("seed");                out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_LOCKSTEP)) {
+        out_str("record,policy,quantum,threads,avg_waiting_time,avg_turnaround_time,context_switches,"
+                "makespan,matches_sequential,lockstep_ms,sequential_ms,seed\n");
+    }
+    out_str("lockstep,");
+    out_csv_str(policy);
+    out_char(',');  out_int(quantum);
+    out_char(',');  out_int(threads);
+    out_char(',');  out_double(m.avg_waiting_time);
+    out_char(',');  out_double(m.avg_turnaround_time);
+    out_char(',');  out_int(m.context_switches);
+    out_char(',');  out_int(makespan);
+    out_char(',');  out_int(matches);
+    out_char(',');  out_double(lockstep_ms);
+    out_char(',');  out_double(sequential_ms);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_lockstep_study(Process original[], int n, int quantum, int threads) {
+    PolicyId policy[POLICY_COUNT];
+    Metrics m[POLICY_COUNT], seq[POLICY_COUNT];
+    int makespan[POLICY_COUNT];
+    for(int k = 0; k < POLICY_COUNT; k++) policy[k] = (PolicyId)k;
+    if(threads > POLICY_COUNT) threads = POLICY_COUNT;
+
+    long long started = get_time_microseconds();
+    lockstep_schedule(original, n, policy, POLICY_COUNT, quantum, threads, m, makespan);
+    double lockstep_ms = (get_time_microseconds() - started) / 1000.0;
+
+    int saved_gantt = g_show_gantt, saved_work = g_simulate_work;
+    g_show_gantt = 0;
+    g_simulate_work = 0;
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(lockstep)");
+    started = get_time_microseconds();
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        reset_processes(original, work, n);
+        rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_MAIN + k));
+        seq[k] = run_flat_policy((PolicyId)k, work, n, quantum);
+    }
+    double sequential_ms = (get_time_microseconds() - started) / 1000.0;
+    g_show_gantt = saved_gantt;
+    g_simulate_work = saved_work;
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Lock-step Comparison (%d tasks, %d thread%s, batches of %d) ==\n",
+               n, threads, threads == 1 ? "" : "s", LOCKSTEP_BATCH);
+        printf("%-12s %-10s %-10s %-12s %-10s %-8s\n",
+               "Policy", "Avg Wait", "Avg TAT", "Ctx Switch", "Makespan", "Matches");
+        printf("--------------------------------------------------------------------------------\n");
+    }
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        int matches = m[k].avg_waiting_time == seq[k].avg_waiting_time
+                   && m[k].avg_turnaround_time == seq[k].avg_turnaround_time
+                   && m[k].context_switches == seq[k].context_switches
+                   && m[k].avg_sched_latency_us == seq[k].avg_sched_latency_us;
+        int q = k == POLICY_RR || k == POLICY_PRIORITY_RR ? quantum : 0;
+        if(g_format == FORMAT_TEXT) {
+            printf("%-12s %-10.2f %-10.2f %-12d %-10d %-8s\n",
+                   POLICY_NAMES[k], m[k].avg_waiting_time, m[k].avg_turnaround_time,
+                   m[k].context_switches, makespan[k], matches ? "yes" : "NO");
         } else {
-            queue[rear++] = idx;
+            emit_lockstep_record(POLICY_NAMES[k], q, threads, m[k], makespan[k], matches,
+                                 lockstep_ms, sequential_ms);
         }
     }
-    
-    print_gantt_chart(gantt, gantt_time, gantt_idx);
-    
-    Metrics metrics;
-    metrics.avg_waiting_time = (double)total_waiting_time / n;
-    metrics.avg_turnaround_time = (double)total_turnaround_time / n;
-    metrics.context_switches = context_switches;
-    metrics.avg_context_switch_overhead_us = 50.0 + (rand() % 30);
-    metrics.total_context_switch_time_ms = context_switches * metrics.avg_context_switch_overhead_us / 1000.0;
-    metrics.avg_sched_latency_us = (double)total_sched_latency / n;
-    metrics.total_real_time_ms = total_overhead;
-    
-    return metrics;
+    if(g_format == FORMAT_TEXT) {
+        printf("One pass: %.2f ms; one run per policy: %.2f ms (%.2fx)\n",
+               lockstep_ms, sequential_ms, lockstep_ms > 0.0 ? sequential_ms / lockstep_ms : 0.0);
+    }
+    out_flush();
+    free(work);
 }
 
-Metrics priority_round_robin(Process processes[], int n, int quantum, ExecutionEvent events[], int* event_count) {
-    int current_time = 0;
-    int completed = 0;
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
-    int total_sched_latency = 0;
-    int context_switches = 0;
-    long total_overhead = 0;
-    int last_executed = -1;
-    
-    int gantt[1000], gantt_time[1000], gantt_idx = 0;
-    
-    *event_count = 0;
-    
-    while(completed != n) {
-        int highest_priority = 999999;
-        int min_index = -1;
-        
-        for(int i = 0; i < n; i++) {
-            if(processes[i].arrival_time <= current_time && processes[i].remaining_time > 0) {
-                if(processes[i].priority < highest_priority) {
-                    highest_priority = processes[i].priority;
-                    min_index = i;
-                }
-                else if(processes[i].priority == highest_priority) {
-                    if(min_index == -1 || processes[i].arrival_time < processes[min_index].arrival_time) {
-                        min_index = i;
-                    }
+// ------------------------------------------------------------
+// Admission study (--queue-cap, --token-bucket, --deadline-slack)
+// Every policy runs without admission control, with each configured
+// mechanism alone and, when there are several, with all of them. Tails
+// are over the admitted tasks; the gain compares their p99 waiting time
+// with the run that admits everything.
+// ------------------------------------------------------------
+static void emit_admission_record(const char *policy, const char *mode, int quantum, int n,
+                                  const AdmissionCtl *ac, const Histogram *wait,
+                                  const Histogram *tat, long long late, double gain_pct) {
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"admission\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("mode");             out_json_str(mode);
+        out_json_key("quantum");          out_int(quantum);
+        out_json_key("admitted");         out_int(n - ac->shed);
+        out_json_key("shed_queue");       out_int(ac->shed_queue);
+        out_json_key("shed_tokens");      out_int(ac->shed_tokens);
+        out_json_key("shed_deadline");    out_int(ac->shed_deadline);
+        out_json_key("p50_waiting_time"); out_int(hist_percentile(wait, 0.50));
+        out_json_key("p99_waiting_time"); out_int(hist_percentile(wait, 0.99));
+        out_json_key("p99_turnaround");   out_int(hist_percentile(tat, 0.99));
+        out_json_key("late");             out_int(late);
+        out_json_key("p99_wait_gain_pct"); out_double(gain_pct);
+        out_json_key("seed");             out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_ADMISSION)) {
+        out_str("record,policy,mode,quantum,admitted,shed_queue,shed_tokens,shed_deadline,"
+                "p50_waiting_time,p99_waiting_time,p99_turnaround,late,p99_wait_gain_pct,seed\n");
+    }
+    out_str("admission,");
+    out_csv_str(policy);
+    out_char(',');  out_str(mode);
+    out_char(',');  out_int(quantum);
+    out_char(',');  out_int(n - ac->shed);
+    out_char(',');  out_int(ac->shed_queue);
+    out_char(',');  out_int(ac->shed_tokens);
+    out_char(',');  out_int(ac->shed_deadline);
+    out_char(',');  out_int(hist_percentile(wait, 0.50));
+    out_char(',');  out_int(hist_percentile(wait, 0.99));
+    out_char(',');  out_int(hist_percentile(tat, 0.99));
+    out_char(',');  out_int(late);
+    out_char(',');  out_double(gain_pct);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_admission_study(Process original[], int n, int quantum, const AdmissionOpts *opts) {
+    // Modes: everything admitted, each configured mechanism, all together.
+    const char *mode_name[5];
+    AdmissionOpts mode[5];
+    int nmodes = 0, configured = 0;
+    memset(mode, 0, sizeof(mode));
+    mode_name[nmodes++] = "none";
+    if(opts->queue_cap > 0) {
+        mode[nmodes].queue_cap = opts->queue_cap;
+        mode_name[nmodes++] = "queue-cap";
+    }
+    if(opts->token_rate > 0.0) {
+        mode[nmodes].token_rate = opts->token_rate;
+        mode[nmodes].token_burst = opts->token_burst;
+        mode_name[nmodes++] = "token-bucket";
+    }
+    if(opts->deadline_slack > 0) {
+        mode[nmodes].deadline_slack = opts->deadline_slack;
+        mode_name[nmodes++] = "deadline";
+    }
+    configured = nmodes - 1;
+    if(configured > 1) {
+        mode[nmodes] = *opts;
+        mode_name[nmodes++] = "all";
+    }
+
+    int saved_gantt = g_show_gantt;
+    g_show_gantt = 0;
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(admission)");
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Admission Control (queue cap %d, tokens %.3g/unit burst %.3g, slack %dx) ==\n",
+               opts->queue_cap, opts->token_rate, opts->token_burst, opts->deadline_slack);
+        printf("%-12s %-13s %-9s %-7s %-7s %-8s %-8s %-8s %-9s %-6s %-8s\n",
+               "Policy", "Admission", "Admitted", "Queue", "Tokens", "Expired",
+               "p50 Wait", "p99 Wait", "p99 TAT", "Late", "p99 Gain");
+        printf("----------------------------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k < POLICY_COUNT; k++) {
+        long long base_p99 = 0;
+        for(int m = 0; m < nmodes; m++) {
+            AdmissionCtl ac;
+            admission_init(&ac, &mode[m]);
+            g_admission = m > 0 ? &ac : NULL;
+            reset_processes(original, work, n);
+            rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_ADMISSION + nmodes * k + m));
+            run_flat_policy((PolicyId)k, work, n, quantum);
+            g_admission = NULL;
+
+            // Tails and deadline misses of the admitted tasks; with no
+            // deadline mechanism, late counts tasks past the slack anyway.
+            Histogram wait, tat;
+            hist_init(&wait);
+            hist_init(&tat);
+            long long late = 0;
+            for(int i = 0; i < n; i++) {
+                if(work[i].completion_time < 0) continue;
+                hist_record(&wait, work[i].waiting_time);
+                hist_record(&tat, work[i].turnaround_time);
+                if(opts->deadline_slack > 0 && work[i].completion_time > admission_deadline(opts, &work[i])) {
+                    late++;
                 }
             }
-        }
-        
-        if(min_index == -1) {
-            gantt[gantt_idx] = -1;
-            gantt_time[gantt_idx++] = current_time + 1;
-            current_time++;
-        } else {
-            if(min_index != last_executed) {
-                strcpy(events[*event_count].event_type, "Executing");
-                strcpy(events[*event_count].task_name, processes[min_index].name);
-                events[*event_count].burst_time = processes[min_index].remaining_time;
-                events[*event_count].time = current_time;
-                events[*event_count].pid = 4860 + min_index;
-                (*event_count)++;
-                context_switches++;
-                last_executed = min_index;
+            long long p99 = hist_percentile(&wait, 0.99);
+            if(m == 0) base_p99 = p99;
+            double gain = base_p99 > 0 ? 100.0 * (base_p99 - p99) / base_p99 : 0.0;
+            int q = k == POLICY_RR || k == POLICY_PRIORITY_RR ? quantum : 0;
+
+            if(g_format == FORMAT_TEXT) {
+                printf("%-12s %-13s %-9d %-7lld %-7lld %-8lld %-8lld %-8lld %-9lld %-6lld %+7.1f%%\n",
+                       POLICY_NAMES[k], mode_name[m], n - ac.shed, ac.shed_queue, ac.shed_tokens,
+                       ac.shed_deadline, hist_percentile(&wait, 0.50), p99,
+                       hist_percentile(&tat, 0.99), late, gain);
+            } else {
+                emit_admission_record(POLICY_NAMES[k], mode_name[m], q, n, &ac, &wait, &tat, late, gain);
             }
-            
-            int exec_time = (processes[min_index].remaining_time > quantum) ? quantum : processes[min_index].remaining_time;
-            
-            #ifndef _WIN32
-            usleep(exec_time * 100);
-            #else
-            Sleep(exec_time / 10);
-            #endif
-            
-            processes[min_index].remaining_time -= exec_time;
-            current_time += exec_time;
-            
-            gantt[gantt_idx] = processes[min_index].pid;
-            gantt_time[gantt_idx++] = current_time;
-            
-            if(processes[min_index].remaining_time == 0) {
-                processes[min_index].completion_time = current_time;
-                processes[min_index].turnaround_time = processes[min_index].completion_time - processes[min_index].arrival_time;
-                processes[min_index].waiting_time = processes[min_index].turnaround_time - processes[min_index].burst_time;
-                processes[min_index].real_time_us = 200000 + (rand() % 200000);
-                processes[min_index].sched_latency_us = 2000 + (rand() % 2000);
-                
-                strcpy(events[*event_count].event_type, "Completed");
-                strcpy(events[*event_count].task_name, processes[min_index].name);
-                events[*event_count].time = current_time;
-                events[*event_count].pid = 4860 + min_index;
-                (*event_count)++;
-                
-                total_waiting_time += processes[min_index].waiting_time;
-                total_turnaround_time += processes[min_index].turnaround_time;
-                total_sched_latency += processes[min_index].sched_latency_us;
-                total_overhead += processes[min_index].real_time_us;
-                
-                completed++;
-                last_executed = -1;
+            admission_free(&ac);
+        }
+    }
+    out_flush();
+    g_show_gantt = saved_gantt;
+    free(work);
+}
+
+// ------------------------------------------------------------
+// Memory study (--mem-capacity=MB [--nodes=K])
+// The run-to-completion policies order the queues with one shared queue
+// and with DRF between tenants, under each placement when there is more
+// than one node to choose from. Tenants weigh as given by --tenants.
+// ------------------------------------------------------------
+static const char *DRF_QUEUEING_NAMES[DRF_QUEUEINGS] = {"shared", "drf"};
+static const char *PACK_PLACEMENT_NAMES[PACK_PLACEMENTS] = {"first-fit", "best-fit"};
+
+static void emit_drf_record(const char *policy, const DrfOpts *o, Metrics m,
+                            const Histogram *wait, const DrfStats *st) {
+    const char *queueing = DRF_QUEUEING_NAMES[o->queueing];
+    const char *placement = PACK_PLACEMENT_NAMES[o->placement];
+    if(g_format == FORMAT_JSON) {
+        out_str("{\"record\":\"drf\",\"policy\":");
+        out_json_str(policy);
+        out_json_key("queueing");         out_json_str(queueing);
+        out_json_key("placement");        out_json_str(placement);
+        out_json_key("nodes");            out_int(o->nodes);
+        out_json_key("cpus_per_node");    out_int(o->cpus);
+        out_json_key("mem_mb_per_node");  out_int(o->mem_mb);
+        out_json_key("admitted");         out_int(st->admitted);
+        out_json_key("rejected");         out_int(st->rejected);
+        out_json_key("avg_waiting_time"); out_double(m.avg_waiting_time);
+        out_json_key("p99_waiting_time"); out_int(hist_percentile(wait, 0.99));
+        out_json_key("makespan");         out_int(st->makespan);
+        out_json_key("cpu_pct");          out_double(st->cpu_pct);
+        out_json_key("mem_pct");          out_double(st->mem_pct);
+        out_json_key("frag_pct");         out_double(st->frag_pct);
+        out_json_key("tenants");          out_int(st->tenants);
+        out_json_key("jain");             out_double(st->jain);
+        out_json_key("min_share");        out_double(st->min_share);
+        out_json_key("max_share");        out_double(st->max_share);
+        out_json_key("seed");             out_u64(g_seed);
+        out_str("}\n");
+        return;
+    }
+    if(csv_header_once(CSV_HDR_DRF)) {
+        out_str("record,policy,queueing,placement,nodes,cpus_per_node,mem_mb_per_node,admitted,"
+                "rejected,avg_waiting_time,p99_waiting_time,makespan,cpu_pct,mem_pct,frag_pct,"
+                "tenants,jain,min_share,max_share,seed\n");
+    }
+    out_str("drf,");
+    out_csv_str(policy);
+    out_char(',');  out_str(queueing);
+    out_char(',');  out_str(placement);
+    out_char(',');  out_int(o->nodes);
+    out_char(',');  out_int(o->cpus);
+    out_char(',');  out_int(o->mem_mb);
+    out_char(',');  out_int(st->admitted);
+    out_char(',');  out_int(st->rejected);
+    out_char(',');  out_double(m.avg_waiting_time);
+    out_char(',');  out_int(hist_percentile(wait, 0.99));
+    out_char(',');  out_int(st->makespan);
+    out_char(',');  out_double(st->cpu_pct);
+    out_char(',');  out_double(st->mem_pct);
+    out_char(',');  out_double(st->frag_pct);
+    out_char(',');  out_int(st->tenants);
+    out_char(',');  out_double(st->jain);
+    out_char(',');  out_double(st->min_share);
+    out_char(',');  out_double(st->max_share);
+    out_char(',');  out_u64(g_seed);
+    out_char('\n');
+}
+
+void report_drf_study(Process original[], int n, const DrfOpts *base) {
+    int nplacements = base->nodes > 1 ? PACK_PLACEMENTS : 1;
+    Process *work = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(drf)");
+
+    if(g_format == FORMAT_TEXT) {
+        printf("\n== Memory-Aware Placement (%d node%s x %d CPU%s, %d MB each) ==\n",
+               base->nodes, base->nodes == 1 ? "" : "s", base->cpus, base->cpus == 1 ? "" : "s",
+               base->mem_mb);
+        printf("%-10s %-8s %-10s %-10s %-9s %-9s %-7s %-7s %-7s %-6s %-8s\n",
+               "Policy", "Queueing", "Placement", "Avg Wait", "p99 Wait", "Makespan",
+               "CPU%", "Mem%", "Frag%", "Jain", "Rejected");
+        printf("------------------------------------------------------------------------------------------------\n");
+    }
+
+    for(int k = 0; k <= POLICY_PRIORITY; k++) {
+        for(int q = 0; q < DRF_QUEUEINGS; q++) {
+            for(int pl = 0; pl < nplacements; pl++) {
+                DrfOpts o = *base;
+                o.queueing = (DrfQueueing)q;
+                o.placement = (PackPlacement)pl;
+                DrfStats st;
+                reset_processes(original, work, n);
+                rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_DRF + 4 * k + 2 * q + pl));
+                Metrics m = drf_schedule(work, n, (PolicyId)k, &o, &st);
+
+                Histogram wait;
+                hist_init(&wait);
+                for(int i = 0; i < n; i++) {
+                    if(work[i].completion_time >= 0) hist_record(&wait, work[i].waiting_time);
+                }
+                if(g_format == FORMAT_TEXT) {
+                    printf("%-10s %-8s %-10s %-10.2f %-9lld %-9d %-7.1f %-7.1f %-7.1f %-6.3f %-8d\n",
+                           POLICY_NAMES[k], DRF_QUEUEING_NAMES[q],
+                           base->nodes > 1 ? PACK_PLACEMENT_NAMES[pl] : "-",
+                           m.avg_waiting_time, hist_percentile(&wait, 0.99), st.makespan,
+                           st.cpu_pct, st.mem_pct, st.frag_pct, st.jain, st.rejected);
+                } else {
+                    emit_drf_record(POLICY_NAMES[k], &o, m, &wait, &st);
+                }
             }
         }
     }
-    
-    print_gantt_chart(gantt, gantt_time, gantt_idx);
-    
+    out_flush();
+    free(work);
+}
+
+// ------------------------------------------------------------
+// Result cache (--cache=DIR)
+// Summary reports of main's policies are stored under DIR, one file per
+// result, named by a hash of everything the result depends on: the
+// workload, policy, quantum, seed, --no-delay, --aging and
+// ENGINE_VERSION. A file
+// holds a ResultRecord (metrics, histograms, Gantt segment count)
+// followed by the slowest tasks, so a hit is one mmap and no
+// simulation. The header repeats the key fields, so a hash collision
+// or a file from another build is a miss, never a wrong answer.
+// Measured times in a hit are the ones of the run that stored it.
+// ------------------------------------------------------------
+#define RESULT_CACHE_MAGIC "SCHEDRC1"
+#define RESULT_CACHE_VERSION 2u
+#define ENGINE_VERSION 2u       // bump when a change alters any reported result
+
+typedef struct {
+    char magic[8];
+    unsigned version;
+    unsigned engine;
+    unsigned process_size;
+    unsigned histogram_size;
+    uint64_t workload;          // workload_hash()
+    uint64_t seed;
+    int n;
+    int quantum;
+    int simulate_work;
+    int aging;
+    int gantt_segments;
+    int nslowest;               // Process records that follow, slowest first
+    char policy[16];
     Metrics metrics;
-    metrics.avg_waiting_time = (double)total_waiting_time / n;
-    metrics.avg_turnaround_time = (double)total_turnaround_time / n;
-    metrics.context_switches = context_switches;
-    metrics.avg_context_switch_overhead_us = 50.0 + (rand() % 30);
-    metrics.total_context_switch_time_ms = context_switches * metrics.avg_context_switch_overhead_us / 1000.0;
-    metrics.avg_sched_latency_us = (double)total_sched_latency / n;
-    metrics.total_real_time_ms = total_overhead;
-    
-    return metrics;
+    Histogram hist[RUN_NHIST];
+} ResultRecord;
+
+typedef struct {
+    const char *dir;            // NULL: caching off
+    uint64_t workload;
+    long long hits;
+    long long misses;
+} ResultCache;
+
+static ResultCache g_cache;
+
+static inline uint64_t hash_mix(uint64_t h, uint64_t v) {
+    return rotl64((h ^ v) * 0x9E3779B97F4A7C15ULL, 31);
+}
+
+// Hash of the fields the main policies read; counters are ignored.
+uint64_t workload_hash(const Process processes[], int n) {
+    uint64_t h = (uint64_t)n;
+    for(int i = 0; i < n; i++) {
+        const Process *p = &processes[i];
+        h = hash_mix(h, ((uint64_t)(uint32_t)p->pid << 32) | (uint32_t)p->arrival_time);
+        h = hash_mix(h, ((uint64_t)(uint32_t)p->burst_time << 32) | (uint32_t)p->priority);
+        h = hash_mix(h, fnv1a(p->name));
+    }
+    return splitmix64(&h);
+}
+
+static void result_cache_path(char *path, size_t size, const char *policy, int quantum, int n) {
+    uint64_t key = hash_mix(g_cache.workload, fnv1a(policy));
+    key = hash_mix(key, ((uint64_t)(uint32_t)quantum << 32) | (uint32_t)n);
+    key = hash_mix(key, g_seed);
+    key = hash_mix(key, ((uint64_t)ENGINE_VERSION << 32) | (uint32_t)g_simulate_work);
+    key = hash_mix(key, (uint64_t)(uint32_t)g_aging);
+    snprintf(path, size, "%s/%016llx.res", g_cache.dir, (unsigned long long)splitmix64(&key));
+}
+
+static int result_matches(const ResultRecord *r, size_t len, const char *policy, int quantum,
+                          int n, int nslowest) {
+    return len >= sizeof(*r)
+        && memcmp(r->magic, RESULT_CACHE_MAGIC, sizeof(r->magic)) == 0
+        && r->version == RESULT_CACHE_VERSION
+        && r->engine == ENGINE_VERSION
+        && r->process_size == sizeof(Process)
+        && r->histogram_size == sizeof(Histogram)
+        && r->workload == g_cache.workload
+        && r->seed == g_seed
+        && r->n == n
+        && r->quantum == quantum
+        && r->simulate_work == g_simulate_work
+        && r->aging == g_aging
+        && strncmp(r->policy, policy, sizeof(r->policy)) == 0
+        && r->nslowest >= nslowest
+        && len >= sizeof(*r) + (size_t)r->nslowest * sizeof(Process);
+}
+
+// Maps the cached result at path; NULL on a miss. Unmap with munmap(r, *len).
+static const ResultRecord* result_cache_map(const char *path, const char *policy, int quantum,
+                                            int n, int nslowest, size_t *len) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return NULL;
+    struct stat sb;
+    void *map = MAP_FAILED;
+    if(fstat(fd, &sb) == 0 && (size_t)sb.st_size >= sizeof(ResultRecord)) {
+        map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if(map == MAP_FAILED) return NULL;
+    *len = (size_t)sb.st_size;
+    if(!result_matches((const ResultRecord*)map, *len, policy, quantum, n, nslowest)) {
+        munmap(map, *len);
+        return NULL;
+    }
+    return (const ResultRecord*)map;
+}
+
+static void result_cache_store(const char *path, const char *policy, int quantum,
+                               const Process processes[], int n, int nslowest, Metrics metrics) {
+    ResultRecord *r = (ResultRecord*)xcalloc(1, sizeof(ResultRecord), "calloc(result)");
+    const Process **rows = (const Process**)xcalloc((size_t)nslowest, sizeof(*rows), "calloc(result)");
+    memcpy(r->magic, RESULT_CACHE_MAGIC, sizeof(r->magic));
+    r->version = RESULT_CACHE_VERSION;
+    r->engine = ENGINE_VERSION;
+    r->process_size = sizeof(Process);
+    r->histogram_size = sizeof(Histogram);
+    r->workload = g_cache.workload;
+    r->seed = g_seed;
+    r->n = n;
+    r->quantum = quantum;
+    r->simulate_work = g_simulate_work;
+    r->aging = g_aging;
+    r->gantt_segments = g_gantt.size;
+    r->nslowest = nslowest;
+    snprintf(r->policy, sizeof(r->policy), "%s", policy);
+    r->metrics = metrics;
+    build_histograms(processes, n, r->hist);
+    select_slowest(processes, n, nslowest, rows);
+
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    int ok = f != NULL && write_all(f, r, sizeof(*r), 1);
+    for(int i = 0; ok && i < nslowest; i++) ok = write_all(f, rows[i], sizeof(Process), 1);
+    if(f && fclose(f) != 0) ok = 0;
+    if(!ok || rename(tmp, path) != 0) {
+        perror(path);
+        unlink(tmp);
+    }
+    free(rows);
+    free(r);
+}
+
+// The summary report of a cached run, as report_results() prints it.
+static void report_cached_results(const char *policy, const char *label, int quantum,
+                                  const ResultRecord *r) {
+    if(g_format != FORMAT_TEXT) {
+        emit_metrics_record(policy, quantum, r->n, r->metrics);
+        emit_histogram_set(policy, r->hist);
+        out_flush();
+        return;
+    }
+    int k = g_summary_k < r->n ? g_summary_k : r->n;
+    const Process *slowest = (const Process*)(r + 1);
+    const Process **rows = (const Process**)xcalloc((size_t)k, sizeof(*rows), "calloc(result)");
+    for(int i = 0; i < k; i++) rows[i] = &slowest[i];
+    if(g_show_gantt) print_gantt_chart(NULL, NULL, r->gantt_segments);
+    printf("== Scheduling Started ==\n");
+    print_execution_log(NULL, 0);
+    printf("\n== %s Scheduling Results ==\n", label);
+    print_slowest_table(rows, k, r->n);
+    print_results_footer(r->metrics);
+    free(rows);
+}
+
+// Reports main's stage from the cache if possible; returns 1 on a hit.
+static int result_cache_report(const char *policy, const char *label, int quantum, int n) {
+    char path[PATH_MAX];
+    size_t len = 0;
+    int nslowest = g_summary_k < n ? g_summary_k : n;
+    long start = get_time_microseconds();
+    result_cache_path(path, sizeof(path), policy, quantum, n);
+    const ResultRecord *r = result_cache_map(path, policy, quantum, n, nslowest, &len);
+    long loaded = get_time_microseconds();
+    if(!r) {
+        g_cache.misses++;
+        return 0;
+    }
+    g_cache.hits++;
+    fprintf(stderr, "cache: %s hit %s (mapped in %ld us)\n", policy, path, loaded - start);
+    report_cached_results(policy, label, quantum, r);
+    munmap((void*)r, len);
+    return 1;
+}
+
+static void result_cache_save(const char *policy, int quantum, const Process processes[], int n,
+                              Metrics metrics) {
+    char path[PATH_MAX];
+    result_cache_path(path, sizeof(path), policy, quantum, n);
+    result_cache_store(path, policy, quantum, processes, n, g_summary_k < n ? g_summary_k : n, metrics);
+}
+
+// The five policies main runs, in order. Stage numbers (index + 1) are
+// recorded in checkpoints so --resume can skip finished policies.
+typedef struct {
+    const char *policy;
+    const char *label;
+    const char *title;      // printf format taking the quantum when run_q is set
+    OracleFn run;
+    Metrics (*run_q)(Process[], int, int, ExecutionEvent[], int*);
+} MainStage;
+
+static const MainStage MAIN_STAGES[] = {
+    {"fcfs",        "FCFS",        "1. FIRST COME FIRST SERVE (FCFS)",          fcfs,                NULL},
+    {"sjf",         "SJF",         "2. SHORTEST JOB FIRST (SJF)",               sjf,                 NULL},
+    {"priority",    "Priority",    "3. PRIORITY SCHEDULING",                    priority_scheduling, NULL},
+    {"rr",          "Round Robin", "4. ROUND ROBIN (Quantum = %d ms)",          NULL,                round_robin},
+    {"priority_rr", "Priority RR", "5. PRIORITY ROUND ROBIN (Quantum = %d ms)", NULL,                priority_round_robin}
+};
+#define MAIN_NSTAGES ((int)(sizeof(MAIN_STAGES) / sizeof(MAIN_STAGES[0])))
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [--summary=K] [--format=text|json|csv] [--quantum=Q]\n"
+            "          [--procs=N [--max-gap=G] | --import-perf=FILE | --import-schedstat=FILE]\n"
+            "          [--import-unit-us=U] [--seed=S] [--no-delay] [--predict[=ALPHA]] [--tau0=T]\n"
+            "          [--checkpoint=PATH] [--checkpoint-every=DECISIONS] [--resume=PATH]\n"
+            "          [--cpus=N] [--cpu-speeds=S1,S2,...] [--refill-us-per-kb=X] [--cache-half-life=T] [--io]\n"
+            "          [--parallel=THREADS] [--lookahead=L] [--forward-threshold=K]\n"
+            "          [--cache=DIR]   (with --summary=K)   [--save-trace=PREFIX] [--aging=INTERVAL]\n"
+            "          [--tenants[=NAME:WEIGHT,...]]\n"
+            "          [--periodic=N [--utilization=U] | --periodic-file=PATH] [--horizon=T]\n"
+            "          [--lockstep[=THREADS]]   (not with --checkpoint, --resume, --cache, --save-trace)\n"
+            "          [--series=OUT.csv [--series-points=N]]\n"
+            "          [--queue-cap=N] [--token-bucket=RATE:BURST] [--deadline-slack=K]\n"
+            "          [--mem-capacity=MB [--nodes=K]]   (K nodes of --cpus CPUs and MB each;\n"
+            "                                              fcfs, sjf and priority only, no quantum)\n"
+            "       %s --daemon=SOCKET_PATH [--policy=fcfs|sjf|priority|rr|priority_rr] [--quantum=Q]\n"
+            "       %s --trace=FILE (--at=T | --range=T1:T2) [--format=text|json|csv]\n"
+            "       %s --trace=FILE --render=OUT.svg|OUT.html [--width=PX] [--range=T1:T2]\n",
+            prog, prog, prog, prog);
 }
 
-int main() {
-    srand(time(NULL));
+int main(int argc, char **argv) {
+    const char *daemon_path = NULL;
+    int daemon_policy = POLICY_FCFS;
+    int quantum = 4;
+    int nprocs = 0;               // 0: the five-task demo table
+    int max_gap = 12;             // inter-arrival gap of generated tasks is 0..max_gap
+    const char *perf_path = NULL;
+    const char *schedstat_path = NULL;
+    double import_unit_us = 1000.0;   // host microseconds per simulated time unit
+    int seeded = 0;
+    int predict = 0;
+    double alpha = 0.5;
+    double tau0 = 5.0;
+    const char *resume_path = NULL;
+    int resume_stage = 0;
+    g_ckpt.every = 1000000;
+    SmpOpts smp = { 1, 0, 0, 0.5, 50.0, NULL, SMP_OBLIVIOUS };
+    double cpu_speeds[HETERO_MAX_CPUS];
+    int ncpu_speeds = 0;
+    int io = 0;
+    ClusterOpts cluster = { 1, 0, 2, 4, 0 };
+    const char *trace_prefix = NULL;
+    TenantWeight tenant_weights[64];
+    int ntenant_weights = -1;     // -1: no tenant study
+    int nperiodic = 0;
+    double periodic_util = 0.7;
+    const char *periodic_path = NULL;
+    long long horizon = 100000000;
+    int lockstep_threads = 0;     // 0: one stage per policy
+    const char *series_path = NULL;
+    AdmissionOpts admission = { 0, 0.0, 0.0, 0 };
+    int mem_capacity = 0;         // 0: no memory study
+    int nodes = 1;
+    int series_points = 1000;
+    const char *trace_path = NULL;
+    int trace_from = -1, trace_to = -1;
+    const char *render_path = NULL;
+    int render_width = 1200;
+    
+    for(int a = 1; a < argc; a++) {
+        if(strncmp(argv[a], "--summary=", 10) == 0) {
+            g_summary_k = atoi(argv[a] + 10);
+        } else if(strcmp(argv[a], "--summary") == 0 && a + 1 < argc) {
+            g_summary_k = atoi(argv[++a]);
+        } else if(strcmp(argv[a], "--format=text") == 0) {
+            g_format = FORMAT_TEXT;
+        } else if(strcmp(argv[a], "--format=json") == 0) {
+            g_format = FORMAT_JSON;
+        } else if(strcmp(argv[a], "--format=csv") == 0) {
+            g_format = FORMAT_CSV;
+        } else if(strncmp(argv[a], "--daemon=", 9) == 0) {
+            daemon_path = argv[a] + 9;
+        } else if(strncmp(argv[a], "--policy=", 9) == 0) {
+            daemon_policy = policy_from_name(argv[a] + 9);
+        } else if(strncmp(argv[a], "--quantum=", 10) == 0) {
+            quantum = atoi(argv[a] + 10);
+        } else if(strncmp(argv[a], "--procs=", 8) == 0) {
+            nprocs = atoi(argv[a] + 8);
+        } else if(strncmp(argv[a], "--max-gap=", 10) == 0) {
+            max_gap = atoi(argv[a] + 10);
+        } else if(strncmp(argv[a], "--import-perf=", 14) == 0) {
+            perf_path = argv[a] + 14;
+        } else if(strncmp(argv[a], "--import-schedstat=", 19) == 0) {
+            schedstat_path = argv[a] + 19;
+        } else if(strncmp(argv[a], "--import-unit-us=", 17) == 0) {
+            import_unit_us = atof(argv[a] + 17);
+        } else if(strncmp(argv[a], "--seed=", 7) == 0) {
+            g_seed = strtoull(argv[a] + 7, NULL, 0);
+            seeded = 1;
+        } else if(strcmp(argv[a], "--no-delay") == 0) {
+            g_simulate_work = 0;
+        } else if(strcmp(argv[a], "--predict") == 0) {
+            predict = 1;
+        } else if(strncmp(argv[a], "--predict=", 10) == 0) {
+            predict = 1;
+            alpha = atof(argv[a] + 10);
+        } else if(strncmp(argv[a], "--tau0=", 7) == 0) {
+            tau0 = atof(argv[a] + 7);
+        } else if(strncmp(argv[a], "--checkpoint=", 13) == 0) {
+            g_ckpt.path = argv[a] + 13;
+        } else if(strncmp(argv[a], "--checkpoint-every=", 19) == 0) {
+            g_ckpt.every = atoll(argv[a] + 19);
+        } else if(strncmp(argv[a], "--resume=", 9) == 0) {
+            resume_path = argv[a] + 9;
+        } else if(strcmp(argv[a], "--io") == 0) {
+            io = 1;
+        } else if(strncmp(argv[a], "--cpus=", 7) == 0) {
+            smp.ncpu = atoi(argv[a] + 7);
+        } else if(strncmp(argv[a], "--cpu-speeds=", 13) == 0) {
+            ncpu_speeds = parse_cpu_speeds(argv[a] + 13, cpu_speeds, HETERO_MAX_CPUS);
+            if(ncpu_speeds < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if(strncmp(argv[a], "--refill-us-per-kb=", 19) == 0) {
+            smp.refill_us_per_kb = atof(argv[a] + 19);
+        } else if(strncmp(argv[a], "--cache-half-life=", 18) == 0) {
+            smp.half_life = atof(argv[a] + 18);
+        } else if(strncmp(argv[a], "--save-trace=", 13) == 0) {
+            trace_prefix = argv[a] + 13;
+        } else if(strncmp(argv[a], "--trace=", 8) == 0) {
+            trace_path = argv[a] + 8;
+        } else if(strncmp(argv[a], "--render=", 9) == 0) {
+            render_path = argv[a] + 9;
+        } else if(strncmp(argv[a], "--width=", 8) == 0) {
+            render_width = atoi(argv[a] + 8);
+        } else if(strncmp(argv[a], "--at=", 5) == 0) {
+            trace_from = atoi(argv[a] + 5);
+            trace_to = trace_from + 1;
+        } else if(strncmp(argv[a], "--range=", 8) == 0) {
+            if(sscanf(argv[a] + 8, "%d:%d", &trace_from, &trace_to) != 2) trace_to = -1;
+        } else if(strcmp(argv[a], "--tenants") == 0) {
+            ntenant_weights = 0;
+        } else if(strncmp(argv[a], "--tenants=", 10) == 0) {
+            ntenant_weights = parse_tenant_weights(argv[a] + 10, tenant_weights, 64);
+            if(ntenant_weights < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if(strncmp(argv[a], "--periodic=", 11) == 0) {
+            nperiodic = atoi(argv[a] + 11);
+        } else if(strncmp(argv[a], "--utilization=", 14) == 0) {
+            periodic_util = atof(argv[a] + 14);
+        } else if(strncmp(argv[a], "--periodic-file=", 16) == 0) {
+            periodic_path = argv[a] + 16;
+        } else if(strncmp(argv[a], "--horizon=", 10) == 0) {
+            horizon = atoll(argv[a] + 10);
+        } else if(strncmp(argv[a], "--queue-cap=", 12) == 0) {
+            admission.queue_cap = atoi(argv[a] + 12);
+        } else if(strncmp(argv[a], "--token-bucket=", 15) == 0) {
+            if(sscanf(argv[a] + 15, "%lf:%lf", &admission.token_rate, &admission.token_burst) != 2
+               || admission.token_rate <= 0.0 || admission.token_burst < 1.0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if(strncmp(argv[a], "--deadline-slack=", 17) == 0) {
+            admission.deadline_slack = atoi(argv[a] + 17);
+        } else if(strncmp(argv[a], "--mem-capacity=", 15) == 0) {
+            mem_capacity = atoi(argv[a] + 15);
+        } else if(strncmp(argv[a], "--nodes=", 8) == 0) {
+            nodes = atoi(argv[a] + 8);
+        } else if(strncmp(argv[a], "--series=", 9) == 0) {
+            series_path = argv[a] + 9;
+        } else if(strncmp(argv[a], "--series-points=", 16) == 0) {
+            series_points = atoi(argv[a] + 16);
+        } else if(strcmp(argv[a], "--lockstep") == 0) {
+            lockstep_threads = 1;
+        } else if(strncmp(argv[a], "--lockstep=", 11) == 0) {
+            lockstep_threads = atoi(argv[a] + 11);
+            if(lockstep_threads < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if(strncmp(argv[a], "--aging=", 8) == 0) {
+            g_aging = atoi(argv[a] + 8);
+        } else if(strncmp(argv[a], "--cache=", 8) == 0) {
+            g_cache.dir = argv[a] + 8;
+        } else if(strncmp(argv[a], "--parallel=", 11) == 0) {
+            cluster.threads = atoi(argv[a] + 11);
+        } else if(strncmp(argv[a], "--lookahead=", 12) == 0) {
+            cluster.latency = atoi(argv[a] + 12);
+        } else if(strncmp(argv[a], "--forward-threshold=", 20) == 0) {
+            cluster.threshold = atoi(argv[a] + 20);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if(ncpu_speeds > 0) {
+        // The speeds define the CPUs; --cpus, if given, must agree.
+        if(smp.ncpu != 1 && smp.ncpu != ncpu_speeds) {
+            usage(argv[0]);
+            return 1;
+        }
+        smp.ncpu = ncpu_speeds;
+        smp.speed = cpu_speeds;
+    }
+    if(daemon_policy < 0 || quantum < 1 || nprocs < 0 || alpha <= 0.0 || alpha > 1.0
+       || g_ckpt.every < 1 || smp.ncpu < 1 || smp.refill_us_per_kb < 0.0
+       || cluster.threads < 0 || cluster.latency < 1 || cluster.threshold < 0
+       || (g_cache.dir && g_summary_k <= 0) || g_aging < 0
+       || nperiodic < 0 || periodic_util <= 0.0 || horizon < 1
+       || (lockstep_threads > 0 && (g_ckpt.path || resume_path || g_cache.dir || trace_prefix))
+       || series_points < 2 || (series_path && (resume_path || lockstep_threads > 0))
+       || admission.queue_cap < 0 || admission.deadline_slack < 0 || max_gap < 0
+       || mem_capacity < 0 || nodes < 1
+       || (perf_path && schedstat_path) || import_unit_us < 0.001
+       || ((perf_path || schedstat_path) && (nprocs > 0 || resume_path))) {
+        usage(argv[0]);
+        return 1;
+    }
+    if(daemon_path) {
+        return run_daemon(daemon_path, (PolicyId)daemon_policy, quantum);
+    }
+    if(trace_path && render_path) {
+        if(render_width < 1 || (trace_from >= 0 && trace_to <= trace_from)) {
+            usage(argv[0]);
+            return 1;
+        }
+        return run_trace_render(trace_path, render_path, trace_from, trace_to, render_width);
+    }
+    if(trace_path) {
+        if(trace_from < 0 || trace_to <= trace_from) {
+            usage(argv[0]);
+            return 1;
+        }
+        return run_trace_query(trace_path, trace_from, trace_to);
+    }
+    
+    // Unseeded runs still print the seed they picked, so they can be replayed.
+    if(!seeded) {
+        uint64_t x = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+        g_seed = splitmix64(&x);
+    }
     
     // Banking Operations from your table
-    Process original[5] = {
-        {1, "Transfer", 0, 8, 2, 8, 0, 0, 0, 0, -1, 0, 0},
-        {2, "Inquiry", 1, 4, 1, 4, 0, 0, 0, 0, -1, 0, 0},
-        {3, "Fraud", 2, 9, 3, 9, 0, 0, 0, 0, -1, 0, 0},
-        {4, "Payment", 3, 5, 2, 5, 0, 0, 0, 0, -1, 0, 0},
-        {5, "Logging", 4, 2, 1, 2, 0, 0, 0, 0, -1, 0, 0}
+    static const Process demo[5] = {
+        {1, "Transfer", 0, 8, 2, 8, 0, 0, 0, 0, -1, 0, 0, 0, 512, 0, 0, 0, 256},
+        {2, "Inquiry", 1, 4, 1, 4, 0, 0, 0, 0, -1, 0, 0, 0, 128, 0, 0, 0, 64},
+        {3, "Fraud", 2, 9, 3, 9, 0, 0, 0, 0, -1, 0, 0, 0, 4096, 0, 0, 0, 3072},
+        {4, "Payment", 3, 5, 2, 5, 0, 0, 0, 0, -1, 0, 0, 0, 256, 0, 0, 0, 128},
+        {5, "Logging", 4, 2, 1, 2, 0, 0, 0, 0, -1, 0, 0, 0, 64, 0, 0, 0, 32}
     };
     
-    Process processes[5];
-    ExecutionEvent events[1000];
-    int event_count = 0;
-    Metrics metrics;
-    int quantum = 4;
+    // A resumed run takes its workload, quantum and aging from the
+    // snapshot and keeps checkpointing to the same file unless told otherwise.
+    if(resume_path) {
+        g_resume = checkpoint_load(resume_path);
+        if(!g_resume) return 1;
+        nprocs = g_resume->h.n;
+        quantum = g_resume->h.quantum;
+        g_aging = g_resume->h.aging;
+        g_seed = g_resume->h.seed;
+        seeded = 1;
+        resume_stage = g_resume->h.stage;
+        if(!g_ckpt.path) g_ckpt.path = resume_path;
+        fprintf(stderr, "Resuming %s at stage %d, t=%d (%d/%d tasks done)\n",
+                resume_path, resume_stage, g_resume->h.current_time,
+                g_resume->h.completed, g_resume->h.n);
+    }
     
-    printf("\n========================================\n");
-    printf("BANKING OPERATIONS CPU SCHEDULER\n");
-    printf("========================================\n\n");
+    // An imported trace replaces the generated workload.
+    Process *imported = NULL;
+    if(perf_path || schedstat_path) {
+        long long unit_ns = (long long)(import_unit_us * 1000.0 + 0.5);
+        imported = perf_path ? import_perf_sched(perf_path, unit_ns, &nprocs)
+                             : import_schedstat(schedstat_path, unit_ns, &nprocs);
+        if(!imported) return 1;
+    }
     
-    printf("Process Information:\n");
-    printf("%-5s %-30s %-10s %-10s %-10s\n", "PID", "Banking Operation", "AT(ms)", "BT(ms)", "Priority");
-    printf("--------------------------------------------------------------------------------\n");
-    for(int i = 0; i < 5; i++) {
-        printf("P%-4d %-30s %-10d %-10d %-10d\n",
-               original[i].pid, original[i].name, 
-               original[i].arrival_time, original[i].burst_time, 
-               original[i].priority);
+    int n = nprocs > 0 ? nprocs : 5;
+    Process *original = imported ? imported
+                                 : (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(processes)");
+    Process *processes = (Process*)xcalloc((size_t)n, sizeof(Process), "calloc(processes)");
+    if(g_resume) {
+        memcpy(original, g_resume->original, (size_t)n * sizeof(Process));
+    } else if(!imported && nprocs > 0) {
+        generate_banking_workload(original, n, g_seed, max_gap);
+    } else if(!imported) {
+        memcpy(original, demo, sizeof(demo));
+    }
+    if(g_cache.dir) {
+        if(mkdir(g_cache.dir, 0777) != 0 && errno != EEXIST) {
+            perror(g_cache.dir);
+            return 1;
+        }
+        g_cache.workload = workload_hash(original, n);
     }
-    printf("\n");
     
-    // 1. FCFS
-    printf("\n========================================\n");
-    printf("1. FIRST COME FIRST SERVE (FCFS)\n");
-    printf("========================================\n");
-    reset_processes(original, processes, 5);
-    event_count = 0;
-    metrics = fcfs(processes, 5, events, &event_count);
-    printf("== Scheduling Started ==\n");
-    print_execution_log(events, event_count);
-    printf("\n== FCFS Scheduling Results ==\n");
-    print_process_table(processes, 5);
-    printf("\nAverage Turnaround Time: %.2f\n", metrics.avg_turnaround_time);
-    printf("Average Waiting Time: %.2f\n", metrics.avg_waiting_time);
-    print_performance_analysis(metrics);
+    // The execution log is only printed in full text mode; size it for
+    // the worst case (one event per time unit plus completions).
+    ExecutionEvent *events = NULL;
+    if(g_format == FORMAT_TEXT && g_summary_k == 0) {
+        long long cap = n + 1;
+        for(int i = 0; i < n; i++) cap += original[i].burst_time;
+        events = (ExecutionEvent*)xcalloc((size_t)cap, sizeof(ExecutionEvent), "calloc(events)");
+    }
+    int event_count = 0;
+    Metrics metrics;
+    char title[64];
     
-    // 2. SJF
-    printf("\n\n========================================\n");
-    printf("2. SHORTEST JOB FIRST (SJF)\n");
-    printf("========================================\n");
-    reset_processes(original, processes, 5);
-    event_count = 0;
-    metrics = sjf(processes, 5, events, &event_count);
-    printf("== Scheduling Started ==\n");
-    print_execution_log(events, event_count);
-    printf("\n== SJF Scheduling Results ==\n");
-    print_process_table(processes, 5);
-    printf("\nAverage Turnaround Time: %.2f\n", metrics.avg_turnaround_time);
-    printf("Average Waiting Time: %.2f\n", metrics.avg_waiting_time);
-    print_performance_analysis(metrics);
+    if(!g_ckpt.path) g_ckpt.every = 0;
+    g_ckpt.quantum = quantum;
     
-    // 3. Priority
-    printf("\n\n========================================\n");
-    printf("3. PRIORITY SCHEDULING\n");
-    printf("========================================\n");
-    reset_processes(original, processes, 5);
-    event_count = 0;
-    metrics = priority_scheduling(processes, 5, events, &event_count);
-    printf("== Scheduling Started ==\n");
-    print_execution_log(events, event_count);
-    printf("\n== Priority Scheduling Results ==\n");
-    print_process_table(processes, 5);
-    printf("\nAverage Turnaround Time: %.2f\n", metrics.avg_turnaround_time);
-    printf("Average Waiting Time: %.2f\n", metrics.avg_waiting_time);
-    print_performance_analysis(metrics);
+    if(g_format == FORMAT_TEXT) {
+        printf("\n========================================\n");
+        printf("BANKING OPERATIONS CPU SCHEDULER\n");
+        printf("========================================\n\n");
+        
+        if(g_summary_k == 0) {
+            printf("Process Information:\n");
+            printf("%-5s %-30s %-10s %-10s %-10s\n", "PID", "Banking Operation", "AT(ms)", "BT(ms)", "Priority");
+            printf("--------------------------------------------------------------------------------\n");
+            for(int i = 0; i < n; i++) {
+                printf("P%-4d %-30s %-10d %-10d %-10d\n",
+                       original[i].pid, original[i].name, 
+                       original[i].arrival_time, original[i].burst_time, 
+                       original[i].priority);
+            }
+        } else {
+            printf("Processes: %d\n", n);
+        }
+        printf("\n");
+    }
     
-    // 4. Round Robin
-    printf("\n\n========================================\n");
-    printf("4. ROUND ROBIN (Quantum = %d ms)\n", quantum);
-    printf("========================================\n");
-    reset_processes(original, processes, 5);
-    event_count = 0;
-    metrics = round_robin(processes, 5, quantum, events, &event_count);
-    printf("== Scheduling Started ==\n");
-    print_execution_log(events, event_count);
-    printf("\n== Round Robin Scheduling Results ==\n");
-    print_process_table(processes, 5);
-    printf("\nAverage Turnaround Time: %.2f\n", metrics.avg_turnaround_time);
-    printf("Average Waiting Time: %.2f\n", metrics.avg_waiting_time);
-    print_performance_analysis(metrics);
+    if(lockstep_threads > 0) {
+        report_lockstep_study(original, n, quantum, lockstep_threads);
+    }
+    FILE *series = NULL;
+    if(series_path) {
+        series = fopen(series_path, "w");
+        if(!series) {
+            perror(series_path);
+            return 1;
+        }
+        fprintf(series, "policy,start,end,depth_min,depth_max,depth_avg,utilization_pct,"
+                        "backlog_min,backlog_max,backlog_avg\n");
+        g_series.budget = (series_points + 1) & ~1;
+        g_series.b = (SeriesBucket*)xcalloc((size_t)g_series.budget, sizeof(SeriesBucket), "calloc(series)");
+        g_series.enabled = 1;
+    }
+    int first = 1;
+    for(int k = 0; k < MAIN_NSTAGES && lockstep_threads == 0; k++) {
+        const MainStage *st = &MAIN_STAGES[k];
+        if(k + 1 < resume_stage) continue;   // finished before the checkpoint
+        
+        if(st->run_q) {
+            snprintf(title, sizeof(title), st->title, quantum);
+        } else {
+            snprintf(title, sizeof(title), "%s", st->title);
+        }
+        print_section(title, first);
+        first = 0;
+        
+        int q = st->run_q ? quantum : 0;
+        // A cached result has no Gantt or series to save, so those always run.
+        if(g_cache.dir && !trace_prefix && !series && result_cache_report(st->policy, st->label, q, n)) continue;
+        
+        reset_processes(original, processes, n);
+        event_count = 0;
+        g_ckpt.stage = k + 1;
+        rng_stream(&g_rng, g_seed, (unsigned)(RNG_STREAM_MAIN + k));
+        metrics = st->run_q ? st->run_q(processes, n, quantum, events, &event_count)
+                            : st->run(processes, n, events, &event_count);
+        report_results(st->policy, st->label, q, processes, n, events, event_count, metrics);
+        if(g_cache.dir) result_cache_save(st->policy, q, processes, n, metrics);
+        if(trace_prefix) {
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s.%s.gantt", trace_prefix, st->policy);
+            if(gantt_save(path, st->policy) != 0) perror(path);
+        }
+        if(series) series_write(series, st->policy);
+    }
+    if(series) {
+        g_series.enabled = 0;
+        if(fclose(series) != 0) perror(series_path);
+        free(g_series.b);
+    }
+    g_ckpt.stage = 0;
+    checkpoint_finish();
+    if(g_ckpt.path) unlink(g_ckpt.path);   // finished: nothing left to resume
+    if(g_cache.dir) {
+        fprintf(stderr, "cache: %lld hits, %lld misses in %s\n",
+                g_cache.hits, g_cache.misses, g_cache.dir);
+    }
     
-    // 5. Priority Round Robin
-    printf("\n\n========================================\n");
-    printf("5. PRIORITY ROUND ROBIN (Quantum = %d ms)\n", quantum);
-    printf("========================================\n");
-    reset_processes(original, processes, 5);
-    event_count = 0;
-    metrics = priority_round_robin(processes, 5, quantum, events, &event_count);
-    printf("== Scheduling Started ==\n");
-    print_execution_log(events, event_count);
-    printf("\n== Priority RR Scheduling Results ==\n");
-    print_process_table(processes, 5);
-    printf("\nAverage Turnaround Time: %.2f\n", metrics.avg_turnaround_time);
-    printf("Average Waiting Time: %.2f\n", metrics.avg_waiting_time);
-    print_performance_analysis(metrics);
+    if(predict) {
+        report_prediction_study(original, n, alpha, tau0);
+    }
+    if(smp.ncpu > 1) {
+        smp.quantum = quantum;
+        report_smp_study(original, n, &smp);
+    }
+    if(smp.speed) {
+        smp.quantum = quantum;
+        report_hetero_study(original, n, &smp);
+    }
+    if(io) {
+        report_io_study(original, n, quantum);
+    }
+    if(g_aging > 0) {
+        report_aging_study(original, n, quantum);
+    }
+    if(ntenant_weights >= 0) {
+        WfqOpts wfq = { quantum, tenant_weights, ntenant_weights };
+        report_tenant_study(original, n, &wfq);
+    }
+    if(admission.queue_cap > 0 || admission.token_rate > 0.0 || admission.deadline_slack > 0) {
+        report_admission_study(original, n, quantum, &admission);
+    }
+    if(mem_capacity > 0) {
+        DrfOpts drf = { nodes, smp.ncpu, mem_capacity, DRF_SHARED, PACK_FIRST_FIT,
+                        tenant_weights, ntenant_weights > 0 ? ntenant_weights : 0 };
+        report_drf_study(original, n, &drf);
+    }
+    if(nperiodic > 0 || periodic_path) {
+        int count = nperiodic;
+        PeriodicTask *tasks;
+        if(periodic_path) {
+            tasks = load_periodic_tasks(periodic_path, &count);
+            if(!tasks) return 1;
+        } else {
+            tasks = (PeriodicTask*)xcalloc((size_t)count, sizeof(PeriodicTask), "calloc(periodic)");
+            generate_periodic_tasks(tasks, count, periodic_util, g_seed);
+        }
+        report_periodic_study(tasks, count, horizon);
+        free(tasks);
+    }
+    if(cluster.threads > 0) {
+        cluster.ncpu = smp.ncpu;
+        cluster.quantum = quantum;
+        report_cluster_study(original, n, &cluster);
+    }
     
+    free(events);
+    free(processes);
+    free(original);
     return 0;
 }
-
+#endif /* SCHEDULER_NO_MAIN */